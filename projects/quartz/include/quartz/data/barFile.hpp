@@ -0,0 +1,99 @@
+#pragma once
+
+#include "pch.hpp"
+
+namespace Quartz {
+    // Columnar bar file (.qzb). A fixed size header is followed by one array per column, each
+    // starting on a 64 byte boundary so it can be read straight out of a mapping:
+    //
+    //   BarFileHeader
+    //   int64_t timestamps[rowCount]
+    //   double  open[rowCount], high[rowCount], low[rowCount], close[rowCount], volume[rowCount]
+    //
+    // Everything is stored in the host's byte order, which is little endian on every supported target.
+    constexpr char BAR_FILE_MAGIC[8] = { 'Q', 'Z', 'B', 'A', 'R', 'S', '\0', '\0' };
+    constexpr uint32_t BAR_FILE_VERSION = 1;
+    constexpr uint64_t BAR_FILE_ALIGNMENT = 64;
+
+    enum class BarColumn : uint32_t {
+        Open,
+        High,
+        Low,
+        Close,
+        Volume,
+
+        COUNT
+    };
+
+    const char* barColumnName(BarColumn column);
+
+    struct BarFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        // Null terminated
+        char symbol[32];
+        char interval[16];
+        uint64_t rowCount;
+        // Byte offsets from the start of the file
+        uint64_t timestampOffset;
+        uint64_t columnOffsets[static_cast<size_t>(BarColumn::COUNT)];
+    };
+
+    static_assert(sizeof(BarFileHeader) <= BAR_FILE_ALIGNMENT * 2, "The bar file header is expected to stay small");
+
+    // Read only view of one column, valid while the BarFile that handed it out is alive
+    template <typename T>
+    struct ColumnSpan {
+        const T* data = nullptr;
+        uint64_t size = 0;
+
+        const T& operator[](uint64_t index) const { return data[index]; }
+        const T* begin() const { return data; }
+        const T* end() const { return data + size; }
+    };
+
+    // Bars held in memory, the input to writeBarFile()
+    struct BarTable {
+        std::string symbol;
+        std::string interval;
+        std::vector<int64_t> timestamps;
+        std::vector<double> columns[static_cast<size_t>(BarColumn::COUNT)];
+
+        std::vector<double>& column(BarColumn column) { return columns[static_cast<size_t>(column)]; }
+    };
+
+    void writeBarFile(const std::string& path, const BarTable& table);
+
+    // A bar file mapped read only. Opening only validates the header, so it takes the same time
+    // for any file size, and pages are shared through the page cache with every other process
+    // mapping the same file.
+    class BarFile {
+    public:
+        static std::unique_ptr<BarFile> open(const std::string& path);
+
+        ~BarFile();
+        BarFile(const BarFile&) = delete;
+        BarFile& operator=(const BarFile&) = delete;
+
+        std::string_view symbol() const { return header().symbol; }
+        std::string_view interval() const { return header().interval; }
+        uint64_t rowCount() const { return header().rowCount; }
+
+        ColumnSpan<int64_t> timestamps() const {
+            return { reinterpret_cast<const int64_t*>(mData + header().timestampOffset), rowCount() };
+        }
+
+        ColumnSpan<double> column(BarColumn column) const {
+            return { reinterpret_cast<const double*>(mData + header().columnOffsets[static_cast<size_t>(column)]), rowCount() };
+        }
+
+    private:
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+
+        BarFile() = default;
+
+        const BarFileHeader& header() const { return *reinterpret_cast<const BarFileHeader*>(mData); }
+    };
+}
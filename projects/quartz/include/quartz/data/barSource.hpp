@@ -0,0 +1,37 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "data/barFile.hpp"
+#include "utils/fileUtils.hpp"
+#include "utils/interner.hpp"
+
+namespace Quartz {
+    // Columns of one data source's bars, loaded from a data directory. Bars are read from
+    // <dataDirectory>/<ticker>_<interval>.qzb, or <ticker>.qzb when there's no interval specific
+    // file, falling back to .csv files with the same names.
+    //
+    // Bar files (see data/barFile.hpp) are memory mapped and their columns read in place, columns
+    // named open, high, low, close (or price) and volume are the bar file column of that name. CSV
+    // files are parsed up front with loadCsvColumns(), their header line names the columns and every
+    // requested column has to be there, other columns are ignored. Either way every column is
+    // contiguous and stays valid until the next load().
+    class BarSource {
+    public:
+        // Path of the file holding a source's bars, throws when there is none
+        static std::string find(const std::string& dataDirectory, const std::string& ticker, const std::string& interval);
+
+        // Loads the named columns of the bar or CSV file at path
+        void load(const std::string& path, const std::vector<Symbol>& columns);
+
+        uint64_t rowCount() const { return mRows; }
+        // Indexed in the order the columns were requested
+        const std::vector<const double*>& columns() const { return mColumns; }
+
+    private:
+        std::unique_ptr<BarFile> mBarFile;
+        CsvColumns mCsv;
+        std::vector<const double*> mColumns;
+        uint64_t mRows = 0;
+    };
+}
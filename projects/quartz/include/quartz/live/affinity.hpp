@@ -0,0 +1,13 @@
+#pragma once
+
+#include "pch.hpp"
+
+namespace Quartz {
+    // Cores this process may run on, in ascending order. Respects the affinity mask it was started
+    // with (taskset, cgroups), falls back to every hardware thread on hosts that can't report one.
+    std::vector<unsigned> availableCores();
+
+    // Restricts the calling thread to one core, so it keeps its caches and the memory it touches first
+    // is allocated on that core's node. False when the host doesn't support pinning.
+    bool pinCurrentThread(unsigned core);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <atomic>
+#include <type_traits>
+
+#include "live/waitStrategy.hpp"
+
+namespace Quartz {
+    // Bounded single producer, single consumer ring buffer. tryPush() and tryPop() are wait free:
+    // each side owns one index, reads the other side's with an acquire load and never retries.
+    //
+    // The indices are free running 64-bit counters on separate cache lines, and each side keeps a
+    // private copy of the other's index that it only refreshes when the queue looks full or empty,
+    // so while both sides keep up with each other they rarely touch the other's line at all.
+    //
+    // Wait decides how pop() waits for data (see live/waitStrategy.hpp). The producer side never
+    // blocks on the consumer except for push(), which spins while the queue is full.
+    template <typename T, typename Wait = FutexWait>
+    class SpscQueue {
+        static_assert(std::is_trivially_copyable_v<T>, "Queue slots are copied by value between threads");
+
+    public:
+        // Rounded up to a power of two so a slot is found with a mask
+        explicit SpscQueue(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            mMask = size - 1;
+            mSlots = std::make_unique<T[]>(size);
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        size_t capacity() const { return mMask + 1; }
+
+        // Producer side, false when the queue is full
+        bool tryPush(const T& value) {
+            const uint64_t tail = mTail.load(std::memory_order_relaxed);
+            if (tail - mCachedHead > mMask) {
+                mCachedHead = mHead.load(std::memory_order_acquire);
+                if (tail - mCachedHead > mMask)
+                    return false;
+            }
+            mSlots[tail & mMask] = value;
+            mTail.store(tail + 1, std::memory_order_release);
+            mWait.notify();
+            return true;
+        }
+
+        // Producer side, spins until there is room
+        void push(const T& value) {
+            while (!tryPush(value))
+                cpuRelax();
+        }
+
+        // Producer side, once the consumer has drained what was pushed before, pop() returns false
+        void close() {
+            mClosed.store(true, std::memory_order_release);
+            mWait.notify();
+        }
+
+        // Consumer side, false when the queue is empty
+        bool tryPop(T& value) {
+            const uint64_t head = mHead.load(std::memory_order_relaxed);
+            if (head == mCachedTail) {
+                mCachedTail = mTail.load(std::memory_order_acquire);
+                if (head == mCachedTail)
+                    return false;
+            }
+            value = mSlots[head & mMask];
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, waits for a value. False once the queue is closed and empty.
+        bool pop(T& value) {
+            if (tryPop(value))
+                return true;
+            mWait.waitUntil([this] { return !empty() || mClosed.load(std::memory_order_acquire); });
+            // Values pushed before close() are still delivered
+            return tryPop(value);
+        }
+
+        // Consumer side, for consumers waiting on more than one queue
+        bool empty() const {
+            return mTail.load(std::memory_order_acquire) == mHead.load(std::memory_order_relaxed);
+        }
+
+        // Consumer side, true once the queue was closed and everything pushed before that popped
+        bool drained() const {
+            // close() is ordered after the last push, so once it's seen that push is too
+            return mClosed.load(std::memory_order_acquire) && empty();
+        }
+
+    private:
+        // Written by the producer
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mTail{ 0 };
+        uint64_t mCachedHead = 0;
+        // Written by the consumer
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mHead{ 0 };
+        uint64_t mCachedTail = 0;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> mClosed{ false };
+        size_t mMask = 0;
+        std::unique_ptr<T[]> mSlots;
+        Wait mWait;
+    };
+}
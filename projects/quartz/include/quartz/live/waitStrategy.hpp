@@ -0,0 +1,83 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <atomic>
+
+namespace Quartz {
+    // Queue indices sit on their own cache lines so the producer and consumer never write to the same line
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Hint to the core that this is a spin loop, it backs off the pipeline and lets a sibling hyperthread run
+    inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // How a consumer waits for an SpscQueue to have something for it. notify() is called by the
+    // producer after every push, waitUntil() returns once ready() is true.
+
+    // Spins on the queue. Lowest latency, but every waiting thread burns a core, so it needs at
+    // least one core per thread of the pipeline.
+    class BusyPollWait {
+    public:
+        template <typename Ready>
+        void waitUntil(Ready ready) {
+            while (!ready())
+                cpuRelax();
+        }
+
+        void notify() {}
+    };
+
+    // Spins briefly, then parks the waiting thread on a futex until the producer wakes it. A producer
+    // only makes a syscall when a consumer is actually parked, otherwise notify() is a fence and a load.
+    // Any number of threads can notify, one waits. Hosts without futexes yield instead of parking.
+    class FutexWait {
+    public:
+        static constexpr int SPIN_COUNT = 256;
+
+        template <typename Ready>
+        void waitUntil(Ready ready) {
+            for (int i = 0; i < SPIN_COUNT; ++i) {
+                if (ready())
+                    return;
+                cpuRelax();
+            }
+            for (;;) {
+                // The epoch is read before the check, a notify() in between changes it and the
+                // futex wait returns straight away instead of sleeping through it
+                const uint32_t epoch = mEpoch.load(std::memory_order_acquire);
+                mWaiters.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (ready()) {
+                    mWaiters.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+                futexWait(&mEpoch, epoch);
+                mWaiters.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        void notify() {
+            // Pairs with the fence in waitUntil(): either the waiter sees what was just pushed or
+            // this sees the waiter
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (mWaiters.load(std::memory_order_relaxed) == 0)
+                return;
+            mEpoch.fetch_add(1, std::memory_order_release);
+            futexWake(&mEpoch);
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> mEpoch{ 0 };
+        std::atomic<uint32_t> mWaiters{ 0 };
+
+        // Sleeps while *word == expected, may return spuriously
+        static void futexWait(std::atomic<uint32_t>* word, uint32_t expected);
+        static void futexWake(std::atomic<uint32_t>* word);
+    };
+}
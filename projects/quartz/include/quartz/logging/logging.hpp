@@ -25,6 +25,12 @@ public:
     int getCharPos() const { return charpos; }
 };
 
+class MalformedLiteralException : public PositionalException {
+public:
+    MalformedLiteralException(int line, int charpos, std::string_view literal, const std::string& reason)
+        : PositionalException(line, charpos, "Malformed literal '" + std::string(literal) + "': " + reason) {}
+};
+
 class UnexpectedSymbolException : public PositionalException {
 public:
     UnexpectedSymbolException(int line, int charpos, char symbol)
@@ -44,6 +50,7 @@ namespace Quartz {
         void log(Level level, const std::string& message);
 
         void setPrintLevel(Level level) { printLevel = level; }
+        Level getPrintLevel() const { return printLevel; }
 
         void setOutputStream(std::ostream& outputStream) { out = &outputStream; }
 
@@ -54,7 +61,12 @@ namespace Quartz {
             }
         }
 
-        void throwException(const std::exception& exeption);
+        // Templated so the concrete exception type (and its message) survives the rethrow
+        template <typename Exception>
+        [[noreturn]] void throwException(const Exception& exception) {
+            logf(FATAL, "Exception: %s", exception.what());
+            throw exception;
+        }
 
     private:
         std::ostream* out;
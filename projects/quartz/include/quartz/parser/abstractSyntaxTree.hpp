@@ -3,9 +3,11 @@
 #include <vector>
 #include <memory>
 #include <iostream>
-#include <any>
 
 #include "tokenizer/tokens.hpp"
+#include "parser/value.hpp"
+#include "utils/arena.hpp"
+#include "utils/interner.hpp"
 
 namespace Quartz {
 
@@ -18,24 +20,22 @@ namespace Quartz {
         FunctionDecl,
         Block,
         ExprStmt,
+        VarDecl,
+        AssignStmt,
         Signal,
         IfStmt,
         ReturnStmt,
         CallExpr,
         BinaryExpr,
         IdentifierExpr,
+        IndexExpr,
         LiteralExpr,
     };
 
-    enum Signal {
-        BUY,
-        HOLD,
-        SELL
-    };
-
     // Base AST node
+    // Nodes are allocated from the ProgramNode's arena and are never destroyed individually,
+    // so they may only hold trivially destructible members (raw child pointers, views, ArenaArrays)
     struct ASTNode {
-        virtual ~ASTNode() = default;
         virtual void print(int indent = 0) const = 0;
         virtual NodeType nodeType() const = 0;
 
@@ -46,8 +46,12 @@ namespace Quartz {
         }
     };
 
+    using NodeList = ArenaArray<ASTNode*>;
+
+    // Owns the arena every other node and identifier string of the program is allocated from
     struct ProgramNode : public ASTNode {
-        std::vector<std::unique_ptr<ASTNode>> declarations;
+        Arena arena;
+        NodeList declarations;
         void print(int indent = 0) const override {
             printIndent(indent);
             std::cout << "ProgramNode\n";
@@ -58,40 +62,52 @@ namespace Quartz {
     };
 
     struct ConstDeclNode : public ASTNode {
-        std::string name;
+        Symbol name;
         TokenType type;
-        std::string value;
-        ConstDeclNode(const std::string& name, TokenType type, const std::string& value)
+        Value value;
+        ConstDeclNode(Symbol name, TokenType type, Value value)
             : name(name), type(type), value(value) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "ConstDeclNode: " << name << " = " << value << "\n";
+            std::cout << "ConstDeclNode: " << symbolName(name) << " = " << value.toString() << "\n";
         }
         NodeType nodeType() const override { return NodeType::ConstDecl; }
     };
 
+    struct BlockNode : public ASTNode {
+        NodeList statements;
+        BlockNode(NodeList statements) : statements(statements) {}
+        void print(int indent = 0) const override {
+            printIndent(indent);
+            std::cout << "BlockNode\n";
+            for (const auto& stmt : statements)
+                stmt->print(indent + 1);
+        }
+        NodeType nodeType() const override { return NodeType::Block; }
+    };
+
     struct FunctionDeclNode : public ASTNode {
-        std::string name;
+        Symbol name;
         TokenType returnType;
-        std::unique_ptr<ASTNode> body;
-        FunctionDeclNode(const std::string& name, TokenType returnType, std::unique_ptr<ASTNode> body)
-            : name(name), returnType(returnType), body(std::move(body)) {}
+        BlockNode* body;
+        FunctionDeclNode(Symbol name, TokenType returnType, BlockNode* body)
+            : name(name), returnType(returnType), body(body) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "FunctionDeclNode: " << name << "\n";
+            std::cout << "FunctionDeclNode: " << symbolName(name) << "\n";
             if (body)
                 body->print(indent + 1);
         }
-        NodeType nodeType() const override { return NodeType::StrategyOnDataFunction; }
+        NodeType nodeType() const override { return NodeType::FunctionDecl; }
     };
 
     struct StrategyInitNode : public FunctionDeclNode {
-        StrategyInitNode(TokenType returnType, std::unique_ptr<ASTNode> body)
-            : FunctionDeclNode("StrategyInit", returnType, std::move(body)) {}
+        StrategyInitNode(TokenType returnType, BlockNode* body)
+            : FunctionDeclNode(intern("StrategyInit"), returnType, body) {}
 
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "StrategyInitNode: " << name << "\n";
+            std::cout << "StrategyInitNode: " << symbolName(name) << "\n";
             if (body)
                 body->print(indent + 1);
         }
@@ -100,12 +116,12 @@ namespace Quartz {
     };
 
     struct StrategyOnDataNode : public FunctionDeclNode {
-        StrategyOnDataNode(TokenType returnType, std::unique_ptr<ASTNode> body)
-            : FunctionDeclNode("StrategyOnData", returnType, std::move(body)) {}
+        StrategyOnDataNode(TokenType returnType, BlockNode* body)
+            : FunctionDeclNode(intern("StrategyOnData"), returnType, body) {}
 
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "StrategyOnDataNode: " << name << "\n";
+            std::cout << "StrategyOnDataNode: " << symbolName(name) << "\n";
             if (body)
                 body->print(indent + 1);
         }
@@ -114,16 +130,16 @@ namespace Quartz {
     };
 
     struct StrategyNode : public ASTNode {
-        std::string name;
-        std::vector<std::unique_ptr<ASTNode>> body;
+        Symbol name;
+        NodeList body;
 
-        std::unique_ptr<StrategyInitNode> initNode = nullptr;
-        std::unique_ptr<StrategyOnDataNode> onDataNode = nullptr;
+        StrategyInitNode* initNode = nullptr;
+        StrategyOnDataNode* onDataNode = nullptr;
 
-        StrategyNode(const std::string& name) : name(name) {}
+        StrategyNode(Symbol name) : name(name) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "StrategyNode: " << name << "\n";
+            std::cout << "StrategyNode: " << symbolName(name) << "\n";
             if (initNode) {
                 printIndent(indent + 1);
                 initNode->print(indent + 1);
@@ -138,27 +154,44 @@ namespace Quartz {
         NodeType nodeType() const override { return NodeType::Strategy; }
     };
 
-    struct BlockNode : public ASTNode {
-        std::vector<std::unique_ptr<ASTNode>> statements;
+    struct ExprStmtNode : public ASTNode {
+        ASTNode* expression;
+        ExprStmtNode(ASTNode* expression)
+            : expression(expression) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "BlockNode\n";
-            for (const auto& stmt : statements)
-                stmt->print(indent + 1);
+            std::cout << "ExprStmtNode\n";
+            expression->print(indent + 1);
         }
-        NodeType nodeType() const override { return NodeType::Block; }
+        NodeType nodeType() const override { return NodeType::ExprStmt; }
     };
 
-    struct ExprStmtNode : public ASTNode {
-        std::unique_ptr<ASTNode> expression;
-        ExprStmtNode(std::unique_ptr<ASTNode> expression)
-            : expression(std::move(expression)) {}
+    // Function local, `var name (: Type)? = initializer;`
+    struct VarDeclNode : public ASTNode {
+        Symbol name;
+        TokenType type;
+        ASTNode* initializer;
+        VarDeclNode(Symbol name, TokenType type, ASTNode* initializer)
+            : name(name), type(type), initializer(initializer) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "ExprStmtNode\n";
-            expression->print(indent + 1);
+            std::cout << "VarDeclNode: " << symbolName(name) << "\n";
+            initializer->print(indent + 1);
         }
-        NodeType nodeType() const override { return NodeType::ExprStmt; }
+        NodeType nodeType() const override { return NodeType::VarDecl; }
+    };
+
+    struct AssignStmtNode : public ASTNode {
+        Symbol name;
+        ASTNode* value;
+        AssignStmtNode(Symbol name, ASTNode* value)
+            : name(name), value(value) {}
+        void print(int indent = 0) const override {
+            printIndent(indent);
+            std::cout << "AssignStmtNode: " << symbolName(name) << "\n";
+            value->print(indent + 1);
+        }
+        NodeType nodeType() const override { return NodeType::AssignStmt; }
     };
 
     struct SignalNode : public ASTNode {
@@ -166,21 +199,17 @@ namespace Quartz {
         SignalNode(Signal signal) : signal(signal) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "SignalNode: " << (signal == BUY ? "BUY" : signal == HOLD ? "HOLD" : "SELL") << "\n";
+            std::cout << "SignalNode: " << signalToString(signal) << "\n";
         }
         NodeType nodeType() const override { return NodeType::Signal; }
     };
 
     struct IfStmtNode : public ASTNode {
-        std::unique_ptr<ASTNode> condition;
-        std::unique_ptr<BlockNode> thenBlock;
-        std::unique_ptr<ASTNode> elseBranch;
-        IfStmtNode(std::unique_ptr<ASTNode> condition,
-            std::unique_ptr<BlockNode> thenBlock,
-            std::unique_ptr<ASTNode> elseBranch)
-            : condition(std::move(condition)),
-            thenBlock(std::move(thenBlock)),
-            elseBranch(std::move(elseBranch)) {}
+        ASTNode* condition;
+        BlockNode* thenBlock;
+        ASTNode* elseBranch;
+        IfStmtNode(ASTNode* condition, BlockNode* thenBlock, ASTNode* elseBranch)
+            : condition(condition), thenBlock(thenBlock), elseBranch(elseBranch) {}
         void print(int indent = 0) const override {
             printIndent(indent);
             std::cout << "IfStmtNode\n";
@@ -204,13 +233,13 @@ namespace Quartz {
     };
 
     struct CallExprNode : public ASTNode {
-        std::string callee;
-        std::vector<std::unique_ptr<ASTNode>> arguments;
-        CallExprNode(const std::string& callee, std::vector<std::unique_ptr<ASTNode>> arguments)
-            : callee(callee), arguments(std::move(arguments)) {}
+        Symbol callee;
+        NodeList arguments;
+        CallExprNode(Symbol callee, NodeList arguments)
+            : callee(callee), arguments(arguments) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "CallExprNode: " << callee << "\n";
+            std::cout << "CallExprNode: " << symbolName(callee) << "\n";
             for (const auto& arg : arguments)
                 arg->print(indent + 1);
         }
@@ -218,14 +247,14 @@ namespace Quartz {
     };
 
     struct BinaryExprNode : public ASTNode {
-        std::unique_ptr<ASTNode> left;
-        Token op;
-        std::unique_ptr<ASTNode> right;
-        BinaryExprNode(std::unique_ptr<ASTNode> left, Token op, std::unique_ptr<ASTNode> right)
-            : left(std::move(left)), op(op), right(std::move(right)) {}
+        ASTNode* left;
+        TokenType op;
+        ASTNode* right;
+        BinaryExprNode(ASTNode* left, TokenType op, ASTNode* right)
+            : left(left), op(op), right(right) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "BinaryExprNode: " << std::string(op) << "\n";
+            std::cout << "BinaryExprNode: " << tokenTypeToString(op) << "\n";
             left->print(indent + 1);
             right->print(indent + 1);
         }
@@ -233,21 +262,34 @@ namespace Quartz {
     };
 
     struct IdentifierExprNode : public ASTNode {
-        std::string name;
-        IdentifierExprNode(const std::string& name) : name(name) {}
+        Symbol name;
+        IdentifierExprNode(Symbol name) : name(name) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "IdentifierExprNode: " << name << "\n";
+            std::cout << "IdentifierExprNode: " << symbolName(name) << "\n";
         }
         NodeType nodeType() const override { return NodeType::IdentifierExpr; }
     };
 
+    // `name[index]`, the value name held index bars ago
+    struct IndexExprNode : public ASTNode {
+        Symbol name;
+        ASTNode* index;
+        IndexExprNode(Symbol name, ASTNode* index) : name(name), index(index) {}
+        void print(int indent = 0) const override {
+            printIndent(indent);
+            std::cout << "IndexExprNode: " << symbolName(name) << "\n";
+            index->print(indent + 1);
+        }
+        NodeType nodeType() const override { return NodeType::IndexExpr; }
+    };
+
     struct LiteralExprNode : public ASTNode {
-        std::string value;
-        LiteralExprNode(const std::string& value) : value(value) {}
+        Value value;
+        LiteralExprNode(Value value) : value(value) {}
         void print(int indent = 0) const override {
             printIndent(indent);
-            std::cout << "LiteralExprNode: " << value << "\n";
+            std::cout << "LiteralExprNode: " << value.toString() << "\n";
         }
         NodeType nodeType() const override { return NodeType::LiteralExpr; }
     };
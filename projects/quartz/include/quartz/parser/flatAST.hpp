@@ -0,0 +1,141 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/abstractSyntaxTree.hpp"
+
+namespace Quartz {
+    using NodeIndex = uint32_t;
+    constexpr NodeIndex INVALID_NODE = 0xFFFFFFFFu;
+    constexpr uint32_t NO_PAYLOAD = 0xFFFFFFFFu;
+
+    // Struct-of-arrays form of the AST for analysis and lowering passes.
+    // Node i is described by kinds[i], names[i] (a Symbol) and payloads[i], and its children are the
+    // contiguous node range [firstChild[i], firstChild[i] + childCount[i]). Nodes are laid out
+    // breadth first so siblings are adjacent, node 0 is always the Program.
+    //
+    // Per kind:
+    //   Program                            children: declarations
+    //   Strategy                           name, payload: frame size once resolved,
+    //                                      children: consts, functions, init, on_data
+    //   ConstDecl                          name, payload: declared TokenType, children: [LiteralExpr]
+    //   FunctionDecl / StrategyInit / OnData  name, payload: return TokenType, children: [Block]
+    //   Block                              children: statements
+    //   ExprStmt                           children: [expression]
+    //   VarDecl                            name, payload: declared TokenType (frame slot once resolved),
+    //                                      children: [initializer]
+    //   AssignStmt                         name, payload: frame slot once resolved, children: [value]
+    //   IfStmt                             children: [condition, Block, else branch?]
+    //   ReturnStmt                         -
+    //   CallExpr                           name: callee, payload: BuiltinRegistry index once type
+    //                                      checked (NO_PAYLOAD for intrinsics), indicator call site
+    //                                      once resolved, children: arguments
+    //   BinaryExpr                         payload: operator TokenType, children: [left, right]
+    //   IdentifierExpr                     name, payload: frame slot once resolved
+    //   IndexExpr                          name, payload: input slot once resolved, children: [index]
+    //   LiteralExpr                        payload: index into values
+    //   Signal                             payload: Signal
+    //
+    // types is empty until the TypeChecker has run, after which it holds the static type of every
+    // expression node and the variable type of VarDecl and AssignStmt (ValueType::None for other
+    // statements and void calls)
+    struct FlatAST {
+        std::vector<NodeType> kinds;
+        std::vector<uint32_t> firstChild;
+        std::vector<uint32_t> childCount;
+        std::vector<Symbol> names;
+        std::vector<uint32_t> payloads;
+        std::vector<ValueType> types;
+
+        std::vector<Value> values;
+
+        // Flattens a parsed program, the FlatAST shares ownership since string values view its arena
+        static FlatAST fromProgram(std::shared_ptr<const ProgramNode> program);
+
+        size_t size() const { return kinds.size(); }
+
+        NodeIndex child(NodeIndex node, uint32_t i) const { return firstChild[node] + i; }
+        Symbol name(NodeIndex node) const { return names[node]; }
+        const Value& value(NodeIndex node) const { return values[payloads[node]]; }
+        TokenType tokenType(NodeIndex node) const { return static_cast<TokenType>(payloads[node]); }
+        Signal signal(NodeIndex node) const { return static_cast<Signal>(payloads[node]); }
+        ValueType type(NodeIndex node) const { return types[node]; }
+        bool typed() const { return types.size() == kinds.size(); }
+
+        // Value of a ConstDecl, integer literals are widened when the const is declared as a float
+        Value constValue(NodeIndex constNode) const {
+            Value literal = value(child(constNode, 0));
+            if (literal.type == ValueType::Integer && tokenType(constNode) == KEYWORD_FLOAT)
+                return Value(static_cast<double>(literal.integer));
+            return literal;
+        }
+
+        // Identifiers passed to define_input_variables() anywhere under node, in declaration order
+        // with duplicates removed
+        std::vector<Symbol> inputVariables(NodeIndex node) const;
+
+        void print() const;
+
+    private:
+        std::shared_ptr<const ProgramNode> mProgram;
+    };
+
+    // Statically dispatched visitor over a FlatAST. Derived classes hide the visitX methods they
+    // care about, the defaults just walk the children.
+    template <typename Derived>
+    class FlatASTVisitor {
+    public:
+        explicit FlatASTVisitor(const FlatAST& ast) : mAst(ast) {}
+
+        void visit(NodeIndex node) {
+            Derived& self = static_cast<Derived&>(*this);
+            switch (mAst.kinds[node]) {
+            case NodeType::Program: self.visitProgram(node); break;
+            case NodeType::ConstDecl: self.visitConstDecl(node); break;
+            case NodeType::Strategy: self.visitStrategy(node); break;
+            case NodeType::StrategyInitFunction:
+            case NodeType::StrategyOnDataFunction:
+            case NodeType::FunctionDecl: self.visitFunctionDecl(node); break;
+            case NodeType::Block: self.visitBlock(node); break;
+            case NodeType::ExprStmt: self.visitExprStmt(node); break;
+            case NodeType::VarDecl: self.visitVarDecl(node); break;
+            case NodeType::AssignStmt: self.visitAssignStmt(node); break;
+            case NodeType::Signal: self.visitSignal(node); break;
+            case NodeType::IfStmt: self.visitIfStmt(node); break;
+            case NodeType::ReturnStmt: self.visitReturnStmt(node); break;
+            case NodeType::CallExpr: self.visitCallExpr(node); break;
+            case NodeType::BinaryExpr: self.visitBinaryExpr(node); break;
+            case NodeType::IdentifierExpr: self.visitIdentifierExpr(node); break;
+            case NodeType::IndexExpr: self.visitIndexExpr(node); break;
+            case NodeType::LiteralExpr: self.visitLiteralExpr(node); break;
+            }
+        }
+
+        void visitChildren(NodeIndex node) {
+            const uint32_t first = mAst.firstChild[node];
+            const uint32_t count = mAst.childCount[node];
+            for (uint32_t i = 0; i < count; ++i)
+                static_cast<Derived&>(*this).visit(first + i);
+        }
+
+        void visitProgram(NodeIndex node) { visitChildren(node); }
+        void visitConstDecl(NodeIndex node) { visitChildren(node); }
+        void visitStrategy(NodeIndex node) { visitChildren(node); }
+        void visitFunctionDecl(NodeIndex node) { visitChildren(node); }
+        void visitBlock(NodeIndex node) { visitChildren(node); }
+        void visitExprStmt(NodeIndex node) { visitChildren(node); }
+        void visitVarDecl(NodeIndex node) { visitChildren(node); }
+        void visitAssignStmt(NodeIndex node) { visitChildren(node); }
+        void visitSignal(NodeIndex /*node*/) {}
+        void visitIfStmt(NodeIndex node) { visitChildren(node); }
+        void visitReturnStmt(NodeIndex /*node*/) {}
+        void visitCallExpr(NodeIndex node) { visitChildren(node); }
+        void visitBinaryExpr(NodeIndex node) { visitChildren(node); }
+        void visitIdentifierExpr(NodeIndex /*node*/) {}
+        void visitIndexExpr(NodeIndex node) { visitChildren(node); }
+        void visitLiteralExpr(NodeIndex /*node*/) {}
+
+    protected:
+        const FlatAST& mAst;
+    };
+}
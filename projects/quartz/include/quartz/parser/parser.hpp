@@ -1,57 +1,89 @@
 #pragma once
 #include "abstractSyntaxTree.hpp"
 #include "tokenizer/tokens.hpp"
+#include "tokenizer/tokenStream.hpp"
 
 #include <vector>
 #include <memory>
 #include <string>
-#include <any>
 
 namespace Quartz {
     class Parser {
-        std::vector<Token> tokens;
-        size_t current = 0;
+        TokenStream mTokens;
 
-        bool isAtEnd() const { return (current >= tokens.size() || (tokens[current].Type == NONE || tokens[current].Type == END)); }
-        Token peek() const { return tokens[current]; }
-        Token advance() { if (isAtEnd()) return Token(END); return tokens[current++]; }
+        // Program being built, every node and string is allocated from its arena
+        ProgramNode* mProgram = nullptr;
+        // Shared stack used to collect list elements before they're copied into the arena as one block
+        std::vector<ASTNode*> mScratch;
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args) { return mProgram->arena.make<T>(std::forward<Args>(args)...); }
+        std::string_view copyText(const Token& token) { return mProgram->arena.copyString(text(token)); }
+        // Returns the interned name of an IDENTIFIER token, anything else is a syntax error
+        Symbol symbolOf(const Token& token);
+        NodeList takeScratch(size_t mark);
+
+        [[noreturn]] void throwUnexpectedToken(const Token& token);
+
+        const Symbol mInitSymbol = intern("init");
+        const Symbol mOnDataSymbol = intern("on_data");
+
+        bool isAtEnd() { return (peek().Type == NONE || peek().Type == END); }
+        const Token& peek() { return mTokens.peek(); }
+        Token advance() { return mTokens.next(); }
         bool match(TokenType type);
 
+        std::string_view text(const Token& token) const { return token.text(mTokens.source()); }
+
+        // Converts a literal token to its typed value, numbers were already parsed by the tokenizer
+        Value literalValue(const Token& token);
+
         // Program -> (ConstDeclaration | StrategyDeclaration)* ;
-        std::unique_ptr<ProgramNode> parseProgram();
+        void parseProgram();
 
         // StrategyDeclaration -> "strategy" IDENTIFIER "{" StrategyBody "}"
-        std::unique_ptr<StrategyNode> parseStrategy();
+        StrategyNode* parseStrategy();
 
         // ConstDeclaration -> "const" IDENTIFIER (":" Type)? "=" Literal ";" ;
-        std::unique_ptr<ConstDeclNode> parseConstDeclaration();
+        ConstDeclNode* parseConstDeclaration();
 
         // FunctionDeclaration -> IDENTIFIER "(" ")" "->" Type Block ;
-        std::unique_ptr<FunctionDeclNode> parseFunctionDeclaration();
+        FunctionDeclNode* parseFunctionDeclaration();
 
         // Block -> "{" Statement* "}" ;
-        std::unique_ptr<BlockNode> parseBlock();
+        BlockNode* parseBlock();
+
+        // Statement -> IfStatement | ReturnStatement | VarDeclaration | Assignment | ExpressionStatement ;
+        ASTNode* parseStatement();
+
+        // VarDeclaration -> "var" IDENTIFIER (":" Type)? "=" Expression ";" ;
+        ASTNode* parseVarDeclaration();
 
-        // Statement -> IfStatement | ReturnStatement | ExpressionStatement ;
-        std::unique_ptr<ASTNode> parseStatement();
+        // Assignment -> IDENTIFIER "=" Expression ";" ;
+        ASTNode* parseAssignment();
 
         // IfStatement -> "if" "(" Expression ")" Block ( "else" (IfStatement | Block) )? ;
-        std::unique_ptr<ASTNode> parseIfStatement();
+        ASTNode* parseIfStatement();
 
         // ExpressionStatement -> Expression ";" ;
-        std::unique_ptr<ASTNode> parseExpressionStatement();
+        ASTNode* parseExpressionStatement();
 
         // Expression -> BinaryExpression | Primary ;
-        std::unique_ptr<ASTNode> parseExpression();
+        ASTNode* parseExpression();
 
-        // Primary -> IDENTIFIER ( "(" ( Expression ("," Expression)* )? ")" )? | Literal ;
-        std::unique_ptr<ASTNode> parsePrimary();
+        // Primary -> IDENTIFIER ( "(" ( Expression ("," Expression)* )? ")" | "[" Expression "]" )? | Literal ;
+        ASTNode* parsePrimary();
 
     public:
-        Parser(std::vector<Token> tokens) : tokens(std::move(tokens)), current(0) {}
+        // Tokens are pulled from the source as the parser needs them
+        Parser(const char* source) : mTokens(source) {}
 
         std::shared_ptr<ProgramNode> parse() {
-            return parseProgram();
+            auto program = std::make_shared<ProgramNode>();
+            mProgram = program.get();
+            parseProgram();
+            mProgram = nullptr;
+            return program;
         }
     };
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "pch.hpp"
+
+namespace Quartz {
+    enum Signal {
+        BUY,
+        HOLD,
+        SELL
+    };
+
+    inline const char* signalToString(Signal signal) {
+        return signal == BUY ? "BUY" : signal == HOLD ? "HOLD" : "SELL";
+    }
+
+    enum class ValueType : uint8_t {
+        None,
+        String,
+        Integer,
+        Float,
+        Bool,
+        Signal,
+    };
+
+    // Also used as the static type of expressions, where None means void
+    inline const char* typeName(ValueType type) {
+        switch (type) {
+        case ValueType::String: return "string";
+        case ValueType::Integer: return "int";
+        case ValueType::Float: return "float";
+        case ValueType::Bool: return "bool";
+        case ValueType::Signal: return "signal";
+        default: return "void";
+        }
+    }
+
+    // Typed value, numbers are converted to binary once by the tokenizer
+    struct Value {
+        ValueType type = ValueType::None;
+        union {
+            int64_t integer = 0;
+            double floating;
+            bool boolean;
+            Signal signal;
+        };
+        // Views memory owned by the program's arena
+        std::string_view string;
+
+        Value() = default;
+        explicit Value(int64_t integer) : type(ValueType::Integer), integer(integer) {}
+        explicit Value(double floating) : type(ValueType::Float), floating(floating) {}
+        explicit Value(std::string_view string) : type(ValueType::String), string(string) {}
+
+        static Value fromBool(bool boolean) {
+            Value value;
+            value.type = ValueType::Bool;
+            value.boolean = boolean;
+            return value;
+        }
+
+        static Value fromSignal(Signal signal) {
+            Value value;
+            value.type = ValueType::Signal;
+            value.signal = signal;
+            return value;
+        }
+
+        std::string toString() const {
+            switch (type) {
+            case ValueType::String:
+                return std::string(string);
+            case ValueType::Integer:
+                return std::to_string(integer);
+            case ValueType::Float: {
+                std::ostringstream oss;
+                oss << floating;
+                return oss.str();
+            }
+            case ValueType::Bool:
+                return boolean ? "true" : "false";
+            case ValueType::Signal:
+                return signalToString(signal);
+            default:
+                return "null";
+            }
+        }
+    };
+}
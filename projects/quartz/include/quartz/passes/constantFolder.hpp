@@ -0,0 +1,44 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/flatAST.hpp"
+
+namespace Quartz {
+    // Resolves consts at compile time. Runs on the type checked FlatAST and rewrites it in place:
+    //   - IdentifierExpr nodes naming a const become LiteralExpr nodes holding its value
+    //   - BinaryExpr nodes whose operands are both literals become a bool LiteralExpr, int literals
+    //     compared with a float expression are widened to float literals
+    //   - IfStmt nodes with a literal condition become a Block holding only the branch that runs
+    // Rewritten nodes keep their index, children they no longer reference are simply left unreachable.
+    class ConstantFolder {
+    public:
+        explicit ConstantFolder(FlatAST& ast) : mAst(ast) {}
+
+        void run();
+
+        size_t substitutedCount() const { return mSubstituted; }
+        size_t foldedCount() const { return mFolded; }
+        size_t prunedCount() const { return mPruned; }
+
+    private:
+        FlatAST& mAst;
+
+        // Const name to its index in FlatAST::values
+        std::unordered_map<Symbol, uint32_t> mGlobals;
+        std::unordered_map<Symbol, uint32_t> mScope;
+
+        size_t mSubstituted = 0;
+        size_t mFolded = 0;
+        size_t mPruned = 0;
+
+        Symbol mDefineInputsSymbol = intern("define_input_variables");
+
+        uint32_t constantValue(NodeIndex constNode);
+        void foldStrategy(NodeIndex strategyNode);
+        void foldStatement(NodeIndex node);
+        void foldExpression(NodeIndex node);
+        void widenLiteral(NodeIndex node, ValueType otherType);
+        void makeLiteral(NodeIndex node, uint32_t valueIndex);
+    };
+}
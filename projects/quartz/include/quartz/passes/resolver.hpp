@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/flatAST.hpp"
+#include "vm/indicators.hpp"
+
+namespace Quartz {
+    // Lays out each strategy's frame and binds every variable reference to its slot, so nothing is
+    // looked up by name at runtime. Input variables take the first slots in declaration order, locals
+    // follow and reuse the slots of blocks that have already ended. Runs after constant folding, by
+    // which point the only identifiers left are inputs and locals.
+    //
+    // Writes the slot into the payload of IdentifierExpr, IndexExpr, VarDecl and AssignStmt nodes and
+    // the frame size into the payload of the Strategy node. Indicator calls in on_data() are numbered
+    // per strategy in their CallExpr payload, each number is one instance of indicator state. History
+    // lookbacks have to be constant so the rings behind them can be sized up front.
+    class Resolver {
+    public:
+        explicit Resolver(FlatAST& ast) : mAst(ast) {}
+
+        void run();
+
+    private:
+        FlatAST& mAst;
+
+        std::unordered_map<Symbol, uint32_t> mSlots;
+        std::vector<Symbol> mLocals;
+        uint32_t mNextSlot = 0;
+        uint32_t mFrameSize = 0;
+        uint32_t mInputCount = 0;
+        uint32_t mIndicatorCount = 0;
+        bool mInOnData = false;
+        Symbol mStrategy = INVALID_SYMBOL;
+
+        void resolveStrategy(NodeIndex strategyNode);
+        void resolveStatement(NodeIndex node);
+        void resolveExpression(NodeIndex node);
+        void resolveIndicator(NodeIndex node, const IndicatorInfo& indicator);
+        void resolveHistory(NodeIndex node);
+        uint32_t slotOf(Symbol name);
+
+        [[noreturn]] void throwResolveError(const std::string& message) const;
+    };
+}
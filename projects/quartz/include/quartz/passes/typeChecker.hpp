@@ -0,0 +1,68 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/flatAST.hpp"
+
+namespace Quartz {
+    // Resolves every expression of a program to int, float, string, bool or signal and fills in
+    // FlatAST::types. Ill-typed programs are rejected before anything gets compiled or run.
+    //
+    // int widens implicitly to float, nothing else converts.
+    class TypeChecker {
+    public:
+        explicit TypeChecker(FlatAST& ast) : mAst(ast) {}
+
+        void check();
+
+    private:
+        FlatAST& mAst;
+
+        enum class VariableKind {
+            Constant,
+            Input,
+            Local,
+        };
+
+        struct Variable {
+            ValueType type;
+            VariableKind kind;
+        };
+
+        // Constants, input variables and locals visible at the node being checked. Locals can't
+        // shadow anything, so leaving a block only has to drop the locals it declared.
+        std::unordered_map<Symbol, Variable> mGlobals;
+        std::unordered_map<Symbol, Variable> mScope;
+        std::vector<Symbol> mLocals;
+
+        Symbol mStrategy = INVALID_SYMBOL;
+        NodeIndex mFunction = INVALID_NODE;
+        ValueType mReturnType = ValueType::None;
+
+        Symbol mEmitSignalSymbol = intern("emit_signal");
+        Symbol mDefineInputsSymbol = intern("define_input_variables");
+
+        ValueType checkConstant(NodeIndex constNode);
+        void checkStrategy(NodeIndex strategyNode);
+        void checkFunction(NodeIndex functionNode);
+        void checkStatement(NodeIndex node);
+        void checkVarDecl(NodeIndex node);
+        void checkAssignment(NodeIndex node);
+        ValueType checkExpression(NodeIndex node);
+        ValueType checkCall(NodeIndex node);
+
+        void expectType(NodeIndex node, ValueType expected, const std::string& context);
+        ValueType typeOfKeyword(TokenType keyword, const std::string& context);
+
+        [[noreturn]] void throwTypeError(const std::string& message) const;
+    };
+
+    // Can a value of type from be used where to is expected
+    inline bool isAssignable(ValueType from, ValueType to) {
+        return from == to || (from == ValueType::Integer && to == ValueType::Float);
+    }
+
+    inline bool isNumeric(ValueType type) {
+        return type == ValueType::Integer || type == ValueType::Float;
+    }
+}
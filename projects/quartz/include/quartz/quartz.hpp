@@ -1,8 +1,28 @@
-#include "../pch.hpp"
+#pragma once
+
+#include "pch.hpp"
 
 #include "parser/abstractSyntaxTree.hpp"
+#include "parser/flatAST.hpp"
 
 namespace Quartz {
 	std::shared_ptr<ProgramNode> run_code(const char* code);
 	std::shared_ptr<ProgramNode> run_file(const char* file);
+
+	// Flattens a parsed program and runs the checking passes over it, producing the typed IR
+	// the execution engines compile from
+	std::shared_ptr<const FlatAST> analyse_program(std::shared_ptr<const ProgramNode> program);
+
+	// A value replacing the one a const is declared with
+	struct ConstOverride {
+		Symbol name;
+		Value value;
+	};
+
+	// The two halves of analyse_program(). check_program() flattens and type checks, which doesn't
+	// depend on const values. specialise_program() folds consts and resolves a copy of the checked
+	// program, every const named by an override (at the top level or in a strategy) taking its value
+	// instead, so one checked program can be specialised any number of times.
+	std::shared_ptr<const FlatAST> check_program(std::shared_ptr<const ProgramNode> program);
+	std::shared_ptr<const FlatAST> specialise_program(const FlatAST& checked, const std::vector<ConstOverride>& overrides = {});
 }
\ No newline at end of file
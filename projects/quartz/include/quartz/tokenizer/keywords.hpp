@@ -0,0 +1,113 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <array>
+
+#include "tokenizer/tokens.hpp"
+
+namespace Quartz {
+    struct Keyword {
+        std::string_view text;
+        TokenType type = IDENTIFIER;
+    };
+
+    // To add a keyword just append it here, the perfect hash below is regenerated at compile time
+    inline constexpr Keyword keywordList[] = {
+        {"strategy", KEYWORD_STRATEGY},
+        {"const", KEYWORD_CONST},
+        {"var", KEYWORD_VAR},
+        {"if", KEYWORD_IF},
+        {"else", KEYWORD_ELSE},
+        {"return", KEYWORD_RETURN},
+
+        {"string", KEYWORD_STRING},
+        {"float", KEYWORD_FLOAT},
+        {"int", KEYWORD_INT},
+        {"void", KEYWORD_VOID},
+
+        {"null", KEYWORD_NULL},
+
+        {"SELL", KEYWORD_SELL},
+        {"BUY", KEYWORD_BUY},
+        {"HOLD", KEYWORD_HOLD},
+    };
+
+    namespace KeywordHash {
+        constexpr uint32_t TABLE_BITS = 5;
+        constexpr uint32_t TABLE_SIZE = 1u << TABLE_BITS;
+
+        constexpr size_t minLength() {
+            size_t length = SIZE_MAX;
+            for (const Keyword& keyword : keywordList)
+                length = keyword.text.size() < length ? keyword.text.size() : length;
+            return length;
+        }
+
+        constexpr size_t maxLength() {
+            size_t length = 0;
+            for (const Keyword& keyword : keywordList)
+                length = keyword.text.size() > length ? keyword.text.size() : length;
+            return length;
+        }
+
+        // Only looks at the length and the first, second and last characters so a lookup never walks the whole word
+        constexpr uint32_t hash(const char* text, size_t length, uint32_t seed) {
+            uint32_t h = seed ^ static_cast<uint32_t>(length);
+            h = (h ^ static_cast<unsigned char>(text[0])) * 0x01000193u;
+            h = (h ^ static_cast<unsigned char>(text[1])) * 0x01000193u;
+            h = (h ^ static_cast<unsigned char>(text[length - 1])) * 0x01000193u;
+            return (h ^ (h >> 15)) & (TABLE_SIZE - 1);
+        }
+
+        struct Table {
+            uint32_t seed = 0;
+            std::array<Keyword, TABLE_SIZE> slots{};
+        };
+
+        // Searches for the first seed that maps every keyword to its own slot
+        constexpr Table build() {
+            for (uint32_t seed = 1; seed < 100000; ++seed) {
+                Table table;
+                table.seed = seed;
+                bool collision = false;
+                for (const Keyword& keyword : keywordList) {
+                    Keyword& slot = table.slots[hash(keyword.text.data(), keyword.text.size(), seed)];
+                    if (!slot.text.empty()) {
+                        collision = true;
+                        break;
+                    }
+                    slot = keyword;
+                }
+                if (!collision)
+                    return table;
+            }
+            return Table{};
+        }
+
+        inline constexpr Table table = build();
+
+        static_assert(minLength() >= 2, "hash() reads the second character of every keyword");
+        static_assert(table.seed != 0, "No collision-free keyword hash seed found, increase TABLE_BITS");
+    }
+
+    // Returns the keyword token type for the given span, or IDENTIFIER if it isn't a keyword
+    constexpr TokenType lookupKeyword(const char* text, size_t length) {
+        if (length < KeywordHash::minLength() || length > KeywordHash::maxLength())
+            return IDENTIFIER;
+        const Keyword& slot = KeywordHash::table.slots[KeywordHash::hash(text, length, KeywordHash::table.seed)];
+        return slot.text == std::string_view(text, length) ? slot.type : IDENTIFIER;
+    }
+
+    namespace KeywordHash {
+        constexpr bool resolvesAllKeywords() {
+            for (const Keyword& keyword : keywordList) {
+                if (lookupKeyword(keyword.text.data(), keyword.text.size()) != keyword.type)
+                    return false;
+            }
+            return true;
+        }
+
+        static_assert(resolvesAllKeywords(), "Keyword perfect hash is inconsistent with keywordList");
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <array>
+
+// Selects the widest vector width available at compile time, falling back to plain scalar loops
+#if defined(__AVX2__)
+#define QUARTZ_SCANNER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARTZ_SCANNER_SSE2 1
+#endif
+
+namespace Quartz {
+    namespace Scanner {
+        enum CharClass : uint8_t {
+            CHAR_WHITESPACE = 1 << 0,
+            CHAR_NEWLINE = 1 << 1,
+            CHAR_IDENTIFIER_START = 1 << 2,
+            CHAR_IDENTIFIER = 1 << 3,
+            CHAR_DIGIT = 1 << 4,
+            CHAR_NUMBER = 1 << 5,
+            CHAR_QUOTE = 1 << 6,
+            CHAR_PUNCTUATION = 1 << 7,
+        };
+
+        constexpr std::array<uint8_t, 256> buildCharClassTable() {
+            std::array<uint8_t, 256> table{};
+            table[' '] = table['\t'] = CHAR_WHITESPACE;
+            table['\n'] = table['\r'] = CHAR_WHITESPACE | CHAR_NEWLINE;
+            for (int c = 'a'; c <= 'z'; ++c)
+                table[c] = CHAR_IDENTIFIER_START | CHAR_IDENTIFIER;
+            for (int c = 'A'; c <= 'Z'; ++c)
+                table[c] = CHAR_IDENTIFIER_START | CHAR_IDENTIFIER;
+            table['_'] = CHAR_IDENTIFIER_START | CHAR_IDENTIFIER;
+            for (int c = '0'; c <= '9'; ++c)
+                table[c] = CHAR_IDENTIFIER | CHAR_DIGIT | CHAR_NUMBER;
+            table['.'] = CHAR_NUMBER;
+            table['"'] = table['\''] = CHAR_QUOTE;
+            for (unsigned char c : { '{', '}', '(', ')', '=', ':', ';', ',', '<', '>', '-', '/' })
+                table[c] = CHAR_PUNCTUATION;
+            return table;
+        }
+
+        inline constexpr std::array<uint8_t, 256> charClassTable = buildCharClassTable();
+
+        inline bool hasClass(char c, uint8_t charClass) {
+            return (charClassTable[static_cast<unsigned char>(c)] & charClass) != 0;
+        }
+
+        // All scanners take a [begin, end) range and return a pointer to the first byte that
+        // doesn't belong to the span, or end if the span runs to the end of the input
+
+        // Skips whitespace, newlines and // comments
+        const char* skipTrivia(const char* begin, const char* end);
+
+        // Skips to the next '\n' or '\r'
+        const char* skipLine(const char* begin, const char* end);
+
+        // Scans [A-Za-z0-9_]*
+        const char* scanIdentifier(const char* begin, const char* end);
+
+        // Scans [0-9.]*
+        const char* scanNumber(const char* begin, const char* end);
+
+        // Finds the closing quote, or the newline that makes the literal unterminated
+        const char* scanString(const char* begin, const char* end, char quote);
+
+        // Finds the delimiter, '\n' or '\r' that ends a delimited field
+        const char* scanField(const char* begin, const char* end, char delimiter);
+
+        // Counts the '\n' bytes in [begin, end)
+        size_t countNewlines(const char* begin, const char* end);
+    }
+}
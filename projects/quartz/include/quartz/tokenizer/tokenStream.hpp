@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <array>
+#include <cassert>
+
+#include "tokenizer/tokenizer.hpp"
+
+namespace Quartz {
+	// Pulls tokens from a Tokenizer on demand and keeps a small ring buffer of lookahead,
+	// so memory use is bounded by LOOKAHEAD rather than by the size of the source file
+	class TokenStream {
+	public:
+		static constexpr size_t LOOKAHEAD = 8;
+
+		TokenStream(const char* source)
+			: mTokenizer(source) {}
+
+		const char* source() const { return mTokenizer.source(); }
+		const LiteralValue& literal(const Token& token) const { return mTokenizer.literal(token); }
+
+		// Returns the k-th upcoming token without consuming it, k must be below LOOKAHEAD
+		const Token& peek(size_t k = 0) {
+			assert(k < LOOKAHEAD);
+			while (mCount <= k) {
+				mBuffer[(mHead + mCount) & (LOOKAHEAD - 1)] = mTokenizer.next();
+				mCount++;
+			}
+			return mBuffer[(mHead + k) & (LOOKAHEAD - 1)];
+		}
+
+		// Consumes and returns the next token, END is never consumed
+		Token next() {
+			Token token = peek();
+			if (token.Type != END) {
+				mHead = (mHead + 1) & (LOOKAHEAD - 1);
+				mCount--;
+			}
+			return token;
+		}
+
+	private:
+		static_assert((LOOKAHEAD & (LOOKAHEAD - 1)) == 0, "LOOKAHEAD must be a power of two");
+
+		Tokenizer mTokenizer;
+		std::array<Token, LOOKAHEAD> mBuffer{};
+		size_t mHead = 0;
+		size_t mCount = 0;
+	};
+}
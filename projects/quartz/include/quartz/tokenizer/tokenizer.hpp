@@ -6,18 +6,46 @@
 #include "logging/logging.hpp"
 
 namespace Quartz {
+	struct SourceLocation {
+		int Line = 1;
+		int CharPos = 1;
+	};
+
 	class Tokenizer {
 	private:
 		const char* mInput = "";
+		const char* mEnd = mInput;
+		const char* mCursor = mInput;
+		// Values of the numeric literals lexed so far, indexed by Token::Value
+		std::vector<LiteralValue> mLiterals;
+
+		uint32_t offsetOf(const char* position) const { return static_cast<uint32_t>(position - mInput); }
+
+		Token buildNumber(const char** cursor);
+		Token buildString(const char** cursor) const;
+		Token buildIdentifier(const char** cursor) const;
 
-		char peek(int i);
-		Token buildNumber(int* i);
+		Token parseString(uint32_t offset, uint32_t length) const;
 
-		Token parseString(const std::string& string);
+		[[noreturn]] void throwUnexpectedSymbol(const char* position) const;
+		[[noreturn]] void throwMalformedLiteral(const char* begin, const char* end, const std::string& reason) const;
 	public:
+		// Lexes the next token on demand, returns END (repeatedly) once the input is exhausted
+		Token next();
+
+		// Lexes the remaining input into a vector, ending with an END token. Numeric values stay in
+		// this tokenizer, see literal().
 		std::vector<Token> tokenize();
 
+		const char* source() const { return mInput; }
+
+		// Parsed value of an INT_VALUE or FLOAT_VALUE token this tokenizer produced
+		const LiteralValue& literal(const Token& token) const { return mLiterals[token.Value]; }
+
+		// Resolves a byte offset into a line/column pair, only used when reporting errors
+		static SourceLocation locate(const char* input, uint32_t offset);
+
 		Tokenizer(const char* mInput)
-			: mInput(mInput) {};
+			: mInput(mInput), mEnd(mInput + std::strlen(mInput)), mCursor(mInput) {};
 	};
-}
\ No newline at end of file
+}
@@ -2,8 +2,10 @@
 
 #include "pch.hpp"
 
+#include "utils/interner.hpp"
+
 namespace Quartz {
-    enum TokenType
+    enum TokenType : uint8_t
     {
         NONE,
 
@@ -18,6 +20,7 @@ namespace Quartz {
 
         KEYWORD_STRATEGY,
         KEYWORD_CONST,
+        KEYWORD_VAR,
         KEYWORD_IF,
         KEYWORD_ELSE,
         KEYWORD_RETURN,
@@ -33,6 +36,8 @@ namespace Quartz {
         CLOSE_CURLY_BRACE,
         OPEN_BRACKET,
         CLOSE_BRACKET,
+        OPEN_SQUARE_BRACKET,
+        CLOSE_SQUARE_BRACKET,
         EQUALS,
         COLON,
         SEMI_COLON,
@@ -45,101 +50,121 @@ namespace Quartz {
         ERR,
     };
 
+    inline const char* tokenTypeToString(TokenType type) {
+        switch (type) {
+        case KEYWORD_STRATEGY:
+            return "<STRATEGY_KEYWORD>";
+        case KEYWORD_CONST:
+            return "<CONST_KEYWORD>";
+        case KEYWORD_VAR:
+            return "<VAR_KEYWORD>";
+        case KEYWORD_IF:
+            return "<IF_KEYWORD>";
+        case KEYWORD_ELSE:
+            return "<ELSE_KEYWORD>";
+        case KEYWORD_RETURN:
+            return "<RETURN_KEYWORD>";
+        case KEYWORD_STRING:
+            return "<STRING_KEYWORD>";
+        case KEYWORD_INT:
+            return "<INT_KEYWORD>";
+        case KEYWORD_FLOAT:
+            return "<FLOAT_KEYWORD>";
+        case IDENTIFIER:
+            return "<IDENTIFIER>";
+        case STRING_VALUE:
+            return "<STRING_VALUE>";
+        case INT_VALUE:
+            return "<INT_VALUE>";
+        case FLOAT_VALUE:
+            return "<FLOAT_VALUE>";
+        case OPEN_CURLY_BRACE:
+            return "<OPEN_CURLY_BRACE>";
+        case CLOSE_CURLY_BRACE:
+            return "<CLOSE_CURLY_BRACE>";
+        case OPEN_BRACKET:
+            return "<OPEN_BRACKET>";
+        case CLOSE_BRACKET:
+            return "<CLOSE_BRACKET>";
+        case OPEN_SQUARE_BRACKET:
+            return "<OPEN_SQUARE_BRACKET>";
+        case CLOSE_SQUARE_BRACKET:
+            return "<CLOSE_SQUARE_BRACKET>";
+        case RIGHT_ARROW:
+            return "<RIGHT_ARROW>";
+        case EQUALS:
+            return "<EQUALS>";
+        case COLON:
+            return "<COLON>";
+        case SEMI_COLON:
+            return "<SEMI_COLON>";
+        case COMMA:
+            return "<COMMA>";
+        case KEYWORD_BUY:
+            return "<BUY_KEYWORD>";
+        case KEYWORD_HOLD:
+            return "<HOLD_KEYWORD>";
+        case KEYWORD_SELL:
+            return "<SELL_KEYWORD>";
+        case LESS_THAN:
+            return "<LESS_THAN>";
+        case GREATER_THAN:
+            return "<GREATER_THAN>";
+        case KEYWORD_NULL:
+            return "<NULL_KEYWORD>";
+        case KEYWORD_VOID:
+            return "<VOID_KEYWORD>";
+        case END:
+            return "<END>";
+        default:
+            return "<NONE:unknown_value>";
+        }
+    }
+
+    // Compact token: a type tag plus a span into the tokenizer's source buffer.
+    // Line/column are not stored, use Tokenizer::locate() when reporting errors.
+    // INT_VALUE and FLOAT_VALUE tokens carry their value already converted to binary,
+    // IDENTIFIER tokens carry their interned Symbol.
+    // Binary value of a numeric literal, the token's type says which
+    union LiteralValue {
+        int64_t IntValue;
+        double FloatValue;
+    };
+
     struct Token {
         TokenType Type = NONE;
-        std::any Data;
-
-        int Line = 0;
-        int CharPos = 0;
+        uint32_t Offset = 0;
+        uint32_t Length = 0;
+        // IDENTIFIER: the interned name. INT_VALUE and FLOAT_VALUE: index of the parsed value in
+        // the tokenizer's literal table (see Tokenizer::literal()), keeping tokens at 16 bytes.
+        uint32_t Value = 0;
 
         Token() = default;
 
-        Token(const TokenType& Type, const std::any& Data=NULL, const int Line = 0, const int CharPos = 0)
-            : Type(Type), Data(Data), Line(Line), CharPos(CharPos)
+        Token(const TokenType Type, const uint32_t Offset = 0, const uint32_t Length = 0)
+            : Type(Type), Offset(Offset), Length(Length)
         {
         }
 
-        operator std::string() const {
+        std::string_view text(const char* source) const {
+            return std::string_view(source + Offset, Length);
+        }
+
+        std::string toString(const char* source) const {
             switch (Type) {
-            case KEYWORD_STRATEGY:
-                return "<STRATEGY_KEYWORD>";
-            case KEYWORD_CONST:
-                return "<CONST_KEYWORD>";
-            case KEYWORD_IF:
-                return "<IF_KEYWORD>";
-            case KEYWORD_ELSE:
-                return "<ELSE_KEYWORD>";
-            case KEYWORD_RETURN:
-                return "<RETURN_KEYWORD>";
-            case KEYWORD_STRING:
-                return "<STRING_KEYWORD>";
-            case KEYWORD_INT:
-                return "<INT_KEYWORD>";
-            case KEYWORD_FLOAT:
-                return "<FLOAT_KEYWORD>";
             case IDENTIFIER:
-                return "<IDENTIFIER:" + std::any_cast<std::string>(Data) + ">";
+                return "<IDENTIFIER:" + std::string(text(source)) + ">";
             case STRING_VALUE:
-                return "<STRING_VALUE:" + std::any_cast<std::string>(Data) + ">";
+                return "<STRING_VALUE:" + std::string(text(source)) + ">";
             case INT_VALUE:
-                return "<INT_VALUE:" + std::any_cast<std::string>(Data) + ">";
+                return "<INT_VALUE:" + std::string(text(source)) + ">";
             case FLOAT_VALUE:
-                return "<FLOAT_VALUE:" + std::any_cast<std::string>(Data) + ">";
-            case OPEN_CURLY_BRACE:
-                return "<OPEN_CURLY_BRACE>";
-            case CLOSE_CURLY_BRACE:
-                return "<CLOSE_CURLY_BRACE>";
-            case OPEN_BRACKET:
-                return "<OPEN_BRACKET>";
-            case CLOSE_BRACKET:
-                return "<CLOSE_BRACKET>";
-            case RIGHT_ARROW:
-                return "<RIGHT_ARROW>";
-            case EQUALS:
-                return "<EQUALS>";
-            case COLON:
-                return "<COLON>";
-            case SEMI_COLON:
-                return "<SEMI_COLON>";
-            case COMMA:
-                return "<COMMA>";
-            case KEYWORD_BUY:
-                return "<BUY_KEYWORD>";
-            case KEYWORD_HOLD:
-                return "<HOLD_KEYWORD>";
-            case KEYWORD_SELL:
-                return "<SELL_KEYWORD>";
-            case LESS_THAN:
-                return "<LESS_THAN>";
-            case GREATER_THAN:
-                return "<GREATER_THAN>";
-            case KEYWORD_NULL:
-                return "<NULL_KEYWORD>";
-            case KEYWORD_VOID:
-                return "<VOID_KEYWORD>";
+                return "<FLOAT_VALUE:" + std::string(text(source)) + ">";
             default:
-                return "<NONE:unknown_value>";
+                return tokenTypeToString(Type);
             }
-
         }
     };
 
-    const std::unordered_map<std::string, TokenType> keywordMap = {
-        {"strategy", KEYWORD_STRATEGY},
-        {"const", KEYWORD_CONST},
-        {"if", KEYWORD_IF},
-        {"else", KEYWORD_ELSE},
-        {"return", KEYWORD_RETURN},
-
-        {"string", KEYWORD_STRING},
-        {"float", KEYWORD_FLOAT},
-        {"int", KEYWORD_INT},
-        {"void", KEYWORD_VOID},
-
-        {"null", KEYWORD_NULL},
-
-        {"SELL", KEYWORD_SELL},
-        {"BUY", KEYWORD_BUY},
-        {"HOLD", KEYWORD_HOLD},
-    };
+    static_assert(sizeof(Token) == 16, "Tokens are copied through the lookahead buffer, keep them small");
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace Quartz {
+    // Contiguous, immutable view over elements allocated from an Arena
+    template <typename T>
+    struct ArenaArray {
+        T* data = nullptr;
+        uint32_t count = 0;
+
+        T* begin() const { return data; }
+        T* end() const { return data + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        T& operator[](size_t index) const { return data[index]; }
+    };
+
+    // Bump allocator: objects are carved out of large chunks and never freed individually,
+    // destroying the arena releases every chunk at once without running any destructors
+    class Arena {
+    public:
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+        Arena(size_t chunkSize = DEFAULT_CHUNK_SIZE) : mChunkSize(chunkSize) {}
+        ~Arena() { release(); }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        Arena(Arena&& other) noexcept
+            : mChunkSize(other.mChunkSize), mHead(other.mHead), mCursor(other.mCursor), mLimit(other.mLimit), mBytesUsed(other.mBytesUsed) {
+            other.mHead = nullptr;
+            other.mCursor = other.mLimit = nullptr;
+            other.mBytesUsed = 0;
+        }
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(mCursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            if (!mCursor || aligned + size > reinterpret_cast<uintptr_t>(mLimit)) {
+                grow(size + alignment);
+                aligned = (reinterpret_cast<uintptr_t>(mCursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            }
+            mCursor = reinterpret_cast<char*>(aligned + size);
+            mBytesUsed += size;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Only trivially destructible types can live in the arena, their destructors are never run
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            static_assert(std::is_trivially_destructible<T>::value, "Arena objects must be trivially destructible");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        ArenaArray<T> copyArray(const T* source, size_t count) {
+            static_assert(std::is_trivially_copyable<T>::value, "Arena arrays must be trivially copyable");
+            if (count == 0)
+                return {};
+            T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            std::memcpy(data, source, sizeof(T) * count);
+            return { data, static_cast<uint32_t>(count) };
+        }
+
+        std::string_view copyString(std::string_view string) {
+            if (string.empty())
+                return {};
+            char* data = static_cast<char*>(allocate(string.size(), 1));
+            std::memcpy(data, string.data(), string.size());
+            return std::string_view(data, string.size());
+        }
+
+        size_t bytesUsed() const { return mBytesUsed; }
+
+    private:
+        struct Chunk {
+            Chunk* next;
+        };
+
+        size_t mChunkSize;
+        Chunk* mHead = nullptr;
+        char* mCursor = nullptr;
+        char* mLimit = nullptr;
+        size_t mBytesUsed = 0;
+
+        void grow(size_t minimumSize) {
+            size_t size = sizeof(Chunk) + (minimumSize > mChunkSize ? minimumSize : mChunkSize);
+            Chunk* chunk = static_cast<Chunk*>(::operator new(size));
+            chunk->next = mHead;
+            mHead = chunk;
+            mCursor = reinterpret_cast<char*>(chunk + 1);
+            mLimit = reinterpret_cast<char*>(chunk) + size;
+        }
+
+        void release() {
+            while (mHead) {
+                Chunk* next = mHead->next;
+                ::operator delete(mHead);
+                mHead = next;
+            }
+        }
+    };
+}
@@ -2,6 +2,35 @@
 
 #include "pch.hpp"
 
+#include "data/barFile.hpp"
+
 namespace Quartz {
     const char* loadFileToCString(const char* filename);
-}
\ No newline at end of file
+
+    // Numeric columns of a CSV file, column major
+    struct CsvColumns {
+        uint64_t rows = 0;
+        // From the timestamp, time or date column, empty when the file has none. Integers are
+        // taken as they are, dates as YYYY-MM-DD[ HH:MM[:SS]] become UTC epoch seconds.
+        std::vector<int64_t> timestamps;
+        // One per requested column, in the order they were requested
+        std::vector<std::vector<double>> values;
+        // Per requested column, false when the file doesn't have it and its values are empty
+        std::vector<bool> present;
+    };
+
+    // Parses the named columns of a CSV file with a header line. Header names are matched case
+    // insensitively, columns that weren't asked for are skipped without being parsed.
+    //
+    // The file is split into one chunk per thread at line boundaries. Every chunk counts its lines
+    // first so each thread knows where its rows start, then parses straight into the shared
+    // columns. threadCount 0 uses every hardware thread.
+    //
+    // A requested column the file doesn't have is an error unless allowMissing is set.
+    CsvColumns loadCsvColumns(const char* filename, const std::vector<std::string>& columns, unsigned threadCount = 0, bool allowMissing = false);
+
+    // Timestamp, open, high, low, close and volume columns, ready for writeBarFile(). Close can come
+    // from a price column instead. A file with only closes still converts: missing open, high and
+    // low repeat the close and a missing volume is 0, with a warning naming what was filled in.
+    BarTable loadCsvBars(const char* filename, unsigned threadCount = 0);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "utils/arena.hpp"
+
+namespace Quartz {
+    using Symbol = uint32_t;
+    constexpr Symbol INVALID_SYMBOL = 0xFFFFFFFFu;
+
+    // Program-wide identifier table: every distinct name is stored once and handed out as a
+    // dense 32-bit Symbol, so comparing identifiers is an integer compare. Symbols stay valid for
+    // the lifetime of the process and are shared by every program that gets loaded.
+    // Any thread can intern and look names up, builtins returning strings intern while strategies
+    // run on several threads. Lookups of names already seen only take the lock shared.
+    class StringInterner {
+    public:
+        static StringInterner& getInstance() {
+            static StringInterner instance;
+            return instance;
+        }
+
+        // Returns the symbol for the given name, adding it if it hasn't been seen before
+        Symbol intern(std::string_view name);
+
+        // Returns the symbol for the given name, or INVALID_SYMBOL without adding it
+        Symbol find(std::string_view name) const;
+
+        std::string_view name(Symbol symbol) const {
+            std::shared_lock lock(mMutex);
+            return symbol < mNames.size() ? mNames[symbol] : std::string_view();
+        }
+
+        size_t size() const {
+            std::shared_lock lock(mMutex);
+            return mNames.size();
+        }
+
+    private:
+        mutable std::shared_mutex mMutex;
+        Arena mArena;
+        std::vector<std::string_view> mNames;
+        std::vector<uint32_t> mHashes;
+        // Open addressing table of symbol + 1, 0 marks an empty slot
+        std::vector<uint32_t> mSlots;
+
+        StringInterner() : mSlots(1024, 0) {}
+
+        static uint32_t hash(std::string_view name);
+        // Probes for name, the caller holds the lock. Returns the symbol or INVALID_SYMBOL with slot
+        // set to where it would go.
+        Symbol probe(std::string_view name, uint32_t h, size_t& slot) const;
+        void grow();
+    };
+
+    inline Symbol intern(std::string_view name) { return StringInterner::getInstance().intern(name); }
+    inline std::string_view symbolName(Symbol symbol) { return StringInterner::getInstance().name(symbol); }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <atomic>
+#include <functional>
+
+#include "live/waitStrategy.hpp"
+
+namespace Quartz {
+    // Runs batches of independent tasks on a fixed number of threads. Every worker starts with an
+    // even, contiguous share of the task indices and takes them one at a time from the front of its
+    // share. A worker that runs out steals the back half of the largest share left, so batches where
+    // some tasks take far longer than others still finish together.
+    //
+    // A share is a begin and end index packed into one 64-bit atomic, taking and stealing are each a
+    // single compare and swap. Tasks only ever move between shares, so once every share is empty
+    // nothing is left to run.
+    class WorkStealingPool {
+    public:
+        // 0 uses every hardware thread
+        explicit WorkStealingPool(unsigned threads = 0);
+
+        unsigned threadCount() const { return mThreadCount; }
+
+        // Calls task(index, worker) once for every index in [0, taskCount), worker is below
+        // threadCount() and the calling thread is worker 0. Returns once every task has run. When a
+        // task throws, the tasks that haven't started yet are skipped and the first exception is
+        // rethrown.
+        void run(size_t taskCount, const std::function<void(size_t, unsigned)>& task);
+
+    private:
+        struct alignas(CACHE_LINE_SIZE) Share {
+            std::atomic<uint64_t> range{ 0 };
+        };
+
+        unsigned mThreadCount;
+        std::unique_ptr<Share[]> mShares;
+
+        // Next task of worker's own share, false when it's empty
+        bool take(unsigned worker, uint32_t& index);
+        // Moves half of the largest other share into worker's, false when every share is empty
+        bool steal(unsigned worker);
+    };
+}
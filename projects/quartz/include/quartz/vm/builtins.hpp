@@ -0,0 +1,157 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "vm/bytecode.hpp"
+
+namespace Quartz {
+    // State a running strategy can read from and write to through builtins
+    struct ExecutionContext {
+        // The strategy's variables indexed by frame slot, input variables come first as floats
+        RawValue* frame = nullptr;
+        // State of the strategy's indicator call sites, read by INDICATOR
+        IndicatorSet* indicators = nullptr;
+        // Past values of the input variables, read by LOAD_HISTORY
+        const InputHistory* history = nullptr;
+        std::vector<DataSource> dataSources;
+    };
+
+    using NativeFunction = RawValue(*)(ExecutionContext& context, const RawValue* arguments, uint8_t argumentCount);
+
+    struct BuiltinFunction {
+        std::string name;
+        NativeFunction function;
+        ValueType returnType;
+        // Trailing parameters past minArguments are optional
+        std::vector<ValueType> parameters;
+        uint8_t minArguments;
+    };
+
+    // How a C++ parameter or return type maps onto a script type and a register
+    template <typename T>
+    struct NativeType;
+
+    template <>
+    struct NativeType<int64_t> {
+        static constexpr ValueType type = ValueType::Integer;
+        static int64_t fromRaw(RawValue raw) { return raw.integer; }
+        static RawValue toRaw(int64_t value) { RawValue raw; raw.integer = value; return raw; }
+    };
+
+    template <>
+    struct NativeType<double> {
+        static constexpr ValueType type = ValueType::Float;
+        static double fromRaw(RawValue raw) { return raw.floating; }
+        static RawValue toRaw(double value) { RawValue raw; raw.floating = value; return raw; }
+    };
+
+    template <>
+    struct NativeType<bool> {
+        static constexpr ValueType type = ValueType::Bool;
+        static bool fromRaw(RawValue raw) { return raw.boolean; }
+        static RawValue toRaw(bool value) { RawValue raw; raw.boolean = value; return raw; }
+    };
+
+    template <>
+    struct NativeType<Signal> {
+        static constexpr ValueType type = ValueType::Signal;
+        static Signal fromRaw(RawValue raw) { return raw.signal; }
+        static RawValue toRaw(Signal value) { RawValue raw; raw.signal = value; return raw; }
+    };
+
+    // Strings are interned, the view stays valid for the lifetime of the process
+    template <>
+    struct NativeType<std::string_view> {
+        static constexpr ValueType type = ValueType::String;
+        static std::string_view fromRaw(RawValue raw) { return symbolName(raw.string); }
+        static RawValue toRaw(std::string_view value) { RawValue raw; raw.string = intern(value); return raw; }
+    };
+
+    namespace detail {
+        // Omitted optional arguments are value initialised, the registers past argumentCount aren't read
+        template <typename T>
+        T nativeArgument(const RawValue* arguments, uint8_t argumentCount, size_t index) {
+            return index < argumentCount ? NativeType<T>::fromRaw(arguments[index]) : T{};
+        }
+
+        template <auto Function, typename R, typename... Args, size_t... I>
+        RawValue invokeNative(ExecutionContext& context, const RawValue* arguments, uint8_t argumentCount, std::index_sequence<I...>) {
+            if constexpr (std::is_void_v<R>) {
+                Function(context, nativeArgument<Args>(arguments, argumentCount, I)...);
+                return RawValue();
+            }
+            else {
+                return NativeType<R>::toRaw(Function(context, nativeArgument<Args>(arguments, argumentCount, I)...));
+            }
+        }
+
+        template <auto Function, typename R, typename... Args>
+        RawValue nativeTrampoline(ExecutionContext& context, const RawValue* arguments, uint8_t argumentCount) {
+            return invokeNative<Function, R, Args...>(context, arguments, argumentCount, std::index_sequence_for<Args...>{});
+        }
+
+        template <typename R>
+        constexpr ValueType nativeReturnType() {
+            if constexpr (std::is_void_v<R>)
+                return ValueType::None;
+            else
+                return NativeType<R>::type;
+        }
+    }
+
+    // Builtins callable through OpCode::CALL, indexed by the B operand. The type checker binds every
+    // call to its index once when the program is loaded, so nothing is looked up by name at runtime.
+    // emit_signal and define_input_variables aren't registered, the compiler handles them itself.
+    //
+    // Host applications register their own functions before loading programs:
+    //     double clamp(ExecutionContext&, double value, double limit);
+    //     BuiltinRegistry::getInstance().add<&clamp>("clamp");
+    // Parameters and the return type can be int64_t, double, bool, Signal or std::string_view
+    // (or void for the return type), the register marshalling is generated from the signature.
+    class BuiltinRegistry {
+    public:
+        // The CALL operand is 8 bits wide
+        static constexpr size_t MAX_FUNCTIONS = 256;
+        static constexpr uint32_t NOT_FOUND = 0xFFFFFFFFu;
+
+        static BuiltinRegistry& getInstance() {
+            static BuiltinRegistry instance;
+            return instance;
+        }
+
+        // Parameters past minArguments are optional, by default every parameter is required.
+        // Returns the function's index.
+        template <auto Function>
+        uint32_t add(std::string_view name, int minArguments = -1) {
+            return addSignature<Function>(name, minArguments, Function);
+        }
+
+        // Returns NOT_FOUND for names that aren't registered
+        uint32_t find(Symbol name) const {
+            auto index = mIndices.find(name);
+            return index == mIndices.end() ? NOT_FOUND : index->second;
+        }
+
+        const BuiltinFunction& operator[](uint32_t index) const { return mFunctions[index]; }
+        const std::vector<BuiltinFunction>& functions() const { return mFunctions; }
+
+    private:
+        std::vector<BuiltinFunction> mFunctions;
+        std::unordered_map<Symbol, uint32_t> mIndices;
+
+        BuiltinRegistry();
+
+        template <auto Function, typename R, typename... Args>
+        uint32_t addSignature(std::string_view name, int minArguments, R (*)(ExecutionContext&, Args...)) {
+            BuiltinFunction builtin;
+            builtin.name = std::string(name);
+            builtin.function = &detail::nativeTrampoline<Function, R, Args...>;
+            builtin.returnType = detail::nativeReturnType<R>();
+            builtin.parameters = { NativeType<Args>::type... };
+            builtin.minArguments = static_cast<uint8_t>(minArguments < 0 ? sizeof...(Args) : minArguments);
+            return insert(std::move(builtin));
+        }
+
+        uint32_t insert(BuiltinFunction builtin);
+    };
+}
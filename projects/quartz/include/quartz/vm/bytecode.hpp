@@ -0,0 +1,111 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/value.hpp"
+#include "utils/interner.hpp"
+#include "vm/history.hpp"
+#include "vm/indicators.hpp"
+
+namespace Quartz {
+    // Untagged register and constant contents. The type checker has already proven what every
+    // register holds at every instruction, so the opcodes carry the types instead of the values.
+    union RawValue {
+        int64_t integer = 0;
+        double floating;
+        bool boolean;
+        Signal signal;
+        // Strings are interned so they fit in a register
+        Symbol string;
+    };
+
+    static_assert(sizeof(RawValue) == 8, "Registers are expected to be 64 bits wide");
+
+    // Register based instruction set. Operands are register indices unless noted,
+    // Bx is the 16-bit operand formed by B and C and sBx is its signed form.
+    enum class OpCode : uint8_t {
+        LOAD_CONST,     // R[A] = constants[Bx]
+        LOAD_SLOT,      // R[A] = frame[Bx]
+        LOAD_HISTORY,   // R[A] = the input historyReads[Bx] names, historyReads[Bx].lookback bars ago
+        STORE_SLOT,     // frame[Bx] = R[A]
+        MOVE,           // R[A] = R[B]
+        INT_TO_FLOAT,   // R[A] = float(R[B])
+        LESS_INT,       // R[A] = R[B] < R[C]
+        LESS_FLOAT,
+        GREATER_INT,    // R[A] = R[B] > R[C]
+        GREATER_FLOAT,
+        JUMP,           // pc += sBx
+        JUMP_IF_FALSE,  // if !R[A] then pc += sBx
+        CALL,           // R[A] = builtins[B](R[A], ..., R[A + C - 1])
+        INDICATOR,      // R[A] = indicators[Bx].update(R[A], R[A + 1])
+        EMIT_SIGNAL,    // signal = R[A]
+        RETURN,         // return signal
+
+        COUNT
+    };
+
+    struct Instruction {
+        OpCode op;
+        uint8_t a = 0;
+        uint8_t b = 0;
+        uint8_t c = 0;
+
+        Instruction(OpCode op, uint8_t a = 0, uint8_t b = 0, uint8_t c = 0)
+            : op(op), a(a), b(b), c(c) {}
+
+        static Instruction withBx(OpCode op, uint8_t a, uint16_t bx) {
+            return Instruction(op, a, static_cast<uint8_t>(bx & 0xFF), static_cast<uint8_t>(bx >> 8));
+        }
+
+        uint16_t bx() const { return static_cast<uint16_t>(b | (c << 8)); }
+        int16_t sbx() const { return static_cast<int16_t>(bx()); }
+    };
+
+    static_assert(sizeof(Instruction) == 4, "Instructions are expected to be 32 bits wide");
+
+    struct CompiledFunction {
+        std::vector<Instruction> code;
+        uint8_t registerCount = 0;
+    };
+
+    // A constant lookback into one input's history ring, offset and mask locate the ring in
+    // InputHistory::values()
+    struct HistoryRead {
+        uint32_t input;
+        uint32_t lookback;
+        uint32_t offset;
+        uint32_t mask;
+    };
+
+    struct DataSource {
+        std::string ticker;
+        std::string interval;
+    };
+
+    // Bytecode for one strategy: both entry points share a constant pool and frame layout
+    struct CompiledStrategy {
+        Symbol name = INVALID_SYMBOL;
+        std::vector<RawValue> constants;
+        std::vector<ValueType> constantTypes;
+        // Input variables in the order define_input_variables() declared them, they occupy the
+        // first frame slots
+        std::vector<Symbol> inputs;
+        // Input variables followed by the locals of every function (see Resolver)
+        uint32_t frameSize = 0;
+        // One per indicator call site, indexed by INDICATOR's Bx
+        std::vector<IndicatorSpec> indicators;
+        // History ring capacity per input, 0 for inputs on_data() never looks back on
+        std::vector<uint32_t> historyCapacities;
+        // One per distinct lookback on_data() reads, indexed by LOAD_HISTORY's Bx
+        std::vector<HistoryRead> historyReads;
+
+        CompiledFunction init;
+        CompiledFunction onData;
+    };
+
+    // Unboxes a typed value, strings are interned
+    RawValue toRawValue(const Value& value);
+    Value fromRawValue(RawValue raw, ValueType type);
+
+    std::string disassemble(const CompiledStrategy& strategy, const CompiledFunction& function);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/flatAST.hpp"
+#include "vm/bytecode.hpp"
+
+namespace Quartz {
+    // Lowers a strategy's init() and on_data() bodies from the analysed FlatAST (see analyse_program) into register bytecode
+    class Compiler {
+    public:
+        explicit Compiler(const FlatAST& ast) : mAst(ast) {}
+
+        CompiledStrategy compileStrategy(NodeIndex strategyNode);
+
+    private:
+        enum class FunctionKind {
+            Init,
+            OnData,
+        };
+
+        const FlatAST& mAst;
+
+        CompiledStrategy* mStrategy = nullptr;
+        CompiledFunction* mFunction = nullptr;
+        FunctionKind mFunctionKind = FunctionKind::Init;
+
+        uint8_t mNextRegister = 0;
+        // Whether the code being compiled runs every time its function does, which decides if an
+        // indicator call can be shared between strategies
+        uint32_t mConditionalDepth = 0;
+        bool mMayHaveReturned = false;
+
+        Symbol mEmitSignalSymbol = intern("emit_signal");
+        Symbol mDefineInputsSymbol = intern("define_input_variables");
+
+        // Sizes every input's history ring from the lookbacks on_data() reads
+        void sizeHistory(NodeIndex onDataNode);
+        void compileFunction(NodeIndex functionNode, FunctionKind kind, CompiledFunction& function);
+        void compileStatement(NodeIndex node);
+        void compileBlock(NodeIndex block);
+        void compileIf(NodeIndex node);
+        void compileStore(NodeIndex node);
+        void compileCall(NodeIndex node, uint8_t target);
+        void compileIndicator(NodeIndex node, uint8_t target, const IndicatorInfo& indicator);
+        IndicatorOperand indicatorOperand(NodeIndex node) const;
+        void compileHistory(NodeIndex node, uint8_t target);
+        void compileExpression(NodeIndex node, uint8_t target);
+        // Compiles node into target converted to type
+        void compileExpressionAs(NodeIndex node, uint8_t target, ValueType type);
+
+        uint8_t allocateRegister();
+        // First register of a call whose result goes to target
+        uint8_t callRegister(uint8_t target);
+        uint16_t addConstant(RawValue value, ValueType type);
+        size_t emit(Instruction instruction);
+        void patchJump(size_t jump);
+
+        [[noreturn]] void throwCompileError(const std::string& message) const;
+    };
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "pch.hpp"
+
+namespace Quartz {
+    // Lookbacks are sized once at load time, this keeps a typo from reserving gigabytes
+    constexpr uint32_t MAX_HISTORY_LOOKBACK = 1 << 20;
+
+    // Smallest power of two ring that holds the current bar and lookback bars before it
+    uint32_t historyCapacity(uint32_t lookback);
+
+    // Offset of every input's ring in InputHistory::values(), rings are laid out back to back in
+    // input order. Compiled code addresses the rings through this layout directly.
+    std::vector<uint32_t> historyOffsets(const std::vector<uint32_t>& capacities);
+
+    // Where each input's ring lives, computed once from a strategy's capacities and shared by every
+    // InputHistory of the strategy
+    class HistoryLayout {
+    public:
+        HistoryLayout() = default;
+        // One capacity per input, 0 for inputs that are never indexed
+        explicit HistoryLayout(const std::vector<uint32_t>& capacities);
+
+        // Doubles one history takes
+        size_t valueCount() const { return mValueCount; }
+
+    private:
+        friend class InputHistory;
+
+        struct Ring {
+            uint32_t input;
+            uint32_t offset;
+            uint32_t mask;
+        };
+
+        std::vector<Ring> mRings;
+        size_t mValueCount = 0;
+    };
+
+    // Past values of a strategy's input variables. Every input on_data() indexes gets a power of two
+    // ring sized by the largest constant lookback it reads (see CompiledStrategy::historyCapacities),
+    // inputs it doesn't index take no memory. Reading k bars back is
+    // values()[offset + ((bar() - k) & mask)], the mask keeps every read inside the ring so there is
+    // no bounds check and nothing ever grows.
+    //
+    // Like IndicatorSet a history either owns its rings or views rings a StateBlock owns.
+    //
+    // The first bar fills its whole ring, until enough bars have been seen lookbacks return the first value.
+    class InputHistory {
+    public:
+        InputHistory() : InputHistory(std::vector<uint32_t>()) {}
+        // Owns its layout and rings
+        explicit InputHistory(const std::vector<uint32_t>& capacities);
+        // Views layout.valueCount() values and a bar index someone else owns, both of which have to
+        // outlive the history. The bar starts out at UINT64_MAX.
+        InputHistory(const HistoryLayout& layout, double* values, uint64_t* bar)
+            : mLayout(&layout), mValues(values), mBar(bar) {}
+
+        InputHistory(const InputHistory& other) { *this = other; }
+        InputHistory(InputHistory&& other) noexcept { *this = std::move(other); }
+        InputHistory& operator=(const InputHistory& other);
+        InputHistory& operator=(InputHistory&& other) noexcept;
+
+        // Records the next bar, inputs holds one value per input
+        void push(const double* inputs);
+
+        const double* values() const { return mValues; }
+        // Index of the most recent bar
+        uint64_t bar() const { return *mBar; }
+
+    private:
+        using Ring = HistoryLayout::Ring;
+
+        const HistoryLayout* mLayout = nullptr;
+        double* mValues = nullptr;
+        uint64_t* mBar = nullptr;
+
+        // Set when the history owns its rings
+        std::shared_ptr<const HistoryLayout> mOwnedLayout;
+        std::vector<double> mOwnedValues;
+        // Wraps to 0 on the first push
+        uint64_t mOwnedBar = UINT64_MAX;
+
+        void pointAtOwned();
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <map>
+#include <tuple>
+
+#include "vm/bytecode.hpp"
+#include "vm/indicators.hpp"
+
+namespace Quartz {
+    // Deduplicates indicators across every strategy reading the same feed. Shareable call sites
+    // (see IndicatorSpec::shareable) are keyed by indicator, window and series, where a series is a
+    // feed column, a constant or another node, so sma(ema(price, 5), 20) in two strategies becomes
+    // two nodes rather than four. Each bar every unique node is updated once, in dependency order,
+    // and every call site bound to it reads the result.
+    //
+    // Strategies are added at load time, then link() allocates the state. The cost per bar scales
+    // with the number of unique indicators rather than the number of strategies.
+    class IndicatorGraph {
+    public:
+        // inputColumns maps the strategy's input slots to columns of the rows passed to update().
+        // Its shared call sites read from the graph from link() until unlink(), indicators has to
+        // outlive the graph or be relinked.
+        void addStrategy(const CompiledStrategy& strategy, const std::vector<uint32_t>& inputColumns, IndicatorSet& indicators);
+
+        // Allocates one instance of state per node and binds every added call site to its node
+        void link();
+
+        // Binds every call site back to its own state, before the graph goes away while the
+        // strategies' state stays around. Those call sites start over from no bars.
+        void unlink();
+
+        // Advances every node by one bar, row holds the feed's columns
+        void update(const double* row);
+
+        size_t nodeCount() const { return mNodes.size(); }
+        size_t callSiteCount() const { return mConsumers.size(); }
+
+    private:
+        struct Node {
+            IndicatorKind kind;
+            uint32_t window;
+            // Input operands index feed columns, Indicator operands index earlier nodes
+            IndicatorOperand operands[2];
+        };
+
+        using Key = std::tuple<uint32_t, uint32_t, uint8_t, uint32_t, double, uint8_t, uint32_t, double>;
+
+        struct Consumer {
+            IndicatorSet* indicators;
+            uint32_t callSite;
+            uint32_t node;
+        };
+
+        std::vector<Node> mNodes;
+        std::map<Key, uint32_t> mNodeIndices;
+        std::vector<Consumer> mConsumers;
+
+        IndicatorSet mState;
+        std::vector<double> mValues;
+
+        uint32_t addNode(const CompiledStrategy& strategy, const std::vector<uint32_t>& inputColumns, std::vector<uint32_t>& nodes, uint32_t callSite);
+    };
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "utils/interner.hpp"
+
+namespace Quartz {
+    // Streaming indicators callable from on_data(), every call site owns its own state. The numbering
+    // is part of the native ABI (QuartzIndicatorSpec::kind), only ever append to it.
+    enum class IndicatorKind : uint32_t {
+        Sma,        // sma(value, window): mean of the last window values
+        Ema,        // ema(value, window): exponential moving average with alpha 2 / (window + 1)
+        RollingStd, // rolling_std(value, window): population standard deviation of the last window values
+        RollingMin, // rolling_min(value, window)
+        RollingMax, // rolling_max(value, window)
+        Vwap,       // vwap(price, volume, window): volume weighted mean price of the last window bars
+
+        COUNT
+    };
+
+    struct IndicatorInfo {
+        const char* name;
+        IndicatorKind kind;
+        // Per bar arguments in front of the window, which always comes last
+        uint8_t seriesArguments;
+    };
+
+    // Null when name isn't an indicator
+    const IndicatorInfo* findIndicator(Symbol name);
+    const IndicatorInfo& indicatorInfo(IndicatorKind kind);
+
+    // Windows are sized once at load time, this keeps a typo from reserving gigabytes
+    constexpr uint32_t MAX_INDICATOR_WINDOW = 1 << 20;
+
+    // A series argument of an indicator call, as far as sharing its state is concerned
+    struct IndicatorOperand {
+        enum class Kind : uint8_t {
+            None,
+            Input,      // index: input slot
+            Indicator,  // index: call site of another shareable indicator
+            Constant,
+        };
+
+        Kind kind = Kind::None;
+        uint32_t index = 0;
+        double constant = 0.0;
+    };
+
+    // One call site, windows come from constant arguments so the state never grows
+    struct IndicatorSpec {
+        IndicatorKind kind;
+        uint32_t window;
+        // Set when the call runs on every bar and its series only depend on inputs, constants and
+        // other shareable indicators. Its value is then a pure function of the feed, so every
+        // strategy on the same feed can share one instance (see IndicatorGraph).
+        bool shareable = false;
+        IndicatorOperand operands[2] = {};
+    };
+
+    // Where each call site of a strategy keeps its state, computed once from its specs and shared
+    // by every IndicatorSet of the strategy
+    class IndicatorLayout {
+    public:
+        IndicatorLayout() = default;
+        explicit IndicatorLayout(const std::vector<IndicatorSpec>& specs);
+
+        size_t size() const { return mSlots.size(); }
+        // Ring buffer doubles and bar indices one set of call sites takes
+        size_t valueCount() const { return mValueCount; }
+        size_t barCount() const { return mBarCount; }
+
+    private:
+        friend class IndicatorSet;
+
+        struct Slot {
+            IndicatorKind kind;
+            uint32_t window;
+            // Offsets of the call site's rings in the values and bars
+            size_t values = 0;
+            size_t bars = 0;
+            double alpha = 0.0;
+        };
+
+        std::vector<Slot> mSlots;
+        size_t mValueCount = 0;
+        size_t mBarCount = 0;
+    };
+
+    // Running state of one call site, besides its rings
+    struct IndicatorCursor {
+        // Values in the window and the ring slot the next one goes to
+        uint32_t count = 0;
+        uint32_t next = 0;
+        double sum = 0.0;
+        double sum2 = 0.0;
+        double mean = 0.0;
+        // Deque front for min/max, bars seen so far
+        uint32_t head = 0;
+        uint64_t bar = 0;
+        const double* shared = nullptr;
+    };
+
+    // State of every indicator call site of a strategy. All ring buffers are allocated up front and
+    // every update is O(1): windowed sums are kept as running totals, recomputed from the ring each
+    // time it wraps so rounding can't drift, and min/max use a monotonic deque.
+    //
+    // A set either owns its state or views state laid out by someone else, a StateBlock keeps the
+    // state of many instances in a few shared arrays. Copying a view copies the view.
+    //
+    // Until a window has filled up indicators cover the values seen so far.
+    class IndicatorSet {
+    public:
+        IndicatorSet() = default;
+        // Owns its layout and state
+        explicit IndicatorSet(const std::vector<IndicatorSpec>& specs);
+        // Views state someone else owns: layout.size() cursors, layout.valueCount() values and
+        // layout.barCount() bars, all of which have to outlive the set
+        IndicatorSet(const IndicatorLayout& layout, IndicatorCursor* cursors, double* values, uint64_t* bars)
+            : mLayout(&layout), mCursors(cursors), mValues(values), mBars(bars) {}
+
+        IndicatorSet(const IndicatorSet& other) { *this = other; }
+        IndicatorSet(IndicatorSet&& other) noexcept { *this = std::move(other); }
+        IndicatorSet& operator=(const IndicatorSet& other);
+        IndicatorSet& operator=(IndicatorSet&& other) noexcept;
+
+        // Feeds the next bar to call site index and returns its current value, second is only read
+        // by indicators with two series arguments
+        double update(uint32_t index, double value, double second);
+
+        // From now on call site index returns *value instead of keeping its own state, the owner of
+        // value advances it before every bar
+        void share(uint32_t index, const double* value) { mCursors[index].shared = value; }
+
+        size_t size() const { return mLayout ? mLayout->size() : 0; }
+
+    private:
+        using Slot = IndicatorLayout::Slot;
+
+        const IndicatorLayout* mLayout = nullptr;
+        IndicatorCursor* mCursors = nullptr;
+        double* mValues = nullptr;
+        // Bar each min/max deque entry was added on, so expired entries can be dropped
+        uint64_t* mBars = nullptr;
+
+        // Set when the set owns its state
+        std::shared_ptr<const IndicatorLayout> mOwnedLayout;
+        std::vector<IndicatorCursor> mOwnedCursors;
+        std::vector<double> mOwnedValues;
+        std::vector<uint64_t> mOwnedBars;
+
+        void pointAtOwned();
+
+        double updateSum(const Slot& slot, IndicatorCursor& cursor, double value);
+        double updateStd(const Slot& slot, IndicatorCursor& cursor, double value);
+        double updateExtreme(const Slot& slot, IndicatorCursor& cursor, double value, bool maximum);
+        double updateVwap(const Slot& slot, IndicatorCursor& cursor, double price, double volume);
+    };
+
+    // IndicatorSet::update() behind a plain function pointer, called by JIT compiled code and
+    // compiled strategy libraries
+    double updateIndicator(void* indicators, uint32_t index, double value, double second);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "vm/bytecode.hpp"
+
+namespace Quartz {
+    // Native code for one on_data() function, lives in its own executable mapping
+    class JitCode {
+    public:
+        using Function = int32_t(*)(RawValue* frame, IndicatorSet* indicators, const double* history, uint64_t bar);
+
+        JitCode(void* memory, size_t size) : mMemory(memory), mSize(size) {}
+        ~JitCode();
+        JitCode(const JitCode&) = delete;
+        JitCode& operator=(const JitCode&) = delete;
+
+        Signal call(RawValue* frame, IndicatorSet* indicators, const InputHistory& history) const {
+            return static_cast<Signal>(reinterpret_cast<Function>(mMemory)(frame, indicators, history.values(), history.bar()));
+        }
+
+        size_t size() const { return mSize; }
+
+    private:
+        void* mMemory;
+        size_t mSize;
+    };
+
+    // In-process x86-64 code generator for bytecode that touches its frame and input history, updates
+    // indicators and emits signals
+    class JitCompiler {
+    public:
+        // False on hosts the emitter can't target, compile() always returns null there
+        static bool supported();
+
+        // Null when the host is unsupported or the function calls builtins, which need the
+        // execution context. Callers keep interpreting in that case.
+        static std::unique_ptr<JitCode> compile(const CompiledStrategy& strategy, const CompiledFunction& function);
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+// C ABI between the runner and strategies compiled ahead of time into shared objects.
+// Generated translation units start with this file, copied in at build time (see nativeAbiSource.hpp.in),
+// bump the version whenever it changes.
+#define QUARTZ_NATIVE_ABI_VERSION 3
+
+extern "C" {
+    // Callbacks into the runner, context is passed back untouched
+    struct QuartzHost {
+        void* context;
+        void (*addDataSource)(void* context, const char* ticker, const char* interval);
+    };
+
+    // Indicator state stays with the runner, one instance per entry of the strategy's indicators
+    struct QuartzIndicators {
+        void* state;
+        double (*update)(void* state, uint32_t index, double value, double second);
+    };
+
+    // A Quartz::IndicatorKind and its constant window
+    struct QuartzIndicatorSpec {
+        uint32_t kind;
+        uint32_t window;
+    };
+
+    // Input history rings laid out as in Quartz::InputHistory, bar is the index of the current bar
+    struct QuartzHistory {
+        const double* values;
+        uint64_t bar;
+    };
+
+    typedef void (*QuartzInitFunction)(const QuartzHost* host);
+    // Returns the emitted Quartz::Signal, inputs are indexed in inputNames order
+    typedef int32_t (*QuartzOnDataFunction)(const double* inputs, const QuartzIndicators* indicators, const QuartzHistory* history);
+
+    struct QuartzStrategyDescriptor {
+        const char* name;
+        uint32_t inputCount;
+        const char* const* inputNames;
+        uint32_t indicatorCount;
+        const QuartzIndicatorSpec* indicators;
+        // History ring capacity per input, 0 for inputs on_data() never looks back on
+        const uint32_t* historyCapacities;
+        QuartzInitFunction init;
+        QuartzOnDataFunction onData;
+    };
+
+    // Exported by every compiled strategy library
+    typedef uint32_t (*QuartzAbiVersionFunction)();
+    typedef const QuartzStrategyDescriptor* (*QuartzStrategiesFunction)(uint32_t* count);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "parser/flatAST.hpp"
+
+namespace Quartz {
+    // Ahead of time compiled mode: lowers every strategy in a program to a C++ translation unit
+    // exposing the C ABI in vm/nativeAbi.hpp and builds it into a shared object with the system compiler
+    class NativeCompiler {
+    public:
+        explicit NativeCompiler(const FlatAST& ast) : mAst(ast) {}
+
+        std::string emitSource();
+
+        // Uses $QUARTZ_CXX, then $CXX, then c++
+        static void buildSharedObject(const std::string& source, const std::string& outputPath);
+
+    private:
+        const FlatAST& mAst;
+        std::ostringstream mOut;
+
+        bool mInOnData = false;
+        int mIndent = 0;
+        // Frame slots below this are inputs, the rest are locals emitted as C++ variables
+        uint32_t mInputCount = 0;
+        // Layout of the history rings of the strategy being emitted (see InputHistory)
+        std::vector<uint32_t> mHistoryCapacities;
+        std::vector<uint32_t> mHistoryOffsets;
+
+        Symbol mEmitSignalSymbol = intern("emit_signal");
+        Symbol mDefineInputsSymbol = intern("define_input_variables");
+        Symbol mAddDataSourceSymbol = intern("add_data_source");
+
+        void emitConstant(NodeIndex constNode);
+        void emitStrategy(NodeIndex strategyNode, uint32_t index);
+        void emitFunction(NodeIndex functionNode, bool onData);
+        void emitStatement(NodeIndex node);
+        void emitBranch(NodeIndex node);
+        void emitExpression(NodeIndex node);
+        void emitConvertedExpression(NodeIndex node, ValueType type);
+        void emitCall(NodeIndex node);
+        void emitLiteral(const Value& value);
+
+        std::ostream& line();
+    };
+}
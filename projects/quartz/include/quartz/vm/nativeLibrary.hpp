@@ -0,0 +1,49 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "vm/builtins.hpp"
+#include "vm/history.hpp"
+#include "vm/indicators.hpp"
+#include "vm/nativeAbi.hpp"
+#include "vm/stateBlock.hpp"
+
+namespace Quartz {
+    // A shared object built by NativeCompiler, the library stays loaded for as long as this is alive
+    class NativeLibrary {
+    public:
+        static std::shared_ptr<NativeLibrary> open(const std::string& path);
+
+        ~NativeLibrary();
+        NativeLibrary(const NativeLibrary&) = delete;
+        NativeLibrary& operator=(const NativeLibrary&) = delete;
+
+        uint32_t strategyCount() const { return mStrategyCount; }
+        const QuartzStrategyDescriptor& strategy(uint32_t index) const { return mStrategies[index]; }
+
+        // Runs a strategy's init(), data sources it adds are recorded in the context
+        static void init(const QuartzStrategyDescriptor& strategy, ExecutionContext& context);
+
+        // Fresh state for every indicator call site of a strategy
+        static IndicatorSet createIndicators(const QuartzStrategyDescriptor& strategy);
+
+        // Empty rings sized for the lookbacks a strategy reads
+        static InputHistory createHistory(const QuartzStrategyDescriptor& strategy);
+
+        // Sizes of a strategy's per instance state, compiled strategies keep their frame to themselves
+        static StateLayout stateLayout(const QuartzStrategyDescriptor& strategy);
+
+        static Signal onData(const QuartzStrategyDescriptor& strategy, const double* inputs, IndicatorSet& indicators, const InputHistory& history) {
+            const QuartzIndicators callbacks = { &indicators, updateIndicator };
+            const QuartzHistory past = { history.values(), history.bar() };
+            return static_cast<Signal>(strategy.onData(inputs, &callbacks, &past));
+        }
+
+    private:
+        void* mHandle = nullptr;
+        const QuartzStrategyDescriptor* mStrategies = nullptr;
+        uint32_t mStrategyCount = 0;
+
+        NativeLibrary() = default;
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "vm/bytecode.hpp"
+#include "vm/history.hpp"
+#include "vm/indicators.hpp"
+
+namespace Quartz {
+    // Sizes of everything one instance of a strategy changes as on_data() runs. Built once per
+    // strategy and only read after that, every StateBlock of the strategy points at it.
+    class StateLayout {
+    public:
+        StateLayout(uint32_t frameSize, const std::vector<IndicatorSpec>& indicators, const std::vector<uint32_t>& historyCapacities)
+            : mFrameSize(frameSize), mIndicators(indicators), mHistory(historyCapacities) {}
+        explicit StateLayout(const CompiledStrategy& strategy)
+            : StateLayout(strategy.frameSize, strategy.indicators, strategy.historyCapacities) {}
+
+        uint32_t frameSize() const { return mFrameSize; }
+        const IndicatorLayout& indicators() const { return mIndicators; }
+        const HistoryLayout& history() const { return mHistory; }
+
+        // What each instance adds to a StateBlock
+        size_t instanceBytes() const;
+
+    private:
+        uint32_t mFrameSize;
+        IndicatorLayout mIndicators;
+        HistoryLayout mHistory;
+    };
+
+    // One instance's state as on_data() sees it, a view into a StateBlock. Copies view the same state.
+    struct StrategyState {
+        // Slot resolved variables of the bytecode, inputs first (see CompiledStrategy::frameSize)
+        RawValue* frame = nullptr;
+        // One instance per indicator call site in on_data()
+        IndicatorSet indicators;
+        // Past values of the inputs on_data() looks back on
+        InputHistory history;
+    };
+
+    // The state of count instances of one strategy, say one per symbol it trades. Laid out struct of
+    // arrays, one array per kind of state with the instances back to back in it, so an instance costs
+    // only its state bytes and the code, constants and layout are never copied. Each instance's frame
+    // stays contiguous as the VM and compiled code address it by slot.
+    //
+    // Everything is allocated up front, moving a block keeps instance() views valid.
+    class StateBlock {
+    public:
+        StateBlock() = default;
+        // Every frame starts as a copy of initialFrame (say, what init() left), zeroed when null
+        StateBlock(std::shared_ptr<const StateLayout> layout, size_t count, const RawValue* initialFrame = nullptr);
+
+        size_t size() const { return mCount; }
+        const StateLayout& layout() const { return *mLayout; }
+
+        // View of instance index, valid for as long as the block
+        StrategyState instance(size_t index);
+
+        // Heap the block's state takes, not counting the shared layout
+        size_t bytes() const;
+
+    private:
+        std::shared_ptr<const StateLayout> mLayout;
+        size_t mCount = 0;
+
+        std::vector<RawValue> mFrames;
+        std::vector<IndicatorCursor> mCursors;
+        std::vector<double> mIndicatorValues;
+        std::vector<uint64_t> mIndicatorBars;
+        std::vector<double> mHistoryValues;
+        std::vector<uint64_t> mHistoryBars;
+    };
+}
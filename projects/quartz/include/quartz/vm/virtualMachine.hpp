@@ -0,0 +1,18 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "vm/builtins.hpp"
+
+namespace Quartz {
+    // Executes compiled strategy functions. The register file is reused between calls so running
+    // on_data doesn't allocate once it has been sized for the largest function.
+    class VirtualMachine {
+    public:
+        // Runs a function to its RETURN and yields the last signal it emitted, HOLD if it emitted none
+        Signal execute(const CompiledStrategy& strategy, const CompiledFunction& function, ExecutionContext& context);
+
+    private:
+        std::vector<RawValue> mRegisters;
+    };
+}
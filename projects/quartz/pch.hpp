@@ -5,6 +5,10 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
 #include <unordered_map>
 #include <any>
 #include <fstream>
@@ -13,4 +17,6 @@
 #include <ctime>
 #include <iomanip>
 #include <memory>
-#include <mutex>
\ No newline at end of file
+#include <mutex>
+#include <shared_mutex>
+#include <charconv>
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "data/barFile.hpp"
+
+#include "logging/logging.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Quartz {
+	namespace {
+		uint64_t alignUp(uint64_t offset)
+		{
+			return (offset + BAR_FILE_ALIGNMENT - 1) / BAR_FILE_ALIGNMENT * BAR_FILE_ALIGNMENT;
+		}
+
+		[[noreturn]] void throwBarFileError(const std::string& path, const std::string& message)
+		{
+			Logger::getInstance().throwException(std::runtime_error("Bar file " + path + ": " + message));
+		}
+
+		void copyName(char* destination, size_t capacity, const std::string& name, const std::string& path, const char* field)
+		{
+			if (name.size() >= capacity)
+				throwBarFileError(path, std::string(field) + " '" + name + "' is longer than " + std::to_string(capacity - 1) + " characters");
+			std::memcpy(destination, name.data(), name.size());
+		}
+	}
+
+	const char* barColumnName(BarColumn column)
+	{
+		switch (column)
+		{
+		case BarColumn::Open: return "open";
+		case BarColumn::High: return "high";
+		case BarColumn::Low: return "low";
+		case BarColumn::Close: return "close";
+		case BarColumn::Volume: return "volume";
+		default: return "<INVALID>";
+		}
+	}
+
+	void writeBarFile(const std::string& path, const BarTable& table)
+	{
+		const uint64_t rows = table.timestamps.size();
+		for (const std::vector<double>& column : table.columns) {
+			if (column.size() != rows)
+				throwBarFileError(path, "every column needs one value per timestamp");
+		}
+
+		BarFileHeader header = {};
+		std::memcpy(header.magic, BAR_FILE_MAGIC, sizeof(header.magic));
+		header.version = BAR_FILE_VERSION;
+		header.headerSize = sizeof(BarFileHeader);
+		copyName(header.symbol, sizeof(header.symbol), table.symbol, path, "symbol");
+		copyName(header.interval, sizeof(header.interval), table.interval, path, "interval");
+		header.rowCount = rows;
+
+		uint64_t offset = alignUp(sizeof(BarFileHeader));
+		header.timestampOffset = offset;
+		offset = alignUp(offset + rows * sizeof(int64_t));
+		for (uint64_t& columnOffset : header.columnOffsets) {
+			columnOffset = offset;
+			offset = alignUp(offset + rows * sizeof(double));
+		}
+
+		std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			throwBarFileError(path, std::string("failed to open for writing: ") + std::strerror(errno));
+
+		uint64_t written = 0;
+		auto writeAt = [&](uint64_t at, const void* data, uint64_t size) {
+			static const char padding[BAR_FILE_ALIGNMENT] = {};
+			file.write(padding, static_cast<std::streamsize>(at - written));
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			written = at + size;
+		};
+		writeAt(0, &header, sizeof(header));
+		writeAt(header.timestampOffset, table.timestamps.data(), rows * sizeof(int64_t));
+		for (size_t i = 0; i < static_cast<size_t>(BarColumn::COUNT); ++i)
+			writeAt(header.columnOffsets[i], table.columns[i].data(), rows * sizeof(double));
+
+		if (!file)
+			throwBarFileError(path, "write failed");
+	}
+
+	std::unique_ptr<BarFile> BarFile::open(const std::string& path)
+	{
+#if defined(_WIN32)
+		throwBarFileError(path, "memory mapped bar files are not supported on Windows yet");
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throwBarFileError(path, std::string("failed to open: ") + std::strerror(errno));
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < sizeof(BarFileHeader)) {
+			::close(fd);
+			throwBarFileError(path, "too small to be a bar file");
+		}
+
+		// Shared so every process backtesting the same file reads the same physical pages
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (data == MAP_FAILED)
+			throwBarFileError(path, std::string("failed to map: ") + std::strerror(errno));
+
+		std::unique_ptr<BarFile> file(new BarFile());
+		file->mData = static_cast<const uint8_t*>(data);
+		file->mSize = static_cast<size_t>(info.st_size);
+
+		const BarFileHeader& header = file->header();
+		if (std::memcmp(header.magic, BAR_FILE_MAGIC, sizeof(header.magic)) != 0)
+			throwBarFileError(path, "not a quartz bar file");
+		if (header.version != BAR_FILE_VERSION || header.headerSize != sizeof(BarFileHeader))
+			throwBarFileError(path, "unsupported bar file version " + std::to_string(header.version));
+		if (std::memchr(header.symbol, '\0', sizeof(header.symbol)) == nullptr || std::memchr(header.interval, '\0', sizeof(header.interval)) == nullptr)
+			throwBarFileError(path, "corrupt header");
+
+		// Every column has to lie inside the mapping and be aligned for its element type
+		const uint64_t columnBytes = header.rowCount * sizeof(double);
+		if (header.rowCount > file->mSize / sizeof(double))
+			throwBarFileError(path, "row count exceeds the file size");
+		auto checkColumn = [&](uint64_t offset) {
+			if (offset % BAR_FILE_ALIGNMENT != 0 || offset > file->mSize || file->mSize - offset < columnBytes)
+				throwBarFileError(path, "column extends past the end of the file");
+		};
+		checkColumn(header.timestampOffset);
+		for (uint64_t offset : header.columnOffsets)
+			checkColumn(offset);
+
+		// Backtests stream every column front to back
+		madvise(data, file->mSize, MADV_SEQUENTIAL);
+		return file;
+#endif
+	}
+
+	BarFile::~BarFile()
+	{
+#if !defined(_WIN32)
+		if (mData)
+			munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+	}
+}
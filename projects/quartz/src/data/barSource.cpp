@@ -0,0 +1,59 @@
+#include "data/barSource.hpp"
+
+#include <filesystem>
+
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	std::string BarSource::find(const std::string& dataDirectory, const std::string& ticker, const std::string& interval)
+	{
+		const std::filesystem::path directory(dataDirectory);
+		for (const char* extension : { ".qzb", ".csv" }) {
+			if (!interval.empty()) {
+				std::filesystem::path path = directory / (ticker + "_" + interval + extension);
+				if (std::filesystem::exists(path))
+					return path.string();
+			}
+			std::filesystem::path path = directory / (ticker + extension);
+			if (std::filesystem::exists(path))
+				return path.string();
+		}
+
+		Logger::getInstance().throwException(std::runtime_error("No bar file for " + ticker +
+			(interval.empty() ? "" : " (" + interval + ")") + " in " + dataDirectory));
+	}
+
+	void BarSource::load(const std::string& path, const std::vector<Symbol>& columns)
+	{
+		mBarFile.reset();
+		mCsv = CsvColumns();
+		mColumns.clear();
+
+		if (path.size() <= 4 || path.compare(path.size() - 4, 4, ".qzb") != 0) {
+			std::vector<std::string> names;
+			for (Symbol column : columns)
+				names.emplace_back(symbolName(column));
+			mCsv = loadCsvColumns(path.c_str(), names);
+			for (const std::vector<double>& values : mCsv.values)
+				mColumns.push_back(values.data());
+			mRows = mCsv.rows;
+			return;
+		}
+
+		mBarFile = BarFile::open(path);
+		for (Symbol input : columns) {
+			const std::string_view name = symbolName(input);
+			BarColumn column = BarColumn::COUNT;
+			for (uint32_t i = 0; i < static_cast<uint32_t>(BarColumn::COUNT); ++i) {
+				if (name == barColumnName(static_cast<BarColumn>(i)))
+					column = static_cast<BarColumn>(i);
+			}
+			if (name == "price")
+				column = BarColumn::Close;
+			if (column == BarColumn::COUNT)
+				Logger::getInstance().throwException(std::runtime_error(path + ": bar files have no column for input variable " + std::string(name)));
+			mColumns.push_back(mBarFile->column(column).data);
+		}
+		mRows = mBarFile->rowCount();
+	}
+}
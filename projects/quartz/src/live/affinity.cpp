@@ -0,0 +1,46 @@
+#include "live/affinity.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Quartz {
+	std::vector<unsigned> availableCores()
+	{
+		std::vector<unsigned> cores;
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			for (unsigned core = 0; core < CPU_SETSIZE; ++core) {
+				if (CPU_ISSET(core, &set))
+					cores.push_back(core);
+			}
+		}
+#endif
+		if (cores.empty()) {
+			for (unsigned core = 0; core < std::max(1u, std::thread::hardware_concurrency()); ++core)
+				cores.push_back(core);
+		}
+		return cores;
+	}
+
+	bool pinCurrentThread(unsigned core)
+	{
+#if defined(__linux__)
+		if (core >= CPU_SETSIZE)
+			return false;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		(void)core;
+		return false;
+#endif
+	}
+}
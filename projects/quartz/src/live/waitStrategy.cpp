@@ -0,0 +1,34 @@
+#include "live/waitStrategy.hpp"
+
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Quartz {
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+		"Futexes wait on the atomic's own storage");
+
+	void FutexWait::futexWait(std::atomic<uint32_t>* word, uint32_t expected)
+	{
+#if defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+		(void)word;
+		(void)expected;
+		std::this_thread::yield();
+#endif
+	}
+
+	void FutexWait::futexWake(std::atomic<uint32_t>* word)
+	{
+#if defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+		(void)word;
+#endif
+	}
+}
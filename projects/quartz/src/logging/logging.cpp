@@ -8,12 +8,6 @@ void Quartz::Logger::log(Level level, const std::string& message)
     }
 }
 
-void Quartz::Logger::throwException(const std::exception& exception)
-{
-    logf(FATAL, "Exception: %s", exception.what());
-    throw exception;
-}
-
 std::string Quartz::Logger::getCurrentTime()
 {
     std::time_t now = std::time(nullptr);
@@ -0,0 +1,230 @@
+#include "parser/flatAST.hpp"
+
+#include <algorithm>
+
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	namespace {
+		// A node waiting to be flattened, either a tree node or the literal value of a const declaration
+		struct PendingNode {
+			const ASTNode* node;
+			const Value* constValue;
+		};
+
+		class FlatASTPrinter : public FlatASTVisitor<FlatASTPrinter> {
+		public:
+			using FlatASTVisitor::FlatASTVisitor;
+
+			void visit(NodeIndex node) {
+				for (int i = 0; i < mDepth; ++i)
+					std::cout << "  ";
+				std::cout << "[" << node << "] ";
+				switch (mAst.kinds[node]) {
+				case NodeType::Program: std::cout << "Program"; break;
+				case NodeType::ConstDecl: std::cout << "ConstDecl " << symbolName(mAst.name(node)); break;
+				case NodeType::Strategy: std::cout << "Strategy " << symbolName(mAst.name(node)); break;
+				case NodeType::StrategyInitFunction: std::cout << "StrategyInit"; break;
+				case NodeType::StrategyOnDataFunction: std::cout << "StrategyOnData"; break;
+				case NodeType::FunctionDecl: std::cout << "FunctionDecl " << symbolName(mAst.name(node)); break;
+				case NodeType::Block: std::cout << "Block"; break;
+				case NodeType::ExprStmt: std::cout << "ExprStmt"; break;
+				case NodeType::VarDecl: std::cout << "VarDecl " << symbolName(mAst.name(node)); break;
+				case NodeType::AssignStmt: std::cout << "AssignStmt " << symbolName(mAst.name(node)); break;
+				case NodeType::Signal: std::cout << "Signal " << signalToString(mAst.signal(node)); break;
+				case NodeType::IfStmt: std::cout << "IfStmt"; break;
+				case NodeType::ReturnStmt: std::cout << "ReturnStmt"; break;
+				case NodeType::CallExpr: std::cout << "CallExpr " << symbolName(mAst.name(node)); break;
+				case NodeType::BinaryExpr: std::cout << "BinaryExpr " << tokenTypeToString(mAst.tokenType(node)); break;
+				case NodeType::IdentifierExpr: std::cout << "IdentifierExpr " << symbolName(mAst.name(node)); break;
+				case NodeType::IndexExpr: std::cout << "IndexExpr " << symbolName(mAst.name(node)); break;
+				case NodeType::LiteralExpr: std::cout << "LiteralExpr " << mAst.value(node).toString(); break;
+				}
+				if (mAst.typed() && mAst.type(node) != ValueType::None)
+					std::cout << " : " << typeName(mAst.type(node));
+				std::cout << "\n";
+
+				mDepth++;
+				FlatASTVisitor::visit(node);
+				mDepth--;
+			}
+
+		private:
+			int mDepth = 0;
+		};
+
+		class InputCollector : public FlatASTVisitor<InputCollector> {
+		public:
+			using FlatASTVisitor::FlatASTVisitor;
+
+			void visitCallExpr(NodeIndex node) {
+				if (mAst.name(node) != mDefineInputs) {
+					visitChildren(node);
+					return;
+				}
+				for (uint32_t i = 0; i < mAst.childCount[node]; ++i) {
+					NodeIndex argument = mAst.child(node, i);
+					if (mAst.kinds[argument] != NodeType::IdentifierExpr)
+						Logger::getInstance().throwException(std::runtime_error("define_input_variables() only accepts variable names"));
+					if (std::find(inputs.begin(), inputs.end(), mAst.name(argument)) == inputs.end())
+						inputs.push_back(mAst.name(argument));
+				}
+			}
+
+			std::vector<Symbol> inputs;
+
+		private:
+			Symbol mDefineInputs = intern("define_input_variables");
+		};
+	}
+
+	std::vector<Symbol> FlatAST::inputVariables(NodeIndex node) const
+	{
+		InputCollector collector(*this);
+		collector.visit(node);
+		return std::move(collector.inputs);
+	}
+
+	FlatAST FlatAST::fromProgram(std::shared_ptr<const ProgramNode> program)
+	{
+		FlatAST ast;
+		ast.mProgram = program;
+
+		// Breadth first: node i is flattened when the loop reaches it, at which point its
+		// children are appended as one contiguous range at the end of the arrays
+		std::vector<PendingNode> pending;
+		pending.push_back({ program.get(), nullptr });
+
+		auto addValue = [&ast](const Value& value) {
+			ast.values.push_back(value);
+			return static_cast<uint32_t>(ast.values.size() - 1);
+		};
+		auto addChild = [&pending](const ASTNode* child) {
+			pending.push_back({ child, nullptr });
+		};
+
+		for (size_t i = 0; i < pending.size(); ++i) {
+			const PendingNode current = pending[i];
+			Symbol name = INVALID_SYMBOL;
+			uint32_t payload = NO_PAYLOAD;
+			const uint32_t firstChild = static_cast<uint32_t>(pending.size());
+
+			if (!current.node) {
+				ast.kinds.push_back(NodeType::LiteralExpr);
+				payload = addValue(*current.constValue);
+			}
+			else {
+				const NodeType kind = current.node->nodeType();
+				ast.kinds.push_back(kind);
+				switch (kind) {
+				case NodeType::Program:
+					for (const ASTNode* declaration : static_cast<const ProgramNode*>(current.node)->declarations)
+						addChild(declaration);
+					break;
+				case NodeType::ConstDecl: {
+					auto node = static_cast<const ConstDeclNode*>(current.node);
+					name = node->name;
+					payload = node->type;
+					pending.push_back({ nullptr, &node->value });
+					break;
+				}
+				case NodeType::Strategy: {
+					auto node = static_cast<const StrategyNode*>(current.node);
+					name = node->name;
+					for (const ASTNode* statement : node->body)
+						addChild(statement);
+					if (node->initNode)
+						addChild(node->initNode);
+					if (node->onDataNode)
+						addChild(node->onDataNode);
+					break;
+				}
+				case NodeType::StrategyInitFunction:
+				case NodeType::StrategyOnDataFunction:
+				case NodeType::FunctionDecl: {
+					auto node = static_cast<const FunctionDeclNode*>(current.node);
+					name = node->name;
+					payload = node->returnType;
+					if (node->body)
+						addChild(node->body);
+					break;
+				}
+				case NodeType::Block:
+					for (const ASTNode* statement : static_cast<const BlockNode*>(current.node)->statements)
+						addChild(statement);
+					break;
+				case NodeType::ExprStmt:
+					addChild(static_cast<const ExprStmtNode*>(current.node)->expression);
+					break;
+				case NodeType::VarDecl: {
+					auto node = static_cast<const VarDeclNode*>(current.node);
+					name = node->name;
+					payload = node->type;
+					addChild(node->initializer);
+					break;
+				}
+				case NodeType::AssignStmt: {
+					auto node = static_cast<const AssignStmtNode*>(current.node);
+					name = node->name;
+					addChild(node->value);
+					break;
+				}
+				case NodeType::Signal:
+					payload = static_cast<const SignalNode*>(current.node)->signal;
+					break;
+				case NodeType::IfStmt: {
+					auto node = static_cast<const IfStmtNode*>(current.node);
+					addChild(node->condition);
+					addChild(node->thenBlock);
+					if (node->elseBranch)
+						addChild(node->elseBranch);
+					break;
+				}
+				case NodeType::ReturnStmt:
+					break;
+				case NodeType::CallExpr: {
+					auto node = static_cast<const CallExprNode*>(current.node);
+					name = node->callee;
+					for (const ASTNode* argument : node->arguments)
+						addChild(argument);
+					break;
+				}
+				case NodeType::BinaryExpr: {
+					auto node = static_cast<const BinaryExprNode*>(current.node);
+					payload = node->op;
+					addChild(node->left);
+					addChild(node->right);
+					break;
+				}
+				case NodeType::IdentifierExpr:
+					name = static_cast<const IdentifierExprNode*>(current.node)->name;
+					break;
+				case NodeType::IndexExpr: {
+					auto node = static_cast<const IndexExprNode*>(current.node);
+					name = node->name;
+					addChild(node->index);
+					break;
+				}
+				case NodeType::LiteralExpr:
+					payload = addValue(static_cast<const LiteralExprNode*>(current.node)->value);
+					break;
+				}
+			}
+
+			ast.names.push_back(name);
+			ast.payloads.push_back(payload);
+			ast.firstChild.push_back(firstChild);
+			ast.childCount.push_back(static_cast<uint32_t>(pending.size()) - firstChild);
+		}
+
+		return ast;
+	}
+
+	void FlatAST::print() const
+	{
+		if (size() == 0)
+			return;
+		FlatASTPrinter printer(*this);
+		printer.visit(0);
+	}
+}
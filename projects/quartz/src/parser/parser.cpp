@@ -1,5 +1,33 @@
 #include "parser/parser.hpp"
 
+Quartz::Value Quartz::Parser::literalValue(const Token& token)
+{
+    switch (token.Type) {
+    case INT_VALUE:
+        return Value(mTokens.literal(token).IntValue);
+    case FLOAT_VALUE:
+        return Value(mTokens.literal(token).FloatValue);
+    case STRING_VALUE:
+        return Value(copyText(token));
+    default:
+        return Value();
+    }
+}
+
+Quartz::Symbol Quartz::Parser::symbolOf(const Token& token)
+{
+    if (token.Type != IDENTIFIER)
+        throwUnexpectedToken(token);
+    return token.Value;
+}
+
+Quartz::NodeList Quartz::Parser::takeScratch(size_t mark)
+{
+    NodeList list = mProgram->arena.copyArray(mScratch.data() + mark, mScratch.size() - mark);
+    mScratch.resize(mark);
+    return list;
+}
+
 bool Quartz::Parser::match(TokenType type)
 {
     if (!isAtEnd() && peek().Type == type) {
@@ -9,124 +37,115 @@ bool Quartz::Parser::match(TokenType type)
     return false;
 }
 
-std::unique_ptr<Quartz::ProgramNode> Quartz::Parser::parseProgram()
+void Quartz::Parser::parseProgram()
 {
-    auto program = std::make_unique<ProgramNode>();
+    size_t mark = mScratch.size();
     while (!isAtEnd()) {
-        Token currToken = peek();
-        if (currToken.Type == KEYWORD_STRATEGY)
-            program->declarations.push_back(parseStrategy());
-        else if (currToken.Type == KEYWORD_CONST)
-            program->declarations.push_back(parseConstDeclaration());
+        TokenType type = peek().Type;
+        if (type == KEYWORD_STRATEGY)
+            mScratch.push_back(parseStrategy());
+        else if (type == KEYWORD_CONST)
+            mScratch.push_back(parseConstDeclaration());
         else
             advance();
     }
-    return program;
+    mProgram->declarations = takeScratch(mark);
 }
 
-std::unique_ptr<Quartz::StrategyNode> Quartz::Parser::parseStrategy()
+Quartz::StrategyNode* Quartz::Parser::parseStrategy()
 {
     advance(); // consume 'strategy'
-    Token nameToken = advance(); // strategy name (IDENTIFIER)
-    std::string strategyName = std::any_cast<std::string>(nameToken.Data);
-    auto strategy = std::make_unique<StrategyNode>(strategyName);
+    auto strategy = make<StrategyNode>(symbolOf(advance())); // strategy name (IDENTIFIER)
     match(OPEN_CURLY_BRACE);
     // Parse declarations inside strategy: consts and functions (init, on_data, etc.)
+    size_t mark = mScratch.size();
     while (!match(CLOSE_CURLY_BRACE) && !isAtEnd()) {
-        Quartz::Token token = peek();
-        if (token.Type == KEYWORD_CONST)
-            strategy->body.push_back(parseConstDeclaration());
-        else if (token.Type == IDENTIFIER)
+        TokenType type = peek().Type;
+        if (type == KEYWORD_CONST)
+            mScratch.push_back(parseConstDeclaration());
+        else if (type == IDENTIFIER)
         {
-            auto& functionNode = parseFunctionDeclaration();
+            FunctionDeclNode* functionNode = parseFunctionDeclaration();
             switch (functionNode->nodeType()) {
-            case NodeType::StrategyInitFunction: {
-                std::unique_ptr<StrategyInitNode> initNode{static_cast<StrategyInitNode*>(functionNode.release())};
-                strategy->initNode = std::move(initNode);
+            case NodeType::StrategyInitFunction:
+                strategy->initNode = static_cast<StrategyInitNode*>(functionNode);
                 break;
-            }
-            case NodeType::StrategyOnDataFunction: {
-                std::unique_ptr<StrategyOnDataNode> onDataNode{static_cast<StrategyOnDataNode*>(functionNode.release())};
-                strategy->onDataNode = std::move(onDataNode);
+            case NodeType::StrategyOnDataFunction:
+                strategy->onDataNode = static_cast<StrategyOnDataNode*>(functionNode);
                 break;
-            }
             default:
-                strategy->body.push_back(std::move(functionNode));
+                mScratch.push_back(functionNode);
                 break;
             }
         }
         else
             advance();
     }
+    strategy->body = takeScratch(mark);
     return strategy;
 }
 
-std::unique_ptr<Quartz::ConstDeclNode> Quartz::Parser::parseConstDeclaration()
+Quartz::ConstDeclNode* Quartz::Parser::parseConstDeclaration()
 {
     advance(); // consume 'const'
-    Token id = advance(); // identifier
-    std::string name = std::any_cast<std::string>(id.Data);
+    Symbol name = symbolOf(advance()); // identifier
     TokenType type = NONE;
     if (match(COLON)) {
-        Token typeToken = advance(); // type (e.g., STRING_KEYWORD or INT_KEYWORD)
-        type = typeToken.Type;
+        type = advance().Type; // type (e.g., STRING_KEYWORD or INT_KEYWORD)
     }
     match(EQUALS);
-    Token valueToken = advance(); // literal value
-    std::string value = std::any_cast<std::string>(valueToken.Data);
+    Value value = literalValue(advance()); // literal value
     match(SEMI_COLON);
-    return std::make_unique<ConstDeclNode>(name, type, value);
+    return make<ConstDeclNode>(name, type, value);
 }
 
-std::unique_ptr<Quartz::FunctionDeclNode> Quartz::Parser::parseFunctionDeclaration()
+Quartz::FunctionDeclNode* Quartz::Parser::parseFunctionDeclaration()
 {
-    Token nameToken = advance(); // function name (e.g., init, on_data)
-    std::string funcName = std::any_cast<std::string>(nameToken.Data);
+    Symbol funcName = symbolOf(advance()); // function name (e.g., init, on_data)
     match(OPEN_BRACKET); // consume '('
     match(CLOSE_BRACKET); // consume ')'
     match(RIGHT_ARROW); // consume '->'
-    Token returnTypeToken = advance(); // return type (e.g., VOID_KEYWORD)
+    TokenType returnType = advance().Type; // return type (e.g., VOID_KEYWORD)
     auto body = parseBlock();
-    if (funcName == "init") {
-        return std::make_unique<StrategyInitNode>(returnTypeToken.Type, std::move(body));
+    if (funcName == mInitSymbol) {
+        return make<StrategyInitNode>(returnType, body);
     }
-    else if (funcName == "on_data") {
-        return std::make_unique<StrategyOnDataNode>(returnTypeToken.Type, std::move(body));
+    else if (funcName == mOnDataSymbol) {
+        return make<StrategyOnDataNode>(returnType, body);
     }
-    return std::make_unique<FunctionDeclNode>(funcName, returnTypeToken.Type, std::move(body));
+    return make<FunctionDeclNode>(funcName, returnType, body);
 }
 
-std::unique_ptr<Quartz::BlockNode> Quartz::Parser::parseBlock()
+Quartz::BlockNode* Quartz::Parser::parseBlock()
 {
     match(OPEN_CURLY_BRACE);
-    auto block = std::make_unique<BlockNode>();
+    size_t mark = mScratch.size();
     while (!match(CLOSE_CURLY_BRACE) && !isAtEnd()) {
-        if (match(KEYWORD_IF)) {
-            block->statements.push_back(parseIfStatement());
-        }
-        else {
-            block->statements.push_back(parseStatement());
-        }
+        mScratch.push_back(parseStatement());
     }
-    return block;
+    return make<BlockNode>(takeScratch(mark));
 }
 
-std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parseStatement()
+Quartz::ASTNode* Quartz::Parser::parseStatement()
 {
-    auto& nextToken = peek();
-    if (nextToken.Type == KEYWORD_IF)
+    TokenType type = peek().Type;
+    if (type == KEYWORD_IF)
         return parseIfStatement();
-    else if (nextToken.Type == KEYWORD_RETURN) {
+    else if (type == KEYWORD_RETURN) {
         advance(); // consume 'return'
         match(SEMI_COLON);
-        return std::make_unique<ReturnStmtNode>();
+        return make<ReturnStmtNode>();
     }
+    else if (type == KEYWORD_VAR)
+        return parseVarDeclaration();
+    else if (type == IDENTIFIER && mTokens.peek(1).Type == EQUALS)
+        return parseAssignment();
     else {
         return parseExpressionStatement();
     }
 }
 
-std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parseIfStatement()
+Quartz::ASTNode* Quartz::Parser::parseIfStatement()
 {
     advance(); // consume 'if'
     match(OPEN_BRACKET);
@@ -134,11 +153,11 @@ std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parseIfStatement()
     match(CLOSE_BRACKET);
     auto thenBlock = parseBlock();
 
-    std::unique_ptr<ASTNode> elseBranch = nullptr;
+    ASTNode* elseBranch = nullptr;
 
     if (peek().Type == KEYWORD_ELSE) {
         advance(); // consume 'else'
-        if (match(KEYWORD_IF)) { // else if case
+        if (peek().Type == KEYWORD_IF) { // else if case
             elseBranch = parseIfStatement(); // Recursively parse "else if"
         }
         else {
@@ -146,58 +165,93 @@ std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parseIfStatement()
         }
     }
 
-    return std::make_unique<IfStmtNode>(std::move(condition), std::move(thenBlock), std::move(elseBranch));
+    return make<IfStmtNode>(condition, thenBlock, elseBranch);
 }
 
-std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parseExpressionStatement()
+Quartz::ASTNode* Quartz::Parser::parseVarDeclaration()
+{
+    advance(); // consume 'var'
+    Symbol name = symbolOf(advance()); // identifier
+    TokenType type = NONE;
+    if (match(COLON)) {
+        type = advance().Type; // type (e.g., FLOAT_KEYWORD)
+    }
+    if (!match(EQUALS))
+        throwUnexpectedToken(peek());
+    auto initializer = parseExpression();
+    match(SEMI_COLON);
+    return make<VarDeclNode>(name, type, initializer);
+}
+
+Quartz::ASTNode* Quartz::Parser::parseAssignment()
+{
+    Symbol name = symbolOf(advance()); // identifier
+    advance(); // consume '='
+    auto value = parseExpression();
+    match(SEMI_COLON);
+    return make<AssignStmtNode>(name, value);
+}
+
+Quartz::ASTNode* Quartz::Parser::parseExpressionStatement()
 {
     auto expr = parseExpression();
     match(SEMI_COLON);
-    return std::make_unique<ExprStmtNode>(std::move(expr));
+    return make<ExprStmtNode>(expr);
 }
 
-std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parseExpression()
+Quartz::ASTNode* Quartz::Parser::parseExpression()
 {
     auto left = parsePrimary();
     while (peek().Type == GREATER_THAN || peek().Type == LESS_THAN) {
-        Token op = advance();
+        TokenType op = advance().Type;
         auto right = parsePrimary();
-        left = std::make_unique<BinaryExprNode>(std::move(left), op, std::move(right));
+        left = make<BinaryExprNode>(left, op, right);
     }
     return left;
 }
 
-std::unique_ptr<Quartz::ASTNode> Quartz::Parser::parsePrimary()
+Quartz::ASTNode* Quartz::Parser::parsePrimary()
 {
     if (peek().Type == IDENTIFIER) {
-        Token id = advance();
-        std::string name = std::any_cast<std::string>(id.Data);
+        Symbol name = symbolOf(advance());
         // Check for function call (arguments in parentheses)
         if (match(OPEN_BRACKET)) {
-            std::vector<std::unique_ptr<ASTNode>> args;
+            size_t mark = mScratch.size();
             while (!match(CLOSE_BRACKET) && !isAtEnd()) {
-                args.push_back(parseExpression());
+                mScratch.push_back(parseExpression());
                 match(COMMA); // Comma between arguments
             }
-            return std::make_unique<CallExprNode>(name, std::move(args));
+            return make<CallExprNode>(name, takeScratch(mark));
+        }
+        // History lookback, name[1] is the previous bar's value
+        if (match(OPEN_SQUARE_BRACKET)) {
+            auto index = parseExpression();
+            if (!match(CLOSE_SQUARE_BRACKET))
+                throwUnexpectedToken(peek());
+            return make<IndexExprNode>(name, index);
         }
-        return std::make_unique<IdentifierExprNode>(name);
+        return make<IdentifierExprNode>(name);
     }
-    else if (peek().Type == STRING_VALUE || peek().Type == INT_VALUE) {
-        Token lit = advance();
-        return std::make_unique<LiteralExprNode>(std::any_cast<std::string>(lit.Data));
+    else if (peek().Type == STRING_VALUE || peek().Type == INT_VALUE || peek().Type == FLOAT_VALUE) {
+        return make<LiteralExprNode>(literalValue(advance()));
     }
     else if (peek().Type == KEYWORD_BUY) {
         advance();
-        return std::make_unique<SignalNode>(BUY);
+        return make<SignalNode>(BUY);
     }
     else if (peek().Type == KEYWORD_HOLD) {
         advance();
-        return std::make_unique<SignalNode>(HOLD);
+        return make<SignalNode>(HOLD);
     }
     else if (peek().Type == KEYWORD_SELL) {
         advance();
-        return std::make_unique<SignalNode>(SELL);
+        return make<SignalNode>(SELL);
     }
-    return nullptr;
+    throwUnexpectedToken(peek());
+}
+
+void Quartz::Parser::throwUnexpectedToken(const Token& token)
+{
+    SourceLocation location = Tokenizer::locate(mTokens.source(), token.Offset);
+    Logger::getInstance().throwException(PositionalException(location.Line, location.CharPos, "Unexpected token " + token.toString(mTokens.source())));
 }
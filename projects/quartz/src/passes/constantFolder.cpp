@@ -0,0 +1,185 @@
+#include "passes/constantFolder.hpp"
+
+namespace Quartz {
+	namespace {
+		double asDouble(const Value& value)
+		{
+			return value.type == ValueType::Integer ? static_cast<double>(value.integer) : value.floating;
+		}
+
+		bool isNumber(const Value& value)
+		{
+			return value.type == ValueType::Integer || value.type == ValueType::Float;
+		}
+	}
+
+	void ConstantFolder::run()
+	{
+		mGlobals.clear();
+		for (uint32_t i = 0; i < mAst.childCount[0]; ++i) {
+			NodeIndex node = mAst.child(0, i);
+			if (mAst.kinds[node] == NodeType::ConstDecl)
+				mGlobals[mAst.name(node)] = constantValue(node);
+		}
+
+		for (uint32_t i = 0; i < mAst.childCount[0]; ++i) {
+			NodeIndex node = mAst.child(0, i);
+			if (mAst.kinds[node] == NodeType::Strategy)
+				foldStrategy(node);
+		}
+	}
+
+	uint32_t ConstantFolder::constantValue(NodeIndex constNode)
+	{
+		// Uses see the declared type, so int literals of float consts are stored widened
+		mAst.values.push_back(mAst.constValue(constNode));
+		return static_cast<uint32_t>(mAst.values.size() - 1);
+	}
+
+	void ConstantFolder::foldStrategy(NodeIndex strategyNode)
+	{
+		mScope = mGlobals;
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			if (mAst.kinds[node] == NodeType::ConstDecl)
+				mScope[mAst.name(node)] = constantValue(node);
+		}
+
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			switch (mAst.kinds[node])
+			{
+			case NodeType::StrategyInitFunction:
+			case NodeType::StrategyOnDataFunction:
+			case NodeType::FunctionDecl:
+				for (uint32_t j = 0; j < mAst.childCount[node]; ++j)
+					foldStatement(mAst.child(node, j));
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void ConstantFolder::foldStatement(NodeIndex node)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::Block:
+			for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+				foldStatement(mAst.child(node, i));
+			break;
+		case NodeType::ExprStmt:
+		case NodeType::VarDecl:
+		case NodeType::AssignStmt:
+			foldExpression(mAst.child(node, 0));
+			break;
+		case NodeType::IfStmt:
+		{
+			const NodeIndex condition = mAst.child(node, 0);
+			foldExpression(condition);
+			for (uint32_t i = 1; i < mAst.childCount[node]; ++i)
+				foldStatement(mAst.child(node, i));
+
+			if (mAst.kinds[condition] != NodeType::LiteralExpr)
+				break;
+
+			// Narrow the node down to the branch that runs, a false condition without an else leaves an empty block
+			const bool taken = mAst.value(condition).boolean;
+			const uint32_t branch = taken ? 1 : 2;
+			mAst.kinds[node] = NodeType::Block;
+			if (branch < mAst.childCount[node]) {
+				mAst.firstChild[node] = mAst.child(node, branch);
+				mAst.childCount[node] = 1;
+			}
+			else {
+				mAst.childCount[node] = 0;
+			}
+			mPruned++;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void ConstantFolder::foldExpression(NodeIndex node)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::IdentifierExpr:
+		{
+			auto constant = mScope.find(mAst.name(node));
+			if (constant == mScope.end())
+				break;
+			makeLiteral(node, constant->second);
+			mSubstituted++;
+			break;
+		}
+		case NodeType::IndexExpr:
+			// The name is always an input, only the lookback can be constant
+			foldExpression(mAst.child(node, 0));
+			break;
+		case NodeType::CallExpr:
+			// define_input_variables() takes names, not values
+			if (mAst.name(node) == mDefineInputsSymbol)
+				break;
+			for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+				foldExpression(mAst.child(node, i));
+			break;
+		case NodeType::BinaryExpr:
+		{
+			const NodeIndex leftNode = mAst.child(node, 0);
+			const NodeIndex rightNode = mAst.child(node, 1);
+			foldExpression(leftNode);
+			foldExpression(rightNode);
+			if (mAst.kinds[leftNode] != NodeType::LiteralExpr || mAst.kinds[rightNode] != NodeType::LiteralExpr) {
+				// An int literal compared with a float is widened now rather than on every evaluation
+				widenLiteral(leftNode, mAst.type(rightNode));
+				widenLiteral(rightNode, mAst.type(leftNode));
+				break;
+			}
+
+			const Value& left = mAst.value(leftNode);
+			const Value& right = mAst.value(rightNode);
+			if (!isNumber(left) || !isNumber(right))
+				break;
+
+			// Same semantics as the VM: ints compare exactly, anything else compares as doubles
+			const bool integer = left.type == ValueType::Integer && right.type == ValueType::Integer;
+			bool result;
+			switch (mAst.tokenType(node))
+			{
+			case LESS_THAN: result = integer ? left.integer < right.integer : asDouble(left) < asDouble(right); break;
+			case GREATER_THAN: result = integer ? left.integer > right.integer : asDouble(left) > asDouble(right); break;
+			default: return;
+			}
+
+			mAst.values.push_back(Value::fromBool(result));
+			makeLiteral(node, static_cast<uint32_t>(mAst.values.size() - 1));
+			mFolded++;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void ConstantFolder::widenLiteral(NodeIndex node, ValueType otherType)
+	{
+		if (mAst.kinds[node] != NodeType::LiteralExpr || mAst.type(node) != ValueType::Integer || otherType != ValueType::Float)
+			return;
+		mAst.values.push_back(Value(static_cast<double>(mAst.value(node).integer)));
+		makeLiteral(node, static_cast<uint32_t>(mAst.values.size() - 1));
+		mAst.types[node] = ValueType::Float;
+		mFolded++;
+	}
+
+	void ConstantFolder::makeLiteral(NodeIndex node, uint32_t valueIndex)
+	{
+		mAst.kinds[node] = NodeType::LiteralExpr;
+		mAst.names[node] = INVALID_SYMBOL;
+		mAst.payloads[node] = valueIndex;
+		mAst.childCount[node] = 0;
+	}
+}
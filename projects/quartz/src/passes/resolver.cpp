@@ -0,0 +1,154 @@
+#include "passes/resolver.hpp"
+
+#include "vm/history.hpp"
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	void Resolver::run()
+	{
+		for (uint32_t i = 0; i < mAst.childCount[0]; ++i) {
+			NodeIndex node = mAst.child(0, i);
+			if (mAst.kinds[node] == NodeType::Strategy)
+				resolveStrategy(node);
+		}
+	}
+
+	void Resolver::resolveStrategy(NodeIndex strategyNode)
+	{
+		mStrategy = mAst.name(strategyNode);
+		mSlots.clear();
+		mLocals.clear();
+		mNextSlot = 0;
+		mIndicatorCount = 0;
+
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			if (mAst.kinds[node] != NodeType::StrategyInitFunction)
+				continue;
+			for (Symbol input : mAst.inputVariables(node))
+				mSlots[input] = mNextSlot++;
+		}
+		mFrameSize = mNextSlot;
+		mInputCount = mNextSlot;
+
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			switch (mAst.kinds[node])
+			{
+			case NodeType::StrategyInitFunction:
+			case NodeType::StrategyOnDataFunction:
+			case NodeType::FunctionDecl:
+				mInOnData = mAst.kinds[node] == NodeType::StrategyOnDataFunction;
+				for (uint32_t j = 0; j < mAst.childCount[node]; ++j)
+					resolveStatement(mAst.child(node, j));
+				break;
+			default:
+				break;
+			}
+		}
+
+		mAst.payloads[strategyNode] = mFrameSize;
+		mStrategy = INVALID_SYMBOL;
+	}
+
+	void Resolver::resolveStatement(NodeIndex node)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::Block:
+		{
+			const size_t mark = mLocals.size();
+			const uint32_t slotMark = mNextSlot;
+			for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+				resolveStatement(mAst.child(node, i));
+			for (size_t i = mark; i < mLocals.size(); ++i)
+				mSlots.erase(mLocals[i]);
+			mLocals.resize(mark);
+			mNextSlot = slotMark;
+			break;
+		}
+		case NodeType::VarDecl:
+			// The initializer is resolved first, it can't see the variable it initialises
+			resolveExpression(mAst.child(node, 0));
+			mAst.payloads[node] = mNextSlot;
+			mSlots[mAst.name(node)] = mNextSlot++;
+			mLocals.push_back(mAst.name(node));
+			mFrameSize = std::max(mFrameSize, mNextSlot);
+			break;
+		case NodeType::AssignStmt:
+			resolveExpression(mAst.child(node, 0));
+			mAst.payloads[node] = slotOf(mAst.name(node));
+			break;
+		default:
+			for (uint32_t i = 0; i < mAst.childCount[node]; ++i) {
+				NodeIndex child = mAst.child(node, i);
+				if (mAst.kinds[child] == NodeType::Block || mAst.kinds[child] == NodeType::IfStmt)
+					resolveStatement(child);
+				else
+					resolveExpression(child);
+			}
+			break;
+		}
+	}
+
+	void Resolver::resolveExpression(NodeIndex node)
+	{
+		if (mAst.kinds[node] == NodeType::IdentifierExpr) {
+			mAst.payloads[node] = slotOf(mAst.name(node));
+			return;
+		}
+		if (mAst.kinds[node] == NodeType::IndexExpr)
+			resolveHistory(node);
+		if (mAst.kinds[node] == NodeType::CallExpr) {
+			if (const IndicatorInfo* indicator = findIndicator(mAst.name(node)))
+				resolveIndicator(node, *indicator);
+		}
+		for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+			resolveExpression(mAst.child(node, i));
+	}
+
+	void Resolver::resolveIndicator(NodeIndex node, const IndicatorInfo& indicator)
+	{
+		// The window sizes the indicator's state when the strategy is loaded, folding has already
+		// turned constant windows into literals
+		const NodeIndex window = mAst.child(node, indicator.seriesArguments);
+		if (mAst.kinds[window] != NodeType::LiteralExpr || mAst.value(window).type != ValueType::Integer
+			|| mAst.value(window).integer < 1 || mAst.value(window).integer > MAX_INDICATOR_WINDOW)
+			throwResolveError("window of " + std::string(indicator.name) + "() must be a constant int between 1 and " + std::to_string(MAX_INDICATOR_WINDOW));
+
+		// Only on_data() can advance an indicator, the compiler rejects calls anywhere else
+		if (!mInOnData)
+			return;
+		if (mIndicatorCount > UINT16_MAX)
+			throwResolveError("too many indicator calls");
+		mAst.payloads[node] = mIndicatorCount++;
+	}
+
+	void Resolver::resolveHistory(NodeIndex node)
+	{
+		const std::string name(symbolName(mAst.name(node)));
+		const uint32_t slot = slotOf(mAst.name(node));
+		if (slot >= mInputCount)
+			throwResolveError("can't index '" + name + "', only input variables have a history");
+		mAst.payloads[node] = slot;
+
+		// The lookback sizes the input's history ring when the strategy is loaded
+		const NodeIndex index = mAst.child(node, 0);
+		if (mAst.kinds[index] != NodeType::LiteralExpr || mAst.value(index).type != ValueType::Integer
+			|| mAst.value(index).integer < 0 || mAst.value(index).integer > MAX_HISTORY_LOOKBACK)
+			throwResolveError("history index of '" + name + "' must be a constant int between 0 and " + std::to_string(MAX_HISTORY_LOOKBACK));
+	}
+
+	uint32_t Resolver::slotOf(Symbol name)
+	{
+		auto slot = mSlots.find(name);
+		if (slot == mSlots.end())
+			throwResolveError("use of undefined variable '" + std::string(symbolName(name)) + "'");
+		return slot->second;
+	}
+
+	void Resolver::throwResolveError(const std::string& message) const
+	{
+		Logger::getInstance().throwException(std::runtime_error("Error in strategy '" + std::string(symbolName(mStrategy)) + "': " + message));
+	}
+}
@@ -0,0 +1,316 @@
+#include "passes/typeChecker.hpp"
+
+#include "vm/builtins.hpp"
+#include "vm/indicators.hpp"
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	void TypeChecker::check()
+	{
+		mAst.types.assign(mAst.size(), ValueType::None);
+		mGlobals.clear();
+
+		// Program level constants are visible to every strategy, so they're checked first
+		for (uint32_t i = 0; i < mAst.childCount[0]; ++i) {
+			NodeIndex node = mAst.child(0, i);
+			if (mAst.kinds[node] == NodeType::ConstDecl)
+				mGlobals[mAst.name(node)] = { checkConstant(node), VariableKind::Constant };
+		}
+
+		for (uint32_t i = 0; i < mAst.childCount[0]; ++i) {
+			NodeIndex node = mAst.child(0, i);
+			if (mAst.kinds[node] == NodeType::Strategy)
+				checkStrategy(node);
+		}
+	}
+
+	ValueType TypeChecker::checkConstant(NodeIndex constNode)
+	{
+		const std::string context = "constant '" + std::string(symbolName(mAst.name(constNode))) + "'";
+		NodeIndex literal = mAst.child(constNode, 0);
+		ValueType literalType = mAst.value(literal).type;
+		if (literalType == ValueType::None)
+			throwTypeError(context + " must be initialised with a literal");
+		mAst.types[literal] = literalType;
+
+		// Without an annotation the constant takes the type of its literal
+		if (mAst.tokenType(constNode) == NONE)
+			return literalType;
+
+		ValueType declared = typeOfKeyword(mAst.tokenType(constNode), context);
+		if (declared == ValueType::None)
+			throwTypeError(context + " can't be void");
+		if (!isAssignable(literalType, declared))
+			throwTypeError(context + " is declared as " + typeName(declared) + " but initialised with a " + typeName(literalType));
+		return declared;
+	}
+
+	void TypeChecker::checkStrategy(NodeIndex strategyNode)
+	{
+		mStrategy = mAst.name(strategyNode);
+		mScope = mGlobals;
+
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			if (mAst.kinds[node] == NodeType::ConstDecl)
+				mScope[mAst.name(node)] = { checkConstant(node), VariableKind::Constant };
+		}
+
+		// Inputs are declared in init() but readable from on_data(), declare them before checking either
+		std::vector<Symbol> inputs;
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			if (mAst.kinds[node] == NodeType::StrategyInitFunction)
+				inputs = mAst.inputVariables(node);
+		}
+		for (Symbol input : inputs) {
+			if (mScope.count(input))
+				throwTypeError("input variable '" + std::string(symbolName(input)) + "' shadows a constant");
+		}
+		for (Symbol input : inputs)
+			mScope[input] = { ValueType::Float, VariableKind::Input };
+
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			switch (mAst.kinds[node])
+			{
+			case NodeType::StrategyInitFunction:
+			case NodeType::StrategyOnDataFunction:
+			case NodeType::FunctionDecl:
+				checkFunction(node);
+				break;
+			default:
+				break;
+			}
+		}
+
+		mStrategy = INVALID_SYMBOL;
+	}
+
+	void TypeChecker::checkFunction(NodeIndex functionNode)
+	{
+		mFunction = functionNode;
+		const NodeType kind = mAst.kinds[functionNode];
+		mReturnType = typeOfKeyword(mAst.tokenType(functionNode), "return type");
+
+		if (kind != NodeType::FunctionDecl && mReturnType != ValueType::None)
+			throwTypeError("must return void");
+
+		for (uint32_t i = 0; i < mAst.childCount[functionNode]; ++i)
+			checkStatement(mAst.child(functionNode, i));
+
+		mFunction = INVALID_NODE;
+	}
+
+	void TypeChecker::checkStatement(NodeIndex node)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::Block:
+		{
+			const size_t mark = mLocals.size();
+			for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+				checkStatement(mAst.child(node, i));
+			for (size_t i = mark; i < mLocals.size(); ++i)
+				mScope.erase(mLocals[i]);
+			mLocals.resize(mark);
+			break;
+		}
+		case NodeType::ExprStmt:
+			checkExpression(mAst.child(node, 0));
+			break;
+		case NodeType::VarDecl:
+			checkVarDecl(node);
+			break;
+		case NodeType::AssignStmt:
+			checkAssignment(node);
+			break;
+		case NodeType::IfStmt:
+			expectType(mAst.child(node, 0), ValueType::Bool, "if condition");
+			for (uint32_t i = 1; i < mAst.childCount[node]; ++i)
+				checkStatement(mAst.child(node, i));
+			break;
+		case NodeType::ReturnStmt:
+			// Return statements don't carry a value yet
+			if (mReturnType != ValueType::None)
+				throwTypeError(std::string("must return a ") + typeName(mReturnType) + " value");
+			break;
+		default:
+			throwTypeError("unexpected statement");
+		}
+	}
+
+	void TypeChecker::checkVarDecl(NodeIndex node)
+	{
+		const Symbol name = mAst.name(node);
+		const std::string context = "variable '" + std::string(symbolName(name)) + "'";
+		if (mScope.count(name))
+			throwTypeError(context + " is already defined");
+
+		ValueType initializer = checkExpression(mAst.child(node, 0));
+		ValueType type = initializer;
+		if (mAst.tokenType(node) != NONE) {
+			type = typeOfKeyword(mAst.tokenType(node), context);
+			if (!isAssignable(initializer, type))
+				throwTypeError(context + " is declared as " + typeName(type) + " but initialised with a " + typeName(initializer));
+		}
+		if (type == ValueType::None)
+			throwTypeError(context + " can't be void");
+
+		// Declared after the initializer is checked, so it can't refer to itself
+		mAst.types[node] = type;
+		mScope[name] = { type, VariableKind::Local };
+		mLocals.push_back(name);
+	}
+
+	void TypeChecker::checkAssignment(NodeIndex node)
+	{
+		const Symbol name = mAst.name(node);
+		const std::string context = "'" + std::string(symbolName(name)) + "'";
+		auto variable = mScope.find(name);
+		if (variable == mScope.end())
+			throwTypeError("assignment to undefined variable " + context);
+		if (variable->second.kind == VariableKind::Constant)
+			throwTypeError("can't assign to constant " + context);
+		if (variable->second.kind == VariableKind::Input)
+			throwTypeError("can't assign to input variable " + context);
+
+		expectType(mAst.child(node, 0), variable->second.type, "value assigned to " + context);
+		mAst.types[node] = variable->second.type;
+	}
+
+	ValueType TypeChecker::checkExpression(NodeIndex node)
+	{
+		ValueType type = ValueType::None;
+		switch (mAst.kinds[node])
+		{
+		case NodeType::LiteralExpr:
+			type = mAst.value(node).type;
+			break;
+		case NodeType::Signal:
+			type = ValueType::Signal;
+			break;
+		case NodeType::IdentifierExpr:
+		{
+			auto variable = mScope.find(mAst.name(node));
+			if (variable == mScope.end())
+				throwTypeError("use of undefined variable '" + std::string(symbolName(mAst.name(node))) + "'");
+			type = variable->second.type;
+			break;
+		}
+		case NodeType::IndexExpr:
+		{
+			// Only input variables keep a history, locals are recomputed every bar
+			const std::string context = "'" + std::string(symbolName(mAst.name(node))) + "'";
+			auto variable = mScope.find(mAst.name(node));
+			if (variable == mScope.end())
+				throwTypeError("use of undefined variable " + context);
+			if (variable->second.kind != VariableKind::Input)
+				throwTypeError("can't index " + context + ", only input variables have a history");
+			expectType(mAst.child(node, 0), ValueType::Integer, "history index of " + context);
+			type = variable->second.type;
+			break;
+		}
+		case NodeType::BinaryExpr:
+		{
+			ValueType left = checkExpression(mAst.child(node, 0));
+			ValueType right = checkExpression(mAst.child(node, 1));
+			const TokenType op = mAst.tokenType(node);
+			if (op != LESS_THAN && op != GREATER_THAN)
+				throwTypeError(std::string("unsupported operator ") + tokenTypeToString(op));
+			if (!isNumeric(left) || !isNumeric(right))
+				throwTypeError(std::string("can't compare ") + typeName(left) + " with " + typeName(right));
+			type = ValueType::Bool;
+			break;
+		}
+		case NodeType::CallExpr:
+			type = checkCall(node);
+			break;
+		default:
+			throwTypeError("unexpected expression");
+		}
+
+		mAst.types[node] = type;
+		return type;
+	}
+
+	ValueType TypeChecker::checkCall(NodeIndex node)
+	{
+		const Symbol callee = mAst.name(node);
+		const std::string name(symbolName(callee));
+		const uint32_t argumentCount = mAst.childCount[node];
+
+		if (callee == mEmitSignalSymbol) {
+			if (argumentCount != 1)
+				throwTypeError("emit_signal() takes exactly one argument");
+			expectType(mAst.child(node, 0), ValueType::Signal, "emit_signal() argument");
+			return ValueType::None;
+		}
+
+		if (callee == mDefineInputsSymbol) {
+			// The arguments name the inputs rather than read them, they were declared up front
+			for (uint32_t i = 0; i < argumentCount; ++i)
+				mAst.types[mAst.child(node, i)] = ValueType::Float;
+			return ValueType::None;
+		}
+
+		if (const IndicatorInfo* indicator = findIndicator(callee)) {
+			if (argumentCount != indicator->seriesArguments + 1u)
+				throwTypeError(name + "() takes exactly " + std::to_string(indicator->seriesArguments + 1) + " arguments");
+			for (uint32_t i = 0; i < indicator->seriesArguments; ++i)
+				expectType(mAst.child(node, i), ValueType::Float, "argument " + std::to_string(i + 1) + " of " + name + "()");
+			expectType(mAst.child(node, indicator->seriesArguments), ValueType::Integer, "window of " + name + "()");
+			return ValueType::Float;
+		}
+
+		// Bind the call to its builtin once, the compiler reads the index back from the payload
+		const BuiltinRegistry& registry = BuiltinRegistry::getInstance();
+		const uint32_t index = registry.find(callee);
+		if (index == BuiltinRegistry::NOT_FOUND)
+			throwTypeError("call to unknown function '" + name + "'");
+		mAst.payloads[node] = index;
+
+		const BuiltinFunction& builtin = registry[index];
+		if (argumentCount < builtin.minArguments || argumentCount > builtin.parameters.size())
+			throwTypeError("wrong number of arguments passed to " + name + "()");
+		for (uint32_t i = 0; i < argumentCount; ++i)
+			expectType(mAst.child(node, i), builtin.parameters[i], "argument " + std::to_string(i + 1) + " of " + name + "()");
+		return builtin.returnType;
+	}
+
+	void TypeChecker::expectType(NodeIndex node, ValueType expected, const std::string& context)
+	{
+		ValueType actual = checkExpression(node);
+		if (!isAssignable(actual, expected))
+			throwTypeError(context + " must be " + typeName(expected) + ", got " + typeName(actual));
+	}
+
+	ValueType TypeChecker::typeOfKeyword(TokenType keyword, const std::string& context)
+	{
+		switch (keyword)
+		{
+		case KEYWORD_INT: return ValueType::Integer;
+		case KEYWORD_FLOAT: return ValueType::Float;
+		case KEYWORD_STRING: return ValueType::String;
+		case KEYWORD_VOID: return ValueType::None;
+		default:
+			throwTypeError(context + " has unknown type " + tokenTypeToString(keyword));
+		}
+	}
+
+	void TypeChecker::throwTypeError(const std::string& message) const
+	{
+		std::string location;
+		if (mStrategy != INVALID_SYMBOL)
+			location = " in strategy '" + std::string(symbolName(mStrategy)) + "'";
+		if (mFunction != INVALID_NODE) {
+			switch (mAst.kinds[mFunction])
+			{
+			case NodeType::StrategyInitFunction: location += " init()"; break;
+			case NodeType::StrategyOnDataFunction: location += " on_data()"; break;
+			default: location += " " + std::string(symbolName(mAst.name(mFunction))) + "()"; break;
+			}
+		}
+		Logger::getInstance().throwException(std::runtime_error("Type error" + location + ": " + message));
+	}
+}
@@ -5,17 +5,16 @@
 #include "tokenizer/tokenizer.hpp"
 #include "parser/parser.hpp"
 #include "parser/abstractSyntaxTree.hpp"
+#include "passes/typeChecker.hpp"
+#include "passes/constantFolder.hpp"
+#include "passes/resolver.hpp"
 
 namespace Quartz {
 	std::shared_ptr<ProgramNode> run_code(const char* code)
 	{
-		Logger::getInstance().log(Logger::INFO, "Tokenizing");
-		Tokenizer tokenizer = Tokenizer(code);
-		const std::vector<Token> tokens = tokenizer.tokenize();
-
-		Logger::getInstance().log(Logger::INFO, "Parsing tokens");
-		Parser parser = Parser(tokens);
-		auto& programNode = parser.parse();
+		Logger::getInstance().log(Logger::INFO, "Tokenizing and parsing");
+		Parser parser = Parser(code);
+		auto programNode = parser.parse();
 
 		return programNode;
 	}
@@ -23,9 +22,79 @@ namespace Quartz {
 	std::shared_ptr<ProgramNode> run_file(const char* filepath)
     {
 		Logger::getInstance().logf(Logger::INFO, "Reading file content: %s", filepath);
-		const char* fileContents = loadFileToCString(filepath);
-
+		std::unique_ptr<const char[]> fileContents(loadFileToCString(filepath));
+		if (!fileContents)
+			Logger::getInstance().throwException(std::runtime_error("Failed to read file: " + std::string(filepath)));
 
-		return run_code(fileContents);
+		// The program copies everything it keeps into its own arena, so the source can be released
+		return run_code(fileContents.get());
     }
-}
\ No newline at end of file
+
+	std::shared_ptr<const FlatAST> analyse_program(std::shared_ptr<const ProgramNode> program)
+	{
+		return specialise_program(*check_program(program));
+	}
+
+	std::shared_ptr<const FlatAST> check_program(std::shared_ptr<const ProgramNode> program)
+	{
+		Logger::getInstance().log(Logger::INFO, "Type checking");
+		FlatAST ast = FlatAST::fromProgram(program);
+		TypeChecker(ast).check();
+		return std::make_shared<const FlatAST>(std::move(ast));
+	}
+
+	namespace {
+		void overrideConst(FlatAST& ast, NodeIndex constNode, const ConstOverride& override)
+		{
+			const std::string name(symbolName(override.name));
+			const ValueType declared = ast.constValue(constNode).type;
+			Value value = override.value;
+			if (declared == ValueType::Float && value.type == ValueType::Integer)
+				value = Value(static_cast<double>(value.integer));
+			if (value.type != declared)
+				Logger::getInstance().throwException(std::runtime_error("Const " + name + " is " + typeName(declared) +
+					", it can't be given a " + typeName(override.value.type) + " value"));
+
+			// The literal gets a value of its own, the checked program's values are left alone
+			ast.values.push_back(value);
+			ast.payloads[ast.child(constNode, 0)] = static_cast<uint32_t>(ast.values.size() - 1);
+		}
+	}
+
+	std::shared_ptr<const FlatAST> specialise_program(const FlatAST& checked, const std::vector<ConstOverride>& overrides)
+	{
+		FlatAST ast = checked;
+
+		for (const ConstOverride& override : overrides) {
+			bool found = false;
+			// Consts are declared at the top level and at the top of strategies
+			for (uint32_t i = 0; i < ast.childCount[0]; ++i) {
+				const NodeIndex node = ast.child(0, i);
+				if (ast.kinds[node] == NodeType::ConstDecl && ast.name(node) == override.name) {
+					overrideConst(ast, node, override);
+					found = true;
+				}
+				if (ast.kinds[node] != NodeType::Strategy)
+					continue;
+				for (uint32_t j = 0; j < ast.childCount[node]; ++j) {
+					const NodeIndex member = ast.child(node, j);
+					if (ast.kinds[member] == NodeType::ConstDecl && ast.name(member) == override.name) {
+						overrideConst(ast, member, override);
+						found = true;
+					}
+				}
+			}
+			if (!found)
+				Logger::getInstance().throwException(std::runtime_error("No const named " + std::string(symbolName(override.name))));
+		}
+
+		ConstantFolder folder(ast);
+		folder.run();
+		Logger::getInstance().logf(Logger::DEBUG, "Constant folding: %zu uses substituted, %zu expressions folded, %zu branches pruned",
+			folder.substitutedCount(), folder.foldedCount(), folder.prunedCount());
+
+		Resolver(ast).run();
+
+		return std::make_shared<const FlatAST>(std::move(ast));
+	}
+}
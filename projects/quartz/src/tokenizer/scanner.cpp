@@ -0,0 +1,208 @@
+#include "tokenizer/scanner.hpp"
+
+#if defined(QUARTZ_SCANNER_AVX2)
+#include <immintrin.h>
+#elif defined(QUARTZ_SCANNER_SSE2)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Quartz {
+	namespace Scanner {
+		namespace {
+#if defined(QUARTZ_SCANNER_AVX2) || defined(QUARTZ_SCANNER_SSE2)
+#define QUARTZ_SCANNER_VECTOR 1
+			inline uint32_t countTrailingZeros(uint32_t mask)
+			{
+#ifdef _MSC_VER
+				unsigned long index;
+				_BitScanForward(&index, mask);
+				return static_cast<uint32_t>(index);
+#else
+				return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+			}
+
+			inline uint32_t countBits(uint32_t mask)
+			{
+#ifdef _MSC_VER
+				return static_cast<uint32_t>(__popcnt(mask));
+#else
+				return static_cast<uint32_t>(__builtin_popcount(mask));
+#endif
+			}
+#endif
+
+#if defined(QUARTZ_SCANNER_AVX2)
+			using Block = __m256i;
+			constexpr ptrdiff_t STRIDE = 32;
+			constexpr uint32_t FULL_MASK = 0xFFFFFFFFu;
+
+			inline Block load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+			inline Block splat(char c) { return _mm256_set1_epi8(c); }
+			inline Block equals(Block a, char c) { return _mm256_cmpeq_epi8(a, splat(c)); }
+			inline Block either(Block a, Block b) { return _mm256_or_si256(a, b); }
+			inline Block both(Block a, Block b) { return _mm256_and_si256(a, b); }
+			inline Block greaterThan(Block a, Block b) { return _mm256_cmpgt_epi8(a, b); }
+			inline uint32_t toMask(Block a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+#elif defined(QUARTZ_SCANNER_SSE2)
+			using Block = __m128i;
+			constexpr ptrdiff_t STRIDE = 16;
+			constexpr uint32_t FULL_MASK = 0xFFFFu;
+
+			inline Block load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+			inline Block splat(char c) { return _mm_set1_epi8(c); }
+			inline Block equals(Block a, char c) { return _mm_cmpeq_epi8(a, splat(c)); }
+			inline Block either(Block a, Block b) { return _mm_or_si128(a, b); }
+			inline Block both(Block a, Block b) { return _mm_and_si128(a, b); }
+			inline Block greaterThan(Block a, Block b) { return _mm_cmpgt_epi8(a, b); }
+			inline uint32_t toMask(Block a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+#endif
+
+#ifdef QUARTZ_SCANNER_VECTOR
+			// Signed compares are fine here, every range is plain ASCII and bytes >= 0x80 compare as negative
+			inline Block inRange(Block a, char low, char high)
+			{
+				return both(greaterThan(a, splat(low - 1)), greaterThan(splat(high + 1), a));
+			}
+
+			// Advances while every lane matches, returns the first non-matching byte
+			template <typename Matcher>
+			inline const char* vectorScanWhile(const char* p, const char* end, Matcher matches)
+			{
+				while (end - p >= STRIDE) {
+					uint32_t stop = ~toMask(matches(load(p))) & FULL_MASK;
+					if (stop)
+						return p + countTrailingZeros(stop);
+					p += STRIDE;
+				}
+				return p;
+			}
+
+			// Advances until any lane matches, returns the first matching byte
+			template <typename Matcher>
+			inline const char* vectorScanUntil(const char* p, const char* end, Matcher matches)
+			{
+				while (end - p >= STRIDE) {
+					uint32_t found = toMask(matches(load(p)));
+					if (found)
+						return p + countTrailingZeros(found);
+					p += STRIDE;
+				}
+				return p;
+			}
+#endif
+
+			inline const char* scalarScanWhile(const char* p, const char* end, uint8_t charClass)
+			{
+				while (p < end && hasClass(*p, charClass))
+					++p;
+				return p;
+			}
+
+			const char* skipWhitespace(const char* p, const char* end)
+			{
+#ifdef QUARTZ_SCANNER_VECTOR
+				p = vectorScanWhile(p, end, [](Block block) {
+					return either(either(equals(block, ' '), equals(block, '\t')),
+						either(equals(block, '\n'), equals(block, '\r')));
+				});
+#endif
+				return scalarScanWhile(p, end, CHAR_WHITESPACE);
+			}
+		}
+
+		const char* skipTrivia(const char* begin, const char* end)
+		{
+			const char* p = begin;
+			while (true) {
+				p = skipWhitespace(p, end);
+				if (end - p >= 2 && p[0] == '/' && p[1] == '/')
+					p = skipLine(p + 2, end);
+				else
+					return p;
+			}
+		}
+
+		const char* skipLine(const char* begin, const char* end)
+		{
+			const char* p = begin;
+#ifdef QUARTZ_SCANNER_VECTOR
+			p = vectorScanUntil(p, end, [](Block block) {
+				return either(equals(block, '\n'), equals(block, '\r'));
+			});
+#endif
+			while (p < end && !hasClass(*p, CHAR_NEWLINE))
+				++p;
+			return p;
+		}
+
+		const char* scanIdentifier(const char* begin, const char* end)
+		{
+			const char* p = begin;
+#ifdef QUARTZ_SCANNER_VECTOR
+			p = vectorScanWhile(p, end, [](Block block) {
+				// OR-ing in 0x20 folds A-Z onto a-z without letting any other byte into the range
+				Block lower = either(block, splat(0x20));
+				return either(either(inRange(lower, 'a', 'z'), inRange(block, '0', '9')), equals(block, '_'));
+			});
+#endif
+			return scalarScanWhile(p, end, CHAR_IDENTIFIER);
+		}
+
+		const char* scanNumber(const char* begin, const char* end)
+		{
+			const char* p = begin;
+#ifdef QUARTZ_SCANNER_VECTOR
+			p = vectorScanWhile(p, end, [](Block block) {
+				return either(inRange(block, '0', '9'), equals(block, '.'));
+			});
+#endif
+			return scalarScanWhile(p, end, CHAR_NUMBER);
+		}
+
+		const char* scanString(const char* begin, const char* end, char quote)
+		{
+			const char* p = begin;
+#ifdef QUARTZ_SCANNER_VECTOR
+			p = vectorScanUntil(p, end, [quote](Block block) {
+				return either(equals(block, quote), either(equals(block, '\n'), equals(block, '\r')));
+			});
+#endif
+			while (p < end && *p != quote && !hasClass(*p, CHAR_NEWLINE))
+				++p;
+			return p;
+		}
+
+		const char* scanField(const char* begin, const char* end, char delimiter)
+		{
+			const char* p = begin;
+#ifdef QUARTZ_SCANNER_VECTOR
+			p = vectorScanUntil(p, end, [delimiter](Block block) {
+				return either(equals(block, delimiter), either(equals(block, '\n'), equals(block, '\r')));
+			});
+#endif
+			while (p < end && *p != delimiter && !hasClass(*p, CHAR_NEWLINE))
+				++p;
+			return p;
+		}
+
+		size_t countNewlines(const char* begin, const char* end)
+		{
+			const char* p = begin;
+			size_t count = 0;
+#ifdef QUARTZ_SCANNER_VECTOR
+			while (end - p >= STRIDE) {
+				count += countBits(toMask(equals(load(p), '\n')));
+				p += STRIDE;
+			}
+#endif
+			for (; p < end; ++p)
+				count += *p == '\n';
+			return count;
+		}
+	}
+}
@@ -1,277 +1,156 @@
 #include "tokenizer/tokenizer.hpp"
+#include "tokenizer/scanner.hpp"
+#include "tokenizer/keywords.hpp"
 
 namespace Quartz {
-	char Tokenizer::peek(int i)
+	Token Tokenizer::buildNumber(const char** cursor)
 	{
-		return mInput[i + 1] != '\0' ? mInput[i + 1] : '\0';
+		const char* start = *cursor;
+		const char* end = Scanner::scanNumber(start, mEnd);
+		const char* dot = static_cast<const char*>(std::memchr(start, '.', end - start));
+		if (dot && std::memchr(dot + 1, '.', end - dot - 1))
+			throwMalformedLiteral(start, end, "more than one decimal point");
+
+		Token token(dot ? FLOAT_VALUE : INT_VALUE, offsetOf(start), static_cast<uint32_t>(end - start));
+		LiteralValue value;
+		std::from_chars_result result = dot
+			? std::from_chars(start, end, value.FloatValue)
+			: std::from_chars(start, end, value.IntValue);
+		if (result.ec == std::errc::result_out_of_range)
+			throwMalformedLiteral(start, end, "value out of range");
+		if (result.ec != std::errc() || result.ptr != end)
+			throwMalformedLiteral(start, end, "not a number");
+
+		token.Value = static_cast<uint32_t>(mLiterals.size());
+		mLiterals.push_back(value);
+		*cursor = end;
+		return token;
 	}
 
-	Token Tokenizer::buildNumber(int* index)
+	Token Tokenizer::buildString(const char** cursor) const
 	{
-		std::string number = "";
-		bool isFloat = false;
-		for (int i = *index; mInput[i] != '\0'; ++i) {
-			(*index)++;
-			char currChar = mInput[i];
-			if (std::isdigit(currChar)) {
-				number += currChar;
-			}
-			else if (currChar == '.') {
-				if (isFloat) {
-					std::cerr << "Unexpected symbol: " << currChar << std::endl;
-				}
-				isFloat = true;
-			}
-			else {
-				return Token(isFloat ? FLOAT_VALUE : INT_VALUE, number);
-			}
+		const char quote = **cursor;
+		const char* start = *cursor + 1;
+		const char* end = Scanner::scanString(start, mEnd, quote);
+		if (end == mEnd || *end != quote) {
+			SourceLocation location = locate(mInput, offsetOf(*cursor));
+			Logger::getInstance().throwException(PositionalException(location.Line, location.CharPos, "Unterminated string literal"));
 		}
-		return Token(isFloat ? FLOAT_VALUE : INT_VALUE, number);
+		*cursor = end + 1; // skip closing quote
+		return Token(STRING_VALUE, offsetOf(start), static_cast<uint32_t>(end - start));
 	}
 
-	Token Tokenizer::parseString(const std::string& string)
+	Token Tokenizer::buildIdentifier(const char** cursor) const
 	{
-		Token token;
-		auto position = keywordMap.find(string);
-		if (position != keywordMap.end()) {
-			token = Token(position->second);
-		}
-		else {
-			token = Token(TokenType::IDENTIFIER, string);
-		}
-		return token;
+		const char* start = *cursor;
+		const char* end = Scanner::scanIdentifier(start, mEnd);
+		*cursor = end;
+		return parseString(offsetOf(start), static_cast<uint32_t>(end - start));
 	}
 
-	std::vector<Token> Tokenizer::tokenize() {
-		std::vector<Token> tokens = {};
-		std::string currString = "";
-		bool isSingleLineComment = false;
-		char inString = 'n';
-
-		int line = 1;
-		int charPos = 0;
-
-		for (int i = 0; mInput[i] != '\0'; ++i) {
-			charPos++;
-			char currChar = mInput[i];
-			switch (currChar)
-			{
-			case ' ':
-			case '\t':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				break;
-			case '\"':
-				if (isSingleLineComment)
-					break;
-
-				if (inString == '\'') {
-					currString += currChar;
-					break;
-				}
-				else if (inString == '\"') {
-					inString = 'n';
-					if (!currString.empty())
-					{
-						tokens.push_back(Token(STRING_VALUE, currString));
-						currString = "";
-					}
-					break;
-				}
-				inString = '\"';
-				break;
-			case '\'':
-				if (isSingleLineComment)
-					break;
-
-				if (inString == '\"') {
-					currString += currChar;
-					break;
-				}
-				else if (inString == '\'') {
-					inString = 'n';
-					if (!currString.empty())
-					{
-						tokens.push_back(Token(STRING_VALUE, currString));
-						currString = "";
-					}
-					break;
-				}
-				inString = '\'';
-				break;
-			case '{':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(OPEN_CURLY_BRACE));
-				break;
-			case '}':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(CLOSE_CURLY_BRACE));
-				break;
-			case '/':
-				if (isSingleLineComment)
-					break;
-
-				if (peek(i) == '/') {
-					isSingleLineComment = true;
-					i++;
-				}
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				break;
-			case '=':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(EQUALS));
-				break;
-			case ':':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(COLON));
-				break;
-			case ',':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(COMMA));
-				break;
-			case '(':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(OPEN_BRACKET));
-				break;
-			case ')':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(CLOSE_BRACKET));
-				break;
-			case '-':
-				if (isSingleLineComment)
-					break;
-
-				if (peek(i) == '>') {
-					tokens.push_back(Token(RIGHT_ARROW));
-					i++;
-				}
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				break;
-			case '\n':
-			case '\r':
-				if (currChar == '\n' && peek(i) == '\r') {
-					i++;
-				} else if (currChar == '\r' && peek(i) == '\n') {
-					i++;
-				}
-
-				isSingleLineComment = false;
-				if (!currString.empty())
-				{
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				line++;
-				charPos = 0;
-
-				break;
-			case '>':
-				if (isSingleLineComment)
-					break;
-
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(GREATER_THAN));
-				break;
-			case '<':
-				if (isSingleLineComment)
-					break;
+	Token Tokenizer::parseString(uint32_t offset, uint32_t length) const
+	{
+		Token token(lookupKeyword(mInput + offset, length), offset, length);
+		if (token.Type == IDENTIFIER)
+			token.Value = intern(std::string_view(mInput + offset, length));
+		return token;
+	}
 
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(LESS_THAN));
-				break;
-			case ';':
-				if (isSingleLineComment)
-					break;
+	void Tokenizer::throwUnexpectedSymbol(const char* position) const
+	{
+		SourceLocation location = locate(mInput, offsetOf(position));
+		Logger::getInstance().throwException(UnexpectedSymbolException(location.Line, location.CharPos, *position));
+	}
 
-				if (!currString.empty()) {
-					tokens.push_back(parseString(currString));
-					currString = "";
-				}
-				tokens.push_back(Token(SEMI_COLON));
-				break;
-			default:
-				if (isSingleLineComment)
-					break;
+	void Tokenizer::throwMalformedLiteral(const char* begin, const char* end, const std::string& reason) const
+	{
+		SourceLocation location = locate(mInput, offsetOf(begin));
+		Logger::getInstance().throwException(MalformedLiteralException(location.Line, location.CharPos, std::string_view(begin, end - begin), reason));
+	}
 
-				if (std::isalnum(currChar) || currChar == '_') {
-					if (std::isdigit(currChar) && inString == 'n' && currString.empty()) {
-						tokens.push_back(buildNumber(&i));
-					}
-					else {
-						currString += currChar;
-					}
-				} else {
-					Logger::getInstance().throwException(UnexpectedSymbolException(line, charPos, currChar));
-				}
-				break;
+	SourceLocation Tokenizer::locate(const char* input, uint32_t offset)
+	{
+		SourceLocation location;
+		for (uint32_t i = 0; i < offset && input[i] != '\0'; ++i) {
+			if (input[i] == '\n' || input[i] == '\r') {
+				if (input[i] == '\r' && input[i + 1] == '\n' && i + 1 < offset)
+					++i;
+				location.Line++;
+				location.CharPos = 1;
 			}
+			else {
+				location.CharPos++;
+			}
+		}
+		return location;
+	}
 
+	Token Tokenizer::next() {
+		mCursor = Scanner::skipTrivia(mCursor, mEnd);
+		if (mCursor == mEnd)
+			return Token(END, offsetOf(mCursor), 0);
+
+		const uint32_t offset = offsetOf(mCursor);
+		switch (*mCursor)
+		{
+		case '\"':
+		case '\'':
+			return buildString(&mCursor);
+		case '-':
+			if (mCursor + 1 == mEnd || mCursor[1] != '>')
+				throwUnexpectedSymbol(mCursor);
+			mCursor += 2;
+			return Token(RIGHT_ARROW, offset, 2);
+		case '{':
+			++mCursor;
+			return Token(OPEN_CURLY_BRACE, offset, 1);
+		case '}':
+			++mCursor;
+			return Token(CLOSE_CURLY_BRACE, offset, 1);
+		case '(':
+			++mCursor;
+			return Token(OPEN_BRACKET, offset, 1);
+		case ')':
+			++mCursor;
+			return Token(CLOSE_BRACKET, offset, 1);
+		case '[':
+			++mCursor;
+			return Token(OPEN_SQUARE_BRACKET, offset, 1);
+		case ']':
+			++mCursor;
+			return Token(CLOSE_SQUARE_BRACKET, offset, 1);
+		case '=':
+			++mCursor;
+			return Token(EQUALS, offset, 1);
+		case ':':
+			++mCursor;
+			return Token(COLON, offset, 1);
+		case ',':
+			++mCursor;
+			return Token(COMMA, offset, 1);
+		case ';':
+			++mCursor;
+			return Token(SEMI_COLON, offset, 1);
+		case '>':
+			++mCursor;
+			return Token(GREATER_THAN, offset, 1);
+		case '<':
+			++mCursor;
+			return Token(LESS_THAN, offset, 1);
+		default:
+			if (Scanner::hasClass(*mCursor, Scanner::CHAR_DIGIT))
+				return buildNumber(&mCursor);
+			if (Scanner::hasClass(*mCursor, Scanner::CHAR_IDENTIFIER_START))
+				return buildIdentifier(&mCursor);
+			throwUnexpectedSymbol(mCursor);
 		}
+	}
+
+	std::vector<Token> Tokenizer::tokenize() {
+		std::vector<Token> tokens = {};
+		do {
+			tokens.push_back(next());
+		} while (tokens.back().Type != END);
 		return tokens;
 	}
-}
\ No newline at end of file
+}
@@ -1,5 +1,139 @@
 #include "utils/fileUtils.hpp"
 
+#include <algorithm>
+#include <thread>
+
+#include "logging/logging.hpp"
+#include "tokenizer/scanner.hpp"
+
+namespace {
+    constexpr int32_t TIMESTAMP_COLUMN = -2;
+    constexpr int32_t SKIPPED_COLUMN = -1;
+
+    struct CsvChunk {
+        const char* begin;
+        const char* end;
+        uint64_t firstLine;
+        uint64_t lineCount;
+        uint64_t firstRow;
+        uint64_t rowCount;
+        std::string error;
+    };
+
+    std::string lower(std::string_view text)
+    {
+        std::string result(text);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return result;
+    }
+
+    std::string_view trim(std::string_view text)
+    {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    [[noreturn]] void throwCsvError(const char* filename, uint64_t line, const std::string& message)
+    {
+        Quartz::Logger::getInstance().throwException(std::runtime_error(std::string(filename) + ":" + std::to_string(line) + ": " + message));
+    }
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar
+    int64_t daysFromCivil(int64_t year, int64_t month, int64_t day)
+    {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const int64_t yearOfEra = year - era * 400;
+        const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    template <typename T>
+    bool parseNumber(std::string_view field, T& value)
+    {
+        auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+        return error == std::errc() && end == field.data() + field.size() && !field.empty();
+    }
+
+    bool parseTimestamp(std::string_view field, int64_t& timestamp)
+    {
+        if (parseNumber(field, timestamp))
+            return true;
+
+        int64_t year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+        if (field.size() < 10 || field[4] != '-' || field[7] != '-'
+            || !parseNumber(field.substr(0, 4), year) || !parseNumber(field.substr(5, 2), month) || !parseNumber(field.substr(8, 2), day))
+            return false;
+        if (field.size() > 10) {
+            if ((field[10] != ' ' && field[10] != 'T') || field.size() < 16 || field[13] != ':'
+                || !parseNumber(field.substr(11, 2), hour) || !parseNumber(field.substr(14, 2), minute))
+                return false;
+            if (field.size() > 16 && (field.size() != 19 || field[16] != ':' || !parseNumber(field.substr(17, 2), second)))
+                return false;
+        }
+        timestamp = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+        return true;
+    }
+
+    // Parses the rows of one chunk into the columns starting at chunk.firstRow, errors are
+    // recorded in the chunk since they can't be thrown across threads
+    void parseChunk(CsvChunk& chunk, const std::vector<int32_t>& columnTargets, Quartz::CsvColumns& output)
+    {
+        const char* p = chunk.begin;
+        uint64_t line = chunk.firstLine;
+        uint64_t row = chunk.firstRow;
+        int64_t* timestamps = output.timestamps.data();
+
+        while (p < chunk.end) {
+            if (*p == '\n' || *p == '\r') {
+                line += *p == '\n';
+                ++p;
+                continue;
+            }
+
+            for (size_t column = 0;; ++column) {
+                const char* fieldEnd = Quartz::Scanner::scanField(p, chunk.end, ',');
+                if (column >= columnTargets.size()) {
+                    chunk.error = "more columns than the header";
+                    chunk.firstLine = line;
+                    return;
+                }
+
+                const int32_t target = columnTargets[column];
+                if (target != SKIPPED_COLUMN) {
+                    std::string_view field = trim(std::string_view(p, static_cast<size_t>(fieldEnd - p)));
+                    bool parsed = target == TIMESTAMP_COLUMN
+                        ? parseTimestamp(field, timestamps[row])
+                        : parseNumber(field, output.values[target][row]);
+                    if (!parsed) {
+                        chunk.error = (target == TIMESTAMP_COLUMN ? "malformed timestamp '" : "malformed number '") + std::string(field) + "'";
+                        chunk.firstLine = line;
+                        return;
+                    }
+                }
+
+                p = fieldEnd;
+                if (p < chunk.end && *p == ',') {
+                    ++p;
+                    continue;
+                }
+                if (column + 1 != columnTargets.size()) {
+                    chunk.error = "fewer columns than the header";
+                    chunk.firstLine = line;
+                    return;
+                }
+                break;
+            }
+            ++row;
+        }
+        chunk.rowCount = row - chunk.firstRow;
+    }
+}
+
 const char* Quartz::loadFileToCString(const char* filename)
 {
     std::ifstream file(filename, std::ios::in | std::ios::binary);
@@ -22,3 +156,175 @@ const char* Quartz::loadFileToCString(const char* filename)
 
     return buffer;
 }
+
+Quartz::CsvColumns Quartz::loadCsvColumns(const char* filename, const std::vector<std::string>& columns, unsigned threadCount, bool allowMissing)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        Logger::getInstance().throwException(std::runtime_error(std::string("Failed to open ") + filename + ": " + std::strerror(errno)));
+    file.seekg(0, std::ios::end);
+    std::string content(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(content.data(), static_cast<std::streamsize>(content.size()));
+
+    const char* begin = content.data();
+    const char* const end = begin + content.size();
+
+    // Header: map every column to the output it's parsed into
+    const char* headerEnd = Scanner::skipLine(begin, end);
+    std::vector<int32_t> columnTargets;
+    std::vector<bool> found(columns.size(), false);
+    bool hasTimestamp = false;
+    for (const char* p = begin;;) {
+        const char* fieldEnd = Scanner::scanField(p, headerEnd, ',');
+        const std::string name = lower(trim(std::string_view(p, static_cast<size_t>(fieldEnd - p))));
+        int32_t target = SKIPPED_COLUMN;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (lower(columns[i]) == name && !found[i]) {
+                target = static_cast<int32_t>(i);
+                found[i] = true;
+                break;
+            }
+        }
+        if (target == SKIPPED_COLUMN && !hasTimestamp && (name == "timestamp" || name == "time" || name == "date")) {
+            target = TIMESTAMP_COLUMN;
+            hasTimestamp = true;
+        }
+        columnTargets.push_back(target);
+        if (fieldEnd == headerEnd)
+            break;
+        p = fieldEnd + 1;
+    }
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (!found[i] && !allowMissing)
+            throwCsvError(filename, 1, "no " + columns[i] + " column");
+    }
+
+    // Split the body into one chunk per thread, every chunk but the last ends just after a '\n'
+    const char* body = headerEnd < end && *headerEnd == '\r' ? headerEnd + 1 : headerEnd;
+    body = body < end && *body == '\n' ? body + 1 : body;
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // Small files aren't worth a thread each
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+    const size_t bodySize = static_cast<size_t>(end - body);
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, bodySize / MIN_CHUNK_BYTES));
+
+    std::vector<CsvChunk> chunks(chunkCount);
+    const char* chunkBegin = body;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* chunkEnd = end;
+        if (i + 1 < chunkCount) {
+            chunkEnd = std::max(chunkBegin, body + bodySize / chunkCount * (i + 1));
+            chunkEnd = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd)));
+            chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+        }
+        chunks[i] = CsvChunk{ chunkBegin, chunkEnd, 0, 0, 0, 0, {} };
+        chunkBegin = chunkEnd;
+    }
+
+    auto runChunks = [&](auto&& work) {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < chunkCount; ++i)
+            threads.emplace_back(work, std::ref(chunks[i]));
+        work(chunks[0]);
+        for (std::thread& thread : threads)
+            thread.join();
+    };
+
+    // Pass 1: count lines, an upper bound on the rows since blank lines don't produce any
+    runChunks([](CsvChunk& chunk) {
+        chunk.lineCount = Scanner::countNewlines(chunk.begin, chunk.end);
+        if (chunk.end > chunk.begin && chunk.end[-1] != '\n')
+            chunk.lineCount++;
+    });
+
+    uint64_t line = 2;
+    uint64_t rows = 0;
+    for (CsvChunk& chunk : chunks) {
+        chunk.firstLine = line;
+        chunk.firstRow = rows;
+        line += chunk.lineCount;
+        rows += chunk.lineCount;
+    }
+
+    CsvColumns output;
+    if (hasTimestamp)
+        output.timestamps.resize(rows);
+    output.values.resize(columns.size());
+    output.present = found;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (found[i])
+            output.values[i].resize(rows);
+    }
+
+    // Pass 2: parse every chunk into its own rows
+    runChunks([&](CsvChunk& chunk) { parseChunk(chunk, columnTargets, output); });
+
+    for (const CsvChunk& chunk : chunks) {
+        if (!chunk.error.empty())
+            throwCsvError(filename, chunk.firstLine, chunk.error);
+    }
+
+    // Close the gaps blank lines left at the end of each chunk's rows
+    uint64_t written = 0;
+    for (const CsvChunk& chunk : chunks) {
+        if (written != chunk.firstRow) {
+            if (hasTimestamp)
+                std::copy_n(output.timestamps.begin() + chunk.firstRow, chunk.rowCount, output.timestamps.begin() + written);
+            for (std::vector<double>& values : output.values) {
+                if (!values.empty())
+                    std::copy_n(values.begin() + chunk.firstRow, chunk.rowCount, values.begin() + written);
+            }
+        }
+        written += chunk.rowCount;
+    }
+    output.rows = written;
+    if (hasTimestamp)
+        output.timestamps.resize(written);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (found[i])
+            output.values[i].resize(written);
+    }
+
+    return output;
+}
+
+Quartz::BarTable Quartz::loadCsvBars(const char* filename, unsigned threadCount)
+{
+    // The bar columns in BarColumn order, then price as a stand in for close
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(BarColumn::COUNT); ++i)
+        names.push_back(barColumnName(static_cast<BarColumn>(i)));
+    const size_t price = names.size();
+    names.push_back("price");
+
+    CsvColumns csv = loadCsvColumns(filename, names, threadCount, true);
+    if (csv.timestamps.empty() && csv.rows > 0)
+        throwCsvError(filename, 1, "no timestamp, time or date column");
+
+    const size_t close = static_cast<size_t>(BarColumn::Close);
+    if (!csv.present[close]) {
+        if (!csv.present[price])
+            throwCsvError(filename, 1, "no close or price column");
+        csv.values[close] = std::move(csv.values[price]);
+    }
+
+    BarTable table;
+    table.timestamps = std::move(csv.timestamps);
+    std::string filled;
+    for (size_t i = 0; i < price; ++i) {
+        if (i != close && !csv.present[i]) {
+            // Volume can't be made up, 0 keeps vwap() at the price
+            if (static_cast<BarColumn>(i) == BarColumn::Volume)
+                csv.values[i].assign(csv.rows, 0.0);
+            else
+                csv.values[i] = csv.values[close];
+            filled += filled.empty() ? names[i] : ", " + names[i];
+        }
+        table.columns[i] = std::move(csv.values[i]);
+    }
+    if (!filled.empty())
+        Logger::getInstance().logf(Logger::WARNING, "%s is missing %s, filled in (open, high and low from close, volume as 0)", filename, filled.c_str());
+    return table;
+}
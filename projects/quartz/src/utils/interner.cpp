@@ -0,0 +1,70 @@
+#include "utils/interner.hpp"
+
+namespace Quartz {
+	uint32_t StringInterner::hash(std::string_view name)
+	{
+		uint32_t h = 2166136261u;
+		for (char c : name)
+			h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+		return h;
+	}
+
+	Symbol StringInterner::probe(std::string_view name, uint32_t h, size_t& slot) const
+	{
+		const size_t mask = mSlots.size() - 1;
+		for (slot = h & mask; mSlots[slot] != 0; slot = (slot + 1) & mask) {
+			Symbol symbol = mSlots[slot] - 1;
+			if (mHashes[symbol] == h && mNames[symbol] == name)
+				return symbol;
+		}
+		return INVALID_SYMBOL;
+	}
+
+	Symbol StringInterner::find(std::string_view name) const
+	{
+		size_t slot;
+		std::shared_lock lock(mMutex);
+		return probe(name, hash(name), slot);
+	}
+
+	Symbol StringInterner::intern(std::string_view name)
+	{
+		const uint32_t h = hash(name);
+		size_t i;
+		{
+			std::shared_lock lock(mMutex);
+			Symbol symbol = probe(name, h, i);
+			if (symbol != INVALID_SYMBOL)
+				return symbol;
+		}
+
+		// Another thread may have added it in between
+		std::unique_lock lock(mMutex);
+		Symbol symbol = probe(name, h, i);
+		if (symbol != INVALID_SYMBOL)
+			return symbol;
+
+		symbol = static_cast<Symbol>(mNames.size());
+		mNames.push_back(mArena.copyString(name));
+		mHashes.push_back(h);
+		mSlots[i] = symbol + 1;
+
+		// Keep the load factor under one half so probe sequences stay short
+		if (mNames.size() * 2 > mSlots.size())
+			grow();
+		return symbol;
+	}
+
+	void StringInterner::grow()
+	{
+		std::vector<uint32_t> slots(mSlots.size() * 2, 0);
+		const size_t mask = slots.size() - 1;
+		for (Symbol symbol = 0; symbol < mNames.size(); ++symbol) {
+			size_t i = mHashes[symbol] & mask;
+			while (slots[i] != 0)
+				i = (i + 1) & mask;
+			slots[i] = symbol + 1;
+		}
+		mSlots = std::move(slots);
+	}
+}
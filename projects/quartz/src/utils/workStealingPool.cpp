@@ -0,0 +1,109 @@
+#include "utils/workStealingPool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	namespace {
+		uint64_t pack(uint32_t begin, uint32_t end) {
+			return static_cast<uint64_t>(begin) << 32 | end;
+		}
+
+		uint32_t rangeBegin(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+		uint32_t rangeEnd(uint64_t range) { return static_cast<uint32_t>(range); }
+	}
+
+	WorkStealingPool::WorkStealingPool(unsigned threads)
+		: mThreadCount(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+		mShares(std::make_unique<Share[]>(mThreadCount))
+	{
+	}
+
+	bool WorkStealingPool::take(unsigned worker, uint32_t& index)
+	{
+		std::atomic<uint64_t>& share = mShares[worker].range;
+		uint64_t range = share.load(std::memory_order_acquire);
+		while (rangeBegin(range) < rangeEnd(range)) {
+			if (share.compare_exchange_weak(range, pack(rangeBegin(range) + 1, rangeEnd(range)), std::memory_order_acq_rel)) {
+				index = rangeBegin(range);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WorkStealingPool::steal(unsigned worker)
+	{
+		for (;;) {
+			unsigned victim = worker;
+			uint64_t largest = 0;
+			uint32_t largestSize = 0;
+			for (unsigned i = 0; i < mThreadCount; ++i) {
+				const uint64_t range = mShares[i].range.load(std::memory_order_acquire);
+				const uint32_t size = rangeEnd(range) > rangeBegin(range) ? rangeEnd(range) - rangeBegin(range) : 0;
+				if (i != worker && size > largestSize) {
+					victim = i;
+					largest = range;
+					largestSize = size;
+				}
+			}
+			if (largestSize == 0)
+				return false;
+
+			// The victim keeps the front, the odd task of an odd share goes to the thief
+			const uint32_t split = rangeEnd(largest) - (largestSize + 1) / 2;
+			if (mShares[victim].range.compare_exchange_strong(largest, pack(rangeBegin(largest), split), std::memory_order_acq_rel)) {
+				// Only the owner adds to its empty share, thieves never touch an empty one
+				mShares[worker].range.store(pack(split, rangeEnd(largest)), std::memory_order_release);
+				return true;
+			}
+		}
+	}
+
+	void WorkStealingPool::run(size_t taskCount, const std::function<void(size_t, unsigned)>& task)
+	{
+		if (taskCount > UINT32_MAX)
+			Logger::getInstance().throwException(std::runtime_error("Work stealing pools run at most 2^32 - 1 tasks per batch"));
+
+		const uint32_t count = static_cast<uint32_t>(taskCount);
+		for (unsigned i = 0; i < mThreadCount; ++i) {
+			const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * i / mThreadCount);
+			const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (i + 1) / mThreadCount);
+			mShares[i].range.store(pack(begin, end), std::memory_order_relaxed);
+		}
+
+		std::atomic<bool> failed{ false };
+		std::exception_ptr error;
+		auto work = [&](unsigned worker) {
+			uint32_t index = 0;
+			while (!failed.load(std::memory_order_relaxed)) {
+				if (!take(worker, index)) {
+					if (!steal(worker))
+						return;
+					continue;
+				}
+				try {
+					task(index, worker);
+				}
+				catch (...) {
+					if (!failed.exchange(true))
+						error = std::current_exception();
+				}
+			}
+		};
+
+		const unsigned threadCount = static_cast<unsigned>(std::min<size_t>(mThreadCount, std::max<size_t>(taskCount, 1)));
+		std::vector<std::thread> threads;
+		for (unsigned i = 1; i < threadCount; ++i)
+			threads.emplace_back(work, i);
+		work(0);
+		for (std::thread& thread : threads)
+			thread.join();
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
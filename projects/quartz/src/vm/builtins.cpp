@@ -0,0 +1,38 @@
+#include "vm/builtins.hpp"
+
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	namespace {
+		// add_data_source(ticker, interval[optional])
+		void addDataSource(ExecutionContext& context, std::string_view ticker, std::string_view interval)
+		{
+			DataSource source;
+			source.ticker = std::string(ticker);
+			source.interval = std::string(interval);
+			context.dataSources.push_back(std::move(source));
+		}
+	}
+
+	BuiltinRegistry::BuiltinRegistry()
+	{
+		add<&addDataSource>("add_data_source", 1);
+	}
+
+	uint32_t BuiltinRegistry::insert(BuiltinFunction builtin)
+	{
+		if (builtin.minArguments > builtin.parameters.size())
+			Logger::getInstance().throwException(std::runtime_error("Builtin " + builtin.name + "() requires more arguments than it has parameters"));
+		if (mFunctions.size() >= MAX_FUNCTIONS)
+			Logger::getInstance().throwException(std::runtime_error("Can't register " + builtin.name + "(), too many builtin functions"));
+
+		const Symbol name = intern(builtin.name);
+		if (builtin.name == "emit_signal" || builtin.name == "define_input_variables" || findIndicator(name) || mIndices.count(name))
+			Logger::getInstance().throwException(std::runtime_error("Builtin " + builtin.name + "() is already registered"));
+
+		const uint32_t index = static_cast<uint32_t>(mFunctions.size());
+		mIndices[name] = index;
+		mFunctions.push_back(std::move(builtin));
+		return index;
+	}
+}
@@ -0,0 +1,120 @@
+#include "vm/bytecode.hpp"
+
+#include "vm/builtins.hpp"
+
+namespace Quartz {
+	namespace {
+		const char* opCodeName(OpCode op)
+		{
+			switch (op)
+			{
+			case OpCode::LOAD_CONST: return "LOAD_CONST";
+			case OpCode::LOAD_SLOT: return "LOAD_SLOT";
+			case OpCode::LOAD_HISTORY: return "LOAD_HISTORY";
+			case OpCode::STORE_SLOT: return "STORE_SLOT";
+			case OpCode::MOVE: return "MOVE";
+			case OpCode::INT_TO_FLOAT: return "INT_TO_FLOAT";
+			case OpCode::LESS_INT: return "LESS_INT";
+			case OpCode::LESS_FLOAT: return "LESS_FLOAT";
+			case OpCode::GREATER_INT: return "GREATER_INT";
+			case OpCode::GREATER_FLOAT: return "GREATER_FLOAT";
+			case OpCode::JUMP: return "JUMP";
+			case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+			case OpCode::CALL: return "CALL";
+			case OpCode::INDICATOR: return "INDICATOR";
+			case OpCode::EMIT_SIGNAL: return "EMIT_SIGNAL";
+			case OpCode::RETURN: return "RETURN";
+			default: return "<INVALID>";
+			}
+		}
+	}
+
+	RawValue toRawValue(const Value& value)
+	{
+		RawValue raw;
+		switch (value.type)
+		{
+		case ValueType::String: raw.string = intern(value.string); break;
+		case ValueType::Integer: raw.integer = value.integer; break;
+		case ValueType::Float: raw.floating = value.floating; break;
+		case ValueType::Bool: raw.boolean = value.boolean; break;
+		case ValueType::Signal: raw.signal = value.signal; break;
+		default: break;
+		}
+		return raw;
+	}
+
+	Value fromRawValue(RawValue raw, ValueType type)
+	{
+		switch (type)
+		{
+		case ValueType::String: return Value(symbolName(raw.string));
+		case ValueType::Integer: return Value(raw.integer);
+		case ValueType::Float: return Value(raw.floating);
+		case ValueType::Bool: return Value::fromBool(raw.boolean);
+		case ValueType::Signal: return Value::fromSignal(raw.signal);
+		default: return Value();
+		}
+	}
+
+	std::string disassemble(const CompiledStrategy& strategy, const CompiledFunction& function)
+	{
+		std::ostringstream oss;
+		for (size_t i = 0; i < function.code.size(); ++i) {
+			const Instruction& instruction = function.code[i];
+			oss << std::setw(4) << i << "  " << std::left << std::setw(14) << opCodeName(instruction.op) << std::right;
+			switch (instruction.op)
+			{
+			case OpCode::LOAD_CONST:
+				oss << "r" << +instruction.a << ", " << fromRawValue(strategy.constants[instruction.bx()], strategy.constantTypes[instruction.bx()]).toString();
+				break;
+			case OpCode::LOAD_SLOT:
+			case OpCode::STORE_SLOT:
+				oss << "r" << +instruction.a << ", [" << instruction.bx() << "]";
+				if (instruction.bx() < strategy.inputs.size())
+					oss << " " << symbolName(strategy.inputs[instruction.bx()]);
+				break;
+			case OpCode::LOAD_HISTORY:
+			{
+				const HistoryRead& read = strategy.historyReads[instruction.bx()];
+				oss << "r" << +instruction.a << ", " << symbolName(strategy.inputs[read.input]) << "[" << read.lookback << "]";
+				break;
+			}
+			case OpCode::MOVE:
+			case OpCode::INT_TO_FLOAT:
+				oss << "r" << +instruction.a << ", r" << +instruction.b;
+				break;
+			case OpCode::LESS_INT:
+			case OpCode::LESS_FLOAT:
+			case OpCode::GREATER_INT:
+			case OpCode::GREATER_FLOAT:
+				oss << "r" << +instruction.a << ", r" << +instruction.b << ", r" << +instruction.c;
+				break;
+			case OpCode::JUMP:
+				oss << "-> " << static_cast<ptrdiff_t>(i) + 1 + instruction.sbx();
+				break;
+			case OpCode::JUMP_IF_FALSE:
+				oss << "r" << +instruction.a << " -> " << static_cast<ptrdiff_t>(i) + 1 + instruction.sbx();
+				break;
+			case OpCode::CALL:
+				oss << "r" << +instruction.a << ", " << BuiltinRegistry::getInstance()[instruction.b].name << ", " << +instruction.c;
+				break;
+			case OpCode::INDICATOR:
+			{
+				const IndicatorSpec& spec = strategy.indicators[instruction.bx()];
+				oss << "r" << +instruction.a << ", " << indicatorInfo(spec.kind).name << "(" << spec.window << ") #" << instruction.bx();
+				if (spec.shareable)
+					oss << " shareable";
+				break;
+			}
+			case OpCode::EMIT_SIGNAL:
+				oss << "r" << +instruction.a;
+				break;
+			default:
+				break;
+			}
+			oss << "\n";
+		}
+		return oss.str();
+	}
+}
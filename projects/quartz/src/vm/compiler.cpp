@@ -0,0 +1,426 @@
+#include "vm/compiler.hpp"
+
+#include "vm/builtins.hpp"
+#include "vm/indicators.hpp"
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	namespace {
+		// Largest constant lookback on_data() reads of every input, the Resolver has checked they're literals
+		class LookbackCollector : public FlatASTVisitor<LookbackCollector> {
+		public:
+			LookbackCollector(const FlatAST& ast, size_t inputCount) : FlatASTVisitor(ast), lookbacks(inputCount, 0) {}
+
+			void visitIndexExpr(NodeIndex node) {
+				uint32_t& lookback = lookbacks[mAst.payloads[node]];
+				lookback = std::max(lookback, static_cast<uint32_t>(mAst.value(mAst.child(node, 0)).integer));
+			}
+
+			std::vector<uint32_t> lookbacks;
+		};
+	}
+
+	CompiledStrategy Compiler::compileStrategy(NodeIndex strategyNode)
+	{
+		CompiledStrategy strategy;
+		strategy.name = mAst.name(strategyNode);
+		mStrategy = &strategy;
+		// Opcodes are picked from the expression types
+		if (!mAst.typed())
+			throwCompileError("program has to be type checked before it is compiled");
+		// Variables were bound to frame slots by the Resolver
+		strategy.frameSize = mAst.payloads[strategyNode];
+		if (strategy.frameSize > UINT16_MAX + 1u)
+			throwCompileError("Too many variables");
+
+		NodeIndex initNode = INVALID_NODE;
+		NodeIndex onDataNode = INVALID_NODE;
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			switch (mAst.kinds[node])
+			{
+			case NodeType::StrategyInitFunction:
+				initNode = node;
+				break;
+			case NodeType::StrategyOnDataFunction:
+				onDataNode = node;
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (initNode != INVALID_NODE) {
+			strategy.inputs = mAst.inputVariables(initNode);
+			compileFunction(initNode, FunctionKind::Init, strategy.init);
+		}
+		else {
+			strategy.init.code.emplace_back(OpCode::RETURN);
+		}
+		strategy.historyCapacities.assign(strategy.inputs.size(), 0);
+
+		if (onDataNode != INVALID_NODE) {
+			sizeHistory(onDataNode);
+			compileFunction(onDataNode, FunctionKind::OnData, strategy.onData);
+		}
+		else
+			strategy.onData.code.emplace_back(OpCode::RETURN);
+
+		mStrategy = nullptr;
+		return strategy;
+	}
+
+	void Compiler::sizeHistory(NodeIndex onDataNode)
+	{
+		// Each input only keeps as many bars as on_data() can look back on, an input that is never
+		// indexed doesn't get a ring at all
+		LookbackCollector collector(mAst, mStrategy->inputs.size());
+		collector.visit(onDataNode);
+
+		uint64_t valueCount = 0;
+		for (size_t input = 0; input < collector.lookbacks.size(); ++input) {
+			const uint32_t lookback = collector.lookbacks[input];
+			const uint32_t capacity = lookback > 0 ? historyCapacity(lookback) : 0;
+			mStrategy->historyCapacities[input] = capacity;
+			valueCount += capacity;
+		}
+		// Native code addresses the rings with 32-bit byte offsets
+		if (valueCount * sizeof(double) > INT32_MAX)
+			throwCompileError("Input history is too large");
+	}
+
+	void Compiler::compileFunction(NodeIndex functionNode, FunctionKind kind, CompiledFunction& function)
+	{
+		mFunction = &function;
+		mFunctionKind = kind;
+		mConditionalDepth = 0;
+		mMayHaveReturned = false;
+		function.registerCount = 0;
+
+		// Functions always have their body block as the only child
+		compileBlock(mAst.child(functionNode, 0));
+		emit(Instruction(OpCode::RETURN));
+
+		mFunction = nullptr;
+	}
+
+	void Compiler::compileBlock(NodeIndex block)
+	{
+		for (uint32_t i = 0; i < mAst.childCount[block]; ++i)
+			compileStatement(mAst.child(block, i));
+	}
+
+	void Compiler::compileStatement(NodeIndex node)
+	{
+		// Temporaries never outlive the statement that created them
+		mNextRegister = 0;
+
+		switch (mAst.kinds[node])
+		{
+		case NodeType::ExprStmt:
+			compileExpression(mAst.child(node, 0), allocateRegister());
+			break;
+		case NodeType::VarDecl:
+		case NodeType::AssignStmt:
+			compileStore(node);
+			break;
+		case NodeType::IfStmt:
+			compileIf(node);
+			break;
+		case NodeType::ReturnStmt:
+			emit(Instruction(OpCode::RETURN));
+			mMayHaveReturned = true;
+			break;
+		case NodeType::Block:
+			compileBlock(node);
+			break;
+		default:
+			throwCompileError("Unsupported statement");
+		}
+	}
+
+	void Compiler::compileIf(NodeIndex node)
+	{
+		uint8_t condition = allocateRegister();
+		compileExpression(mAst.child(node, 0), condition);
+		size_t skipThen = emit(Instruction::withBx(OpCode::JUMP_IF_FALSE, condition, 0));
+
+		// The condition runs whenever the if does, the branches don't
+		mConditionalDepth++;
+		compileStatement(mAst.child(node, 1));
+
+		if (mAst.childCount[node] < 3) {
+			patchJump(skipThen);
+			mConditionalDepth--;
+			return;
+		}
+
+		size_t skipElse = emit(Instruction::withBx(OpCode::JUMP, 0, 0));
+		patchJump(skipThen);
+		// The else branch is either a block or a chained if statement
+		compileStatement(mAst.child(node, 2));
+		patchJump(skipElse);
+		mConditionalDepth--;
+	}
+
+	void Compiler::compileStore(NodeIndex node)
+	{
+		uint8_t value = allocateRegister();
+		compileExpressionAs(mAst.child(node, 0), value, mAst.type(node));
+		emit(Instruction::withBx(OpCode::STORE_SLOT, value, static_cast<uint16_t>(mAst.payloads[node])));
+	}
+
+	void Compiler::compileCall(NodeIndex node, uint8_t target)
+	{
+		const Symbol callee = mAst.name(node);
+		const uint32_t argumentCount = mAst.childCount[node];
+
+		if (callee == mEmitSignalSymbol) {
+			if (mFunctionKind != FunctionKind::OnData)
+				throwCompileError("emit_signal() can only be called from on_data()");
+			if (argumentCount != 1)
+				throwCompileError("emit_signal() takes exactly one argument");
+			compileExpression(mAst.child(node, 0), target);
+			emit(Instruction(OpCode::EMIT_SIGNAL, target));
+			return;
+		}
+
+		if (callee == mDefineInputsSymbol) {
+			// Inputs are laid out at compile time, there is nothing left to do at runtime
+			if (mFunctionKind != FunctionKind::Init)
+				throwCompileError("define_input_variables() can only be called from init()");
+			return;
+		}
+
+		if (const IndicatorInfo* indicator = findIndicator(callee)) {
+			compileIndicator(node, target, *indicator);
+			return;
+		}
+
+		// The type checker bound the call and checked its arguments
+		const uint32_t index = mAst.payloads[node];
+		const BuiltinFunction& builtin = BuiltinRegistry::getInstance()[index];
+
+		// Arguments are passed in consecutive registers starting at the call's result. Every register
+		// is allocated before any argument is compiled, nested calls get their own run of registers.
+		const uint8_t base = callRegister(target);
+		for (uint32_t i = 1; i < argumentCount; ++i)
+			allocateRegister();
+		for (uint32_t i = 0; i < argumentCount; ++i)
+			compileExpressionAs(mAst.child(node, i), static_cast<uint8_t>(base + i), builtin.parameters[i]);
+		emit(Instruction(OpCode::CALL, base, static_cast<uint8_t>(index), static_cast<uint8_t>(argumentCount)));
+		if (base != target)
+			emit(Instruction(OpCode::MOVE, target, base));
+	}
+
+	void Compiler::compileIndicator(NodeIndex node, uint8_t target, const IndicatorInfo& indicator)
+	{
+		// Indicators advance by one bar per call
+		if (mFunctionKind != FunctionKind::OnData)
+			throwCompileError(std::string(indicator.name) + "() can only be called from on_data()");
+
+		// INDICATOR always reads two registers, the second is only meaningful for two series
+		const uint8_t base = callRegister(target);
+		const uint8_t second = allocateRegister();
+		compileExpressionAs(mAst.child(node, 0), base, ValueType::Float);
+		if (indicator.seriesArguments > 1)
+			compileExpressionAs(mAst.child(node, 1), second, ValueType::Float);
+
+		// The Resolver numbered the call site and checked its window is a constant. Nested
+		// indicators have been compiled by now, so whether they're shareable is known.
+		const uint32_t index = mAst.payloads[node];
+		const NodeIndex window = mAst.child(node, indicator.seriesArguments);
+		IndicatorSpec spec{ indicator.kind, static_cast<uint32_t>(mAst.value(window).integer) };
+		spec.shareable = mConditionalDepth == 0 && !mMayHaveReturned;
+		for (uint32_t i = 0; i < indicator.seriesArguments; ++i) {
+			spec.operands[i] = indicatorOperand(mAst.child(node, i));
+			spec.shareable &= spec.operands[i].kind != IndicatorOperand::Kind::None;
+		}
+
+		std::vector<IndicatorSpec>& indicators = mStrategy->indicators;
+		if (indicators.size() <= index)
+			indicators.resize(index + 1);
+		indicators[index] = spec;
+
+		emit(Instruction::withBx(OpCode::INDICATOR, base, static_cast<uint16_t>(index)));
+		if (base != target)
+			emit(Instruction(OpCode::MOVE, target, base));
+	}
+
+	IndicatorOperand Compiler::indicatorOperand(NodeIndex node) const
+	{
+		IndicatorOperand operand;
+		switch (mAst.kinds[node])
+		{
+		case NodeType::IdentifierExpr:
+			// Locals can hold anything, only inputs come straight from the feed
+			if (mAst.payloads[node] < mStrategy->inputs.size()) {
+				operand.kind = IndicatorOperand::Kind::Input;
+				operand.index = mAst.payloads[node];
+			}
+			break;
+		case NodeType::LiteralExpr:
+		{
+			const Value& value = mAst.value(node);
+			operand.kind = IndicatorOperand::Kind::Constant;
+			operand.constant = value.type == ValueType::Integer ? static_cast<double>(value.integer) : value.floating;
+			break;
+		}
+		case NodeType::CallExpr:
+		{
+			const uint32_t index = mAst.payloads[node];
+			if (findIndicator(mAst.name(node)) && mStrategy->indicators[index].shareable) {
+				operand.kind = IndicatorOperand::Kind::Indicator;
+				operand.index = index;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		return operand;
+	}
+
+	uint8_t Compiler::callRegister(uint8_t target)
+	{
+		// Registers above the most recently allocated one are free, otherwise the call is made in
+		// fresh registers and its result moved into target
+		return target + 1 == mNextRegister ? target : allocateRegister();
+	}
+
+	void Compiler::compileExpression(NodeIndex node, uint8_t target)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::LiteralExpr:
+			emit(Instruction::withBx(OpCode::LOAD_CONST, target, addConstant(toRawValue(mAst.value(node)), mAst.value(node).type)));
+			break;
+		case NodeType::Signal:
+		{
+			RawValue signal;
+			signal.signal = mAst.signal(node);
+			emit(Instruction::withBx(OpCode::LOAD_CONST, target, addConstant(signal, ValueType::Signal)));
+			break;
+		}
+		case NodeType::IdentifierExpr:
+		{
+			// Consts have already been folded into literals, only inputs and locals are left
+			const uint32_t slot = mAst.payloads[node];
+			if (slot < mStrategy->inputs.size() && mFunctionKind != FunctionKind::OnData)
+				throwCompileError("Input variable '" + std::string(symbolName(mAst.name(node))) + "' can only be read from on_data()");
+			emit(Instruction::withBx(OpCode::LOAD_SLOT, target, static_cast<uint16_t>(slot)));
+			break;
+		}
+		case NodeType::IndexExpr:
+			compileHistory(node, target);
+			break;
+		case NodeType::BinaryExpr:
+		{
+			const NodeIndex leftNode = mAst.child(node, 0);
+			const NodeIndex rightNode = mAst.child(node, 1);
+			// Mixed comparisons widen the int side to float
+			const bool integer = mAst.type(leftNode) == ValueType::Integer && mAst.type(rightNode) == ValueType::Integer;
+			const ValueType operandType = integer ? ValueType::Integer : ValueType::Float;
+
+			OpCode op;
+			switch (mAst.tokenType(node))
+			{
+			case LESS_THAN: op = integer ? OpCode::LESS_INT : OpCode::LESS_FLOAT; break;
+			case GREATER_THAN: op = integer ? OpCode::GREATER_INT : OpCode::GREATER_FLOAT; break;
+			default:
+				throwCompileError(std::string("Unsupported binary operator ") + tokenTypeToString(mAst.tokenType(node)));
+			}
+			// The left operand can be evaluated straight into the target
+			compileExpressionAs(leftNode, target, operandType);
+			uint8_t right = allocateRegister();
+			compileExpressionAs(rightNode, right, operandType);
+			emit(Instruction(op, target, target, right));
+			break;
+		}
+		case NodeType::CallExpr:
+			compileCall(node, target);
+			break;
+		default:
+			throwCompileError("Unsupported expression");
+		}
+	}
+
+	void Compiler::compileHistory(NodeIndex node, uint8_t target)
+	{
+		const uint32_t input = mAst.payloads[node];
+		if (mFunctionKind != FunctionKind::OnData)
+			throwCompileError("Input variable '" + std::string(symbolName(mAst.name(node))) + "' can only be read from on_data()");
+
+		// x[0] is the current bar, which is already in the frame
+		const uint32_t lookback = static_cast<uint32_t>(mAst.value(mAst.child(node, 0)).integer);
+		if (lookback == 0) {
+			emit(Instruction::withBx(OpCode::LOAD_SLOT, target, static_cast<uint16_t>(input)));
+			return;
+		}
+
+		std::vector<HistoryRead>& reads = mStrategy->historyReads;
+		size_t index = 0;
+		while (index < reads.size() && (reads[index].input != input || reads[index].lookback != lookback))
+			++index;
+		if (index == reads.size()) {
+			if (reads.size() > UINT16_MAX)
+				throwCompileError("Too many history reads");
+			const uint32_t capacity = mStrategy->historyCapacities[input];
+			reads.push_back(HistoryRead{ input, lookback, historyOffsets(mStrategy->historyCapacities)[input], capacity - 1 });
+		}
+		emit(Instruction::withBx(OpCode::LOAD_HISTORY, target, static_cast<uint16_t>(index)));
+	}
+
+	void Compiler::compileExpressionAs(NodeIndex node, uint8_t target, ValueType type)
+	{
+		compileExpression(node, target);
+		if (mAst.type(node) == ValueType::Integer && type == ValueType::Float)
+			emit(Instruction(OpCode::INT_TO_FLOAT, target, target));
+	}
+
+	uint8_t Compiler::allocateRegister()
+	{
+		if (mNextRegister == UINT8_MAX)
+			throwCompileError("Expression is too complex, ran out of registers");
+		uint8_t reg = mNextRegister++;
+		if (mNextRegister > mFunction->registerCount)
+			mFunction->registerCount = mNextRegister;
+		return reg;
+	}
+
+	uint16_t Compiler::addConstant(RawValue value, ValueType type)
+	{
+		std::vector<RawValue>& constants = mStrategy->constants;
+		for (size_t i = 0; i < constants.size(); ++i) {
+			if (mStrategy->constantTypes[i] == type && constants[i].integer == value.integer)
+				return static_cast<uint16_t>(i);
+		}
+		if (constants.size() > UINT16_MAX)
+			throwCompileError("Too many constants");
+		constants.push_back(value);
+		mStrategy->constantTypes.push_back(type);
+		return static_cast<uint16_t>(constants.size() - 1);
+	}
+
+	size_t Compiler::emit(Instruction instruction)
+	{
+		mFunction->code.push_back(instruction);
+		return mFunction->code.size() - 1;
+	}
+
+	void Compiler::patchJump(size_t jump)
+	{
+		// Jumps are relative to the instruction following them
+		ptrdiff_t offset = static_cast<ptrdiff_t>(mFunction->code.size()) - static_cast<ptrdiff_t>(jump + 1);
+		if (offset > INT16_MAX)
+			throwCompileError("Branch is too large");
+		Instruction& instruction = mFunction->code[jump];
+		instruction = Instruction::withBx(instruction.op, instruction.a, static_cast<uint16_t>(offset));
+	}
+
+	void Compiler::throwCompileError(const std::string& message) const
+	{
+		std::string strategy = mStrategy ? std::string(symbolName(mStrategy->name)) : "<unknown>";
+		Logger::getInstance().throwException(std::runtime_error("Compile error in strategy '" + strategy + "': " + message));
+	}
+}
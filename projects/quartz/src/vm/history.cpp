@@ -0,0 +1,106 @@
+#include "vm/history.hpp"
+
+#include <algorithm>
+
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	uint32_t historyCapacity(uint32_t lookback)
+	{
+		uint32_t capacity = 1;
+		while (capacity <= lookback)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	std::vector<uint32_t> historyOffsets(const std::vector<uint32_t>& capacities)
+	{
+		std::vector<uint32_t> offsets;
+		uint32_t offset = 0;
+		for (uint32_t capacity : capacities) {
+			offsets.push_back(offset);
+			offset += capacity;
+		}
+		return offsets;
+	}
+
+	HistoryLayout::HistoryLayout(const std::vector<uint32_t>& capacities)
+	{
+		const std::vector<uint32_t> offsets = historyOffsets(capacities);
+		for (uint32_t input = 0; input < capacities.size(); ++input) {
+			const uint32_t capacity = capacities[input];
+			if (capacity == 0)
+				continue;
+			if ((capacity & (capacity - 1)) != 0 || capacity > historyCapacity(MAX_HISTORY_LOOKBACK))
+				Logger::getInstance().throwException(std::runtime_error("Invalid history capacity " + std::to_string(capacity)));
+			mRings.push_back(Ring{ input, offsets[input], capacity - 1 });
+			mValueCount += capacity;
+		}
+	}
+
+	InputHistory::InputHistory(const std::vector<uint32_t>& capacities)
+		: mOwnedLayout(std::make_shared<HistoryLayout>(capacities))
+	{
+		mOwnedValues.resize(mOwnedLayout->valueCount());
+		pointAtOwned();
+	}
+
+	InputHistory& InputHistory::operator=(const InputHistory& other)
+	{
+		if (this == &other)
+			return *this;
+		mOwnedLayout = other.mOwnedLayout;
+		mOwnedValues = other.mOwnedValues;
+		mOwnedBar = other.mOwnedBar;
+		if (mOwnedLayout) {
+			pointAtOwned();
+		}
+		else {
+			mLayout = other.mLayout;
+			mValues = other.mValues;
+			mBar = other.mBar;
+		}
+		return *this;
+	}
+
+	InputHistory& InputHistory::operator=(InputHistory&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		mOwnedLayout = std::move(other.mOwnedLayout);
+		mOwnedValues = std::move(other.mOwnedValues);
+		mOwnedBar = other.mOwnedBar;
+		if (mOwnedLayout) {
+			pointAtOwned();
+		}
+		else {
+			mLayout = other.mLayout;
+			mValues = other.mValues;
+			mBar = other.mBar;
+		}
+		other.mLayout = nullptr;
+		other.mValues = nullptr;
+		other.mBar = nullptr;
+		return *this;
+	}
+
+	void InputHistory::pointAtOwned()
+	{
+		mLayout = mOwnedLayout.get();
+		mValues = mOwnedValues.data();
+		mBar = &mOwnedBar;
+	}
+
+	void InputHistory::push(const double* inputs)
+	{
+		double* values = mValues;
+		const uint64_t bar = ++*mBar;
+		if (bar == 0) {
+			for (const Ring& ring : mLayout->mRings)
+				std::fill(values + ring.offset, values + ring.offset + ring.mask + 1, inputs[ring.input]);
+			return;
+		}
+		for (const Ring& ring : mLayout->mRings)
+			values[ring.offset + (bar & ring.mask)] = inputs[ring.input];
+	}
+}
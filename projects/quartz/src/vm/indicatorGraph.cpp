@@ -0,0 +1,84 @@
+#include "vm/indicatorGraph.hpp"
+
+namespace Quartz {
+	namespace {
+		constexpr uint32_t NO_NODE = 0xFFFFFFFFu;
+	}
+
+	void IndicatorGraph::addStrategy(const CompiledStrategy& strategy, const std::vector<uint32_t>& inputColumns, IndicatorSet& indicators)
+	{
+		// Node of every call site, nested indicators are added before the calls reading them
+		std::vector<uint32_t> nodes(strategy.indicators.size(), NO_NODE);
+		for (uint32_t callSite = 0; callSite < strategy.indicators.size(); ++callSite) {
+			if (strategy.indicators[callSite].shareable)
+				mConsumers.push_back(Consumer{ &indicators, callSite, addNode(strategy, inputColumns, nodes, callSite) });
+		}
+	}
+
+	uint32_t IndicatorGraph::addNode(const CompiledStrategy& strategy, const std::vector<uint32_t>& inputColumns, std::vector<uint32_t>& nodes, uint32_t callSite)
+	{
+		if (nodes[callSite] != NO_NODE)
+			return nodes[callSite];
+
+		const IndicatorSpec& spec = strategy.indicators[callSite];
+		Node node{ spec.kind, spec.window, {} };
+		for (size_t i = 0; i < 2; ++i) {
+			IndicatorOperand operand = spec.operands[i];
+			if (operand.kind == IndicatorOperand::Kind::Input)
+				operand.index = inputColumns[operand.index];
+			else if (operand.kind == IndicatorOperand::Kind::Indicator)
+				operand.index = addNode(strategy, inputColumns, nodes, operand.index);
+			node.operands[i] = operand;
+		}
+
+		const IndicatorOperand* operands = node.operands;
+		const Key key(static_cast<uint32_t>(node.kind), node.window,
+			static_cast<uint8_t>(operands[0].kind), operands[0].index, operands[0].constant,
+			static_cast<uint8_t>(operands[1].kind), operands[1].index, operands[1].constant);
+		auto existing = mNodeIndices.find(key);
+		if (existing != mNodeIndices.end())
+			return nodes[callSite] = existing->second;
+
+		const uint32_t index = static_cast<uint32_t>(mNodes.size());
+		mNodes.push_back(node);
+		mNodeIndices.emplace(key, index);
+		return nodes[callSite] = index;
+	}
+
+	void IndicatorGraph::link()
+	{
+		std::vector<IndicatorSpec> specs;
+		for (const Node& node : mNodes)
+			specs.push_back(IndicatorSpec{ node.kind, node.window });
+		mState = IndicatorSet(specs);
+		mValues.assign(mNodes.size(), 0.0);
+
+		for (const Consumer& consumer : mConsumers)
+			consumer.indicators->share(consumer.callSite, &mValues[consumer.node]);
+	}
+
+	void IndicatorGraph::unlink()
+	{
+		for (const Consumer& consumer : mConsumers)
+			consumer.indicators->share(consumer.callSite, nullptr);
+	}
+
+	void IndicatorGraph::update(const double* row)
+	{
+		auto read = [&](const IndicatorOperand& operand) {
+			switch (operand.kind)
+			{
+			case IndicatorOperand::Kind::Input: return row[operand.index];
+			case IndicatorOperand::Kind::Indicator: return mValues[operand.index];
+			case IndicatorOperand::Kind::Constant: return operand.constant;
+			default: return 0.0;
+			}
+		};
+
+		// Nodes only read earlier nodes, so one pass in order sees every operand's value for this bar
+		for (uint32_t i = 0; i < mNodes.size(); ++i) {
+			const Node& node = mNodes[i];
+			mValues[i] = mState.update(i, read(node.operands[0]), read(node.operands[1]));
+		}
+	}
+}
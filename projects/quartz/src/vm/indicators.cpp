@@ -0,0 +1,296 @@
+#include "vm/indicators.hpp"
+
+#include <cmath>
+
+#include "logging/logging.hpp"
+
+namespace Quartz {
+	namespace {
+		const IndicatorInfo INDICATORS[] = {
+			{ "sma", IndicatorKind::Sma, 1 },
+			{ "ema", IndicatorKind::Ema, 1 },
+			{ "rolling_std", IndicatorKind::RollingStd, 1 },
+			{ "rolling_min", IndicatorKind::RollingMin, 1 },
+			{ "rolling_max", IndicatorKind::RollingMax, 1 },
+			{ "vwap", IndicatorKind::Vwap, 2 },
+		};
+
+		static_assert(sizeof(INDICATORS) / sizeof(INDICATORS[0]) == static_cast<size_t>(IndicatorKind::COUNT),
+			"Every indicator needs an entry");
+	}
+
+	const IndicatorInfo* findIndicator(Symbol name)
+	{
+		// Interned once, the type checker and compiler look every call up
+		static const std::vector<Symbol> symbols = [] {
+			std::vector<Symbol> result;
+			for (const IndicatorInfo& info : INDICATORS)
+				result.push_back(intern(info.name));
+			return result;
+		}();
+
+		for (size_t i = 0; i < symbols.size(); ++i) {
+			if (symbols[i] == name)
+				return &INDICATORS[i];
+		}
+		return nullptr;
+	}
+
+	const IndicatorInfo& indicatorInfo(IndicatorKind kind)
+	{
+		return INDICATORS[static_cast<size_t>(kind)];
+	}
+
+	IndicatorLayout::IndicatorLayout(const std::vector<IndicatorSpec>& specs)
+	{
+		for (const IndicatorSpec& spec : specs) {
+			if (spec.kind >= IndicatorKind::COUNT || spec.window == 0 || spec.window > MAX_INDICATOR_WINDOW)
+				Logger::getInstance().throwException(std::runtime_error("Invalid indicator with window " + std::to_string(spec.window)));
+
+			Slot slot;
+			slot.kind = spec.kind;
+			slot.window = spec.window;
+			slot.values = mValueCount;
+			slot.bars = mBarCount;
+			slot.alpha = 2.0 / (static_cast<double>(spec.window) + 1.0);
+
+			switch (spec.kind)
+			{
+			case IndicatorKind::Ema:
+				break;
+			case IndicatorKind::RollingMin:
+			case IndicatorKind::RollingMax:
+				mValueCount += spec.window;
+				mBarCount += spec.window;
+				break;
+			case IndicatorKind::Vwap:
+				// Price times volume followed by volume
+				mValueCount += static_cast<size_t>(spec.window) * 2;
+				break;
+			default:
+				mValueCount += spec.window;
+				break;
+			}
+			mSlots.push_back(slot);
+		}
+	}
+
+	IndicatorSet::IndicatorSet(const std::vector<IndicatorSpec>& specs)
+		: mOwnedLayout(std::make_shared<IndicatorLayout>(specs))
+	{
+		mOwnedCursors.resize(mOwnedLayout->size());
+		mOwnedValues.resize(mOwnedLayout->valueCount());
+		mOwnedBars.resize(mOwnedLayout->barCount());
+		pointAtOwned();
+	}
+
+	IndicatorSet& IndicatorSet::operator=(const IndicatorSet& other)
+	{
+		if (this == &other)
+			return *this;
+		mOwnedLayout = other.mOwnedLayout;
+		mOwnedCursors = other.mOwnedCursors;
+		mOwnedValues = other.mOwnedValues;
+		mOwnedBars = other.mOwnedBars;
+		if (mOwnedLayout) {
+			pointAtOwned();
+		}
+		else {
+			mLayout = other.mLayout;
+			mCursors = other.mCursors;
+			mValues = other.mValues;
+			mBars = other.mBars;
+		}
+		return *this;
+	}
+
+	IndicatorSet& IndicatorSet::operator=(IndicatorSet&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		mOwnedLayout = std::move(other.mOwnedLayout);
+		mOwnedCursors = std::move(other.mOwnedCursors);
+		mOwnedValues = std::move(other.mOwnedValues);
+		mOwnedBars = std::move(other.mOwnedBars);
+		if (mOwnedLayout) {
+			pointAtOwned();
+		}
+		else {
+			mLayout = other.mLayout;
+			mCursors = other.mCursors;
+			mValues = other.mValues;
+			mBars = other.mBars;
+		}
+		other.mLayout = nullptr;
+		other.mCursors = nullptr;
+		other.mValues = nullptr;
+		other.mBars = nullptr;
+		return *this;
+	}
+
+	void IndicatorSet::pointAtOwned()
+	{
+		mLayout = mOwnedLayout.get();
+		mCursors = mOwnedCursors.data();
+		mValues = mOwnedValues.data();
+		mBars = mOwnedBars.data();
+	}
+
+	double IndicatorSet::update(uint32_t index, double value, double second)
+	{
+		const Slot& slot = mLayout->mSlots[index];
+		IndicatorCursor& cursor = mCursors[index];
+		if (cursor.shared)
+			return *cursor.shared;
+		switch (slot.kind)
+		{
+		case IndicatorKind::Sma:
+			return updateSum(slot, cursor, value);
+		case IndicatorKind::Ema:
+			if (cursor.count == 0) {
+				cursor.count = 1;
+				cursor.mean = value;
+			}
+			else {
+				cursor.mean += slot.alpha * (value - cursor.mean);
+			}
+			return cursor.mean;
+		case IndicatorKind::RollingStd:
+			return updateStd(slot, cursor, value);
+		case IndicatorKind::RollingMin:
+			return updateExtreme(slot, cursor, value, false);
+		case IndicatorKind::RollingMax:
+			return updateExtreme(slot, cursor, value, true);
+		case IndicatorKind::Vwap:
+			return updateVwap(slot, cursor, value, second);
+		default:
+			return 0.0;
+		}
+	}
+
+	double IndicatorSet::updateSum(const Slot& slot, IndicatorCursor& cursor, double value)
+	{
+		double* ring = mValues + slot.values;
+		if (cursor.count == slot.window)
+			cursor.sum -= ring[cursor.next];
+		else
+			cursor.count++;
+		ring[cursor.next] = value;
+		cursor.sum += value;
+
+		if (++cursor.next == slot.window) {
+			cursor.next = 0;
+			if (cursor.count == slot.window) {
+				// Once per window, so still O(1) per bar
+				double sum = 0.0;
+				for (uint32_t i = 0; i < slot.window; ++i)
+					sum += ring[i];
+				cursor.sum = sum;
+			}
+		}
+		return cursor.sum / cursor.count;
+	}
+
+	double IndicatorSet::updateStd(const Slot& slot, IndicatorCursor& cursor, double value)
+	{
+		// Welford's update, sliding the oldest value out once the window is full. sum2 holds the
+		// sum of squared deviations from the mean.
+		double* ring = mValues + slot.values;
+		if (cursor.count < slot.window) {
+			cursor.count++;
+			const double delta = value - cursor.mean;
+			cursor.mean += delta / cursor.count;
+			cursor.sum2 += delta * (value - cursor.mean);
+		}
+		else {
+			const double oldest = ring[cursor.next];
+			const double mean = cursor.mean + (value - oldest) / slot.window;
+			cursor.sum2 += (value - oldest) * (value - mean + oldest - cursor.mean);
+			cursor.mean = mean;
+		}
+		ring[cursor.next] = value;
+
+		if (++cursor.next == slot.window) {
+			cursor.next = 0;
+			if (cursor.count == slot.window) {
+				double sum = 0.0;
+				for (uint32_t i = 0; i < slot.window; ++i)
+					sum += ring[i];
+				cursor.mean = sum / slot.window;
+				double squares = 0.0;
+				for (uint32_t i = 0; i < slot.window; ++i)
+					squares += (ring[i] - cursor.mean) * (ring[i] - cursor.mean);
+				cursor.sum2 = squares;
+			}
+		}
+		return std::sqrt(std::max(cursor.sum2, 0.0) / cursor.count);
+	}
+
+	double IndicatorSet::updateExtreme(const Slot& slot, IndicatorCursor& cursor, double value, bool maximum)
+	{
+		// Values in the deque only get worse from front to back, anything the new value beats can
+		// never be the extreme again. count is the deque's length here.
+		double* values = mValues + slot.values;
+		uint64_t* bars = mBars + slot.bars;
+		const uint32_t window = slot.window;
+		const uint64_t bar = cursor.bar++;
+
+		// At most one entry expires per bar
+		if (cursor.count > 0 && bars[cursor.head] + window <= bar) {
+			cursor.head = cursor.head + 1 == window ? 0 : cursor.head + 1;
+			cursor.count--;
+		}
+		while (cursor.count > 0) {
+			uint32_t back = cursor.head + cursor.count - 1;
+			back = back >= window ? back - window : back;
+			if (maximum ? values[back] > value : values[back] < value)
+				break;
+			cursor.count--;
+		}
+
+		uint32_t end = cursor.head + cursor.count;
+		end = end >= window ? end - window : end;
+		values[end] = value;
+		bars[end] = bar;
+		cursor.count++;
+		return values[cursor.head];
+	}
+
+	double IndicatorSet::updateVwap(const Slot& slot, IndicatorCursor& cursor, double price, double volume)
+	{
+		double* weighted = mValues + slot.values;
+		double* volumes = weighted + slot.window;
+		if (cursor.count == slot.window) {
+			cursor.sum -= weighted[cursor.next];
+			cursor.sum2 -= volumes[cursor.next];
+		}
+		else {
+			cursor.count++;
+		}
+		weighted[cursor.next] = price * volume;
+		volumes[cursor.next] = volume;
+		cursor.sum += price * volume;
+		cursor.sum2 += volume;
+
+		if (++cursor.next == slot.window) {
+			cursor.next = 0;
+			if (cursor.count == slot.window) {
+				double sum = 0.0;
+				double sum2 = 0.0;
+				for (uint32_t i = 0; i < slot.window; ++i) {
+					sum += weighted[i];
+					sum2 += volumes[i];
+				}
+				cursor.sum = sum;
+				cursor.sum2 = sum2;
+			}
+		}
+		// Without any volume there is nothing to weight by
+		return cursor.sum2 != 0.0 ? cursor.sum / cursor.sum2 : price;
+	}
+
+	double updateIndicator(void* indicators, uint32_t index, double value, double second)
+	{
+		return static_cast<IndicatorSet*>(indicators)->update(index, value, second);
+	}
+}
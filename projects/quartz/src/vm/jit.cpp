@@ -0,0 +1,286 @@
+#include "vm/jit.hpp"
+
+#include <algorithm>
+
+#include "logging/logging.hpp"
+
+// The emitter targets the System V calling convention, other hosts keep interpreting
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define QUARTZ_JIT_X64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define QUARTZ_JIT_X64 0
+#endif
+
+namespace Quartz {
+#if QUARTZ_JIT_X64
+	namespace {
+		// Every VM register gets an 8 byte stack slot. The strategy frame is addressed through rbx, the
+		// indicator state is kept in r12, the input history in r14 with its current bar in r15 and the
+		// emitted signal in r13d until RETURN moves it into eax. All five are callee saved so they
+		// survive calls into indicators.
+		class X64Emitter {
+		public:
+			std::vector<uint8_t> code;
+
+			void byte(uint8_t value) { code.push_back(value); }
+
+			void u32(uint32_t value) {
+				for (int i = 0; i < 4; ++i)
+					byte(static_cast<uint8_t>(value >> (i * 8)));
+			}
+
+			void u64(uint64_t value) {
+				for (int i = 0; i < 8; ++i)
+					byte(static_cast<uint8_t>(value >> (i * 8)));
+			}
+
+			// ModRM + SIB for [rsp + disp32]
+			void slotOperand(uint8_t reg, uint8_t slot) {
+				byte(static_cast<uint8_t>(0x84 | (reg << 3)));
+				byte(0x24);
+				u32(static_cast<uint32_t>(slot) * 8);
+			}
+
+			// Five pushes on top of the return address leave rsp 16 byte aligned, stackSize keeps it that way
+			void prologue(uint32_t stackSize) {
+				byte(0x53);                                              // push rbx
+				byte(0x41); byte(0x54);                                  // push r12
+				byte(0x41); byte(0x55);                                  // push r13
+				byte(0x41); byte(0x56);                                  // push r14
+				byte(0x41); byte(0x57);                                  // push r15
+				byte(0x48); byte(0x81); byte(0xEC); u32(stackSize);      // sub rsp, stackSize
+				byte(0x48); byte(0x89); byte(0xFB);                      // mov rbx, rdi
+				byte(0x49); byte(0x89); byte(0xF4);                      // mov r12, rsi
+				byte(0x49); byte(0x89); byte(0xD6);                      // mov r14, rdx
+				byte(0x49); byte(0x89); byte(0xCF);                      // mov r15, rcx
+				byte(0x41); byte(0xBD); u32(static_cast<uint32_t>(HOLD)); // mov r13d, HOLD
+			}
+
+			void epilogue(uint32_t stackSize) {
+				byte(0x44); byte(0x89); byte(0xE8);                      // mov eax, r13d
+				byte(0x48); byte(0x81); byte(0xC4); u32(stackSize);      // add rsp, stackSize
+				byte(0x41); byte(0x5F);                                  // pop r15
+				byte(0x41); byte(0x5E);                                  // pop r14
+				byte(0x41); byte(0x5D);                                  // pop r13
+				byte(0x41); byte(0x5C);                                  // pop r12
+				byte(0x5B);                                              // pop rbx
+				byte(0xC3);                                              // ret
+			}
+
+			void storeImmediate(uint8_t slot, uint64_t value) {
+				byte(0x48); byte(0xB8); u64(value);                      // mov rax, imm64
+				byte(0x48); byte(0x89); slotOperand(0, slot);            // mov [slot], rax
+			}
+
+			void loadSlot(uint8_t slot, uint16_t frameSlot) {
+				byte(0x48); byte(0x8B); byte(0x83);                      // mov rax, [rbx + disp32]
+				u32(static_cast<uint32_t>(frameSlot) * 8);
+				byte(0x48); byte(0x89); slotOperand(0, slot);            // mov [slot], rax
+			}
+
+			void storeSlot(uint16_t frameSlot, uint8_t slot) {
+				byte(0x48); byte(0x8B); slotOperand(0, slot);            // mov rax, [slot]
+				byte(0x48); byte(0x89); byte(0x83);                      // mov [rbx + disp32], rax
+				u32(static_cast<uint32_t>(frameSlot) * 8);
+			}
+
+			// R[slot] = history[offset + ((bar - lookback) & mask)], offset and mask are constants of the ring
+			void loadHistory(uint8_t slot, const HistoryRead& read) {
+				byte(0x4C); byte(0x89); byte(0xF8);                      // mov rax, r15
+				byte(0x48); byte(0x2D); u32(read.lookback);              // sub rax, lookback
+				byte(0x48); byte(0x25); u32(read.mask);                  // and rax, mask
+				byte(0x49); byte(0x8B); byte(0x84); byte(0xC6);          // mov rax, [r14 + rax * 8 + disp32]
+				u32(read.offset * 8);
+				byte(0x48); byte(0x89); slotOperand(0, slot);            // mov [slot], rax
+			}
+
+			void move(uint8_t target, uint8_t source) {
+				byte(0x48); byte(0x8B); slotOperand(0, source);          // mov rax, [source]
+				byte(0x48); byte(0x89); slotOperand(0, target);          // mov [target], rax
+			}
+
+			// R[slot] = updateIndicator(indicators, index, R[slot], R[slot + 1])
+			void callIndicator(uint8_t slot, uint16_t index) {
+				byte(0x4C); byte(0x89); byte(0xE7);                      // mov rdi, r12
+				byte(0xBE); u32(index);                                  // mov esi, index
+				byte(0xF2); byte(0x0F); byte(0x10); slotOperand(0, slot);                            // movsd xmm0, [slot]
+				byte(0xF2); byte(0x0F); byte(0x10); slotOperand(1, static_cast<uint8_t>(slot + 1));  // movsd xmm1, [slot + 1]
+				byte(0x48); byte(0xB8); u64(reinterpret_cast<uint64_t>(&updateIndicator)); // mov rax, updateIndicator
+				byte(0xFF); byte(0xD0);                                  // call rax
+				byte(0xF2); byte(0x0F); byte(0x11); slotOperand(0, slot);                            // movsd [slot], xmm0
+			}
+
+			void intToFloat(uint8_t target, uint8_t source) {
+				byte(0xF2); byte(0x48); byte(0x0F); byte(0x2A); slotOperand(0, source); // cvtsi2sd xmm0, qword [source]
+				byte(0xF2); byte(0x0F); byte(0x11); slotOperand(0, target);             // movsd [target], xmm0
+			}
+
+			// R[target] = R[left] < R[right]
+			void lessThanInt(uint8_t target, uint8_t left, uint8_t right) {
+				byte(0x48); byte(0x8B); slotOperand(0, left);            // mov rax, [left]
+				byte(0x48); byte(0x3B); slotOperand(0, right);           // cmp rax, [right]
+				byte(0x0F); byte(0x9C); byte(0xC0);                      // setl al
+				storeFlag(target);
+			}
+
+			void lessThanFloat(uint8_t target, uint8_t left, uint8_t right) {
+				// right > left rather than left < right so unordered (NaN) operands give false
+				byte(0xF2); byte(0x0F); byte(0x10); slotOperand(0, right); // movsd xmm0, [right]
+				byte(0x66); byte(0x0F); byte(0x2E); slotOperand(0, left);  // ucomisd xmm0, [left]
+				byte(0x0F); byte(0x97); byte(0xC0);                        // seta al
+				storeFlag(target);
+			}
+
+			void storeFlag(uint8_t target) {
+				byte(0x0F); byte(0xB6); byte(0xC0);                      // movzx eax, al
+				byte(0x48); byte(0x89); slotOperand(0, target);          // mov [target], rax
+			}
+
+			// Returns the offset of the rel32 to patch
+			size_t jumpIfFalse(uint8_t slot) {
+				byte(0x80); slotOperand(7, slot); byte(0x00);            // cmp byte [slot], 0
+				byte(0x0F); byte(0x84); u32(0);                          // je rel32
+				return code.size() - 4;
+			}
+
+			size_t jump() {
+				byte(0xE9); u32(0);                                      // jmp rel32
+				return code.size() - 4;
+			}
+
+			void emitSignal(uint8_t slot) {
+				byte(0x44); byte(0x8B); slotOperand(5, slot);            // mov r13d, [slot]
+			}
+
+			void patch(size_t offset, size_t target) {
+				uint32_t relative = static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(offset + 4));
+				for (int i = 0; i < 4; ++i)
+					code[offset + i] = static_cast<uint8_t>(relative >> (i * 8));
+			}
+		};
+
+	}
+#endif
+
+	JitCode::~JitCode()
+	{
+#if QUARTZ_JIT_X64
+		munmap(mMemory, mSize);
+#endif
+	}
+
+	bool JitCompiler::supported()
+	{
+		return QUARTZ_JIT_X64 != 0;
+	}
+
+	std::unique_ptr<JitCode> JitCompiler::compile(const CompiledStrategy& strategy, const CompiledFunction& function)
+	{
+#if QUARTZ_JIT_X64
+		const std::vector<Instruction>& instructions = function.code;
+		// Rounded up to 16 bytes so calls are made with an aligned stack
+		const uint32_t stackSize = std::max<uint32_t>(16, (function.registerCount * 8 + 15) / 16 * 16);
+
+		X64Emitter emitter;
+		emitter.prologue(stackSize);
+
+		// Jumps are resolved once their target has been emitted, the compiler only emits forward jumps
+		std::vector<std::vector<size_t>> fixups(instructions.size() + 1);
+		for (size_t pc = 0; pc < instructions.size(); ++pc) {
+			for (size_t fixup : fixups[pc])
+				emitter.patch(fixup, emitter.code.size());
+
+			const Instruction& instruction = instructions[pc];
+			auto branchTo = [&](size_t offset) -> bool {
+				int64_t target = static_cast<int64_t>(pc) + 1 + instruction.sbx();
+				if (target <= static_cast<int64_t>(pc) || target > static_cast<int64_t>(instructions.size()))
+					return false;
+				fixups[target].push_back(offset);
+				return true;
+			};
+
+			// Opcodes are typed so every instruction maps to a fixed native sequence
+			switch (instruction.op)
+			{
+			case OpCode::LOAD_CONST:
+				emitter.storeImmediate(instruction.a, static_cast<uint64_t>(strategy.constants[instruction.bx()].integer));
+				break;
+			case OpCode::LOAD_SLOT:
+				emitter.loadSlot(instruction.a, instruction.bx());
+				break;
+			case OpCode::LOAD_HISTORY:
+				emitter.loadHistory(instruction.a, strategy.historyReads[instruction.bx()]);
+				break;
+			case OpCode::STORE_SLOT:
+				emitter.storeSlot(instruction.bx(), instruction.a);
+				break;
+			case OpCode::MOVE:
+				emitter.move(instruction.a, instruction.b);
+				break;
+			case OpCode::INDICATOR:
+				emitter.callIndicator(instruction.a, instruction.bx());
+				break;
+			case OpCode::INT_TO_FLOAT:
+				emitter.intToFloat(instruction.a, instruction.b);
+				break;
+			case OpCode::LESS_INT:
+				emitter.lessThanInt(instruction.a, instruction.b, instruction.c);
+				break;
+			case OpCode::LESS_FLOAT:
+				emitter.lessThanFloat(instruction.a, instruction.b, instruction.c);
+				break;
+			case OpCode::GREATER_INT:
+				emitter.lessThanInt(instruction.a, instruction.c, instruction.b);
+				break;
+			case OpCode::GREATER_FLOAT:
+				emitter.lessThanFloat(instruction.a, instruction.c, instruction.b);
+				break;
+			case OpCode::JUMP:
+				if (!branchTo(emitter.jump()))
+					return nullptr;
+				break;
+			case OpCode::JUMP_IF_FALSE:
+				if (!branchTo(emitter.jumpIfFalse(instruction.a)))
+					return nullptr;
+				break;
+			case OpCode::EMIT_SIGNAL:
+				emitter.emitSignal(instruction.a);
+				break;
+			case OpCode::RETURN:
+				emitter.epilogue(stackSize);
+				break;
+			default:
+				// Builtin calls need the execution context, leave them to the interpreter
+				return nullptr;
+			}
+		}
+
+		for (size_t fixup : fixups[instructions.size()])
+			emitter.patch(fixup, emitter.code.size());
+		emitter.epilogue(stackSize);
+
+		const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t size = (emitter.code.size() + pageSize - 1) / pageSize * pageSize;
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED) {
+			Logger::getInstance().log(Logger::WARNING, "JIT failed to map memory, staying interpreted");
+			return nullptr;
+		}
+		std::memcpy(memory, emitter.code.data(), emitter.code.size());
+
+		// Never writable and executable at the same time
+		if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+			munmap(memory, size);
+			Logger::getInstance().log(Logger::WARNING, "JIT failed to make code executable, staying interpreted");
+			return nullptr;
+		}
+		return std::make_unique<JitCode>(memory, size);
+#else
+		(void)strategy;
+		(void)function;
+		return nullptr;
+#endif
+	}
+}
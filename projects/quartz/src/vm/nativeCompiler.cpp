@@ -0,0 +1,429 @@
+#include "vm/nativeCompiler.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "vm/compiler.hpp"
+#include "vm/history.hpp"
+#include "vm/nativeAbi.hpp"
+#include "vm/nativeAbiSource.hpp"
+#include "logging/logging.hpp"
+
+#define QUARTZ_STRINGIFY_IMPL(x) #x
+#define QUARTZ_STRINGIFY(x) QUARTZ_STRINGIFY_IMPL(x)
+
+namespace Quartz {
+	namespace {
+		std::string escapeString(std::string_view text)
+		{
+			std::string escaped = "\"";
+			for (unsigned char c : text) {
+				if (c == '"' || c == '\\') {
+					escaped += '\\';
+					escaped += static_cast<char>(c);
+				}
+				else if (c < 0x20 || c >= 0x7F) {
+					// Octal escapes always stop after three digits, unlike hex ones
+					char buffer[5];
+					std::snprintf(buffer, sizeof(buffer), "\\%03o", c);
+					escaped += buffer;
+				}
+				else {
+					escaped += static_cast<char>(c);
+				}
+			}
+			return escaped + "\"";
+		}
+
+		const char* cppType(ValueType type)
+		{
+			switch (type)
+			{
+			case ValueType::Integer: return "int64_t";
+			case ValueType::Float: return "double";
+			case ValueType::String: return "const char*";
+			case ValueType::Bool: return "bool";
+			case ValueType::Signal: return "int32_t";
+			default: return nullptr;
+			}
+		}
+
+		std::string shellQuote(const std::string& argument)
+		{
+			if (argument.find('\'') != std::string::npos)
+				Logger::getInstance().throwException(std::runtime_error("Paths containing quotes are not supported: " + argument));
+			return "'" + argument + "'";
+		}
+	}
+
+	std::string NativeCompiler::emitSource()
+	{
+		mOut.str("");
+		mOut << "// Generated by quartz, do not edit\n" << NATIVE_ABI_SOURCE << "\nnamespace {\n";
+		mIndent = 1;
+		line() << "constexpr int32_t QZ_BUY = " << static_cast<int>(BUY) << ";\n";
+		line() << "constexpr int32_t QZ_HOLD = " << static_cast<int>(HOLD) << ";\n";
+		line() << "constexpr int32_t QZ_SELL = " << static_cast<int>(SELL) << ";\n";
+
+		// Program level constants live in the outer namespace so strategy constants shadow them
+		std::vector<NodeIndex> strategies;
+		for (uint32_t i = 0; i < mAst.childCount[0]; ++i) {
+			NodeIndex node = mAst.child(0, i);
+			if (mAst.kinds[node] == NodeType::ConstDecl)
+				emitConstant(node);
+			else if (mAst.kinds[node] == NodeType::Strategy)
+				strategies.push_back(node);
+		}
+
+		for (uint32_t i = 0; i < strategies.size(); ++i)
+			emitStrategy(strategies[i], i);
+
+		mIndent = 1;
+		mOut << "\n";
+		line() << "const QuartzStrategyDescriptor strategies[] = {\n";
+		for (uint32_t i = 0; i < strategies.size(); ++i) {
+			line() << "    { " << escapeString(symbolName(mAst.name(strategies[i]))) << ", strategy" << i << "::inputCount, strategy" << i
+				<< "::inputNames, strategy" << i << "::indicatorCount, strategy" << i << "::indicatorSpecs, strategy" << i
+				<< "::historyCapacities, strategy" << i << "::init, strategy" << i << "::on_data },\n";
+		}
+		if (strategies.empty())
+			line() << "    { nullptr, 0, nullptr, 0, nullptr, nullptr, nullptr, nullptr },\n";
+		line() << "};\n";
+		mOut << "}\n\n";
+
+		mOut << "extern \"C\" __attribute__((visibility(\"default\"))) uint32_t quartz_abi_version() { return "
+			<< QUARTZ_STRINGIFY(QUARTZ_NATIVE_ABI_VERSION) << "; }\n";
+		mOut << "extern \"C\" __attribute__((visibility(\"default\"))) const QuartzStrategyDescriptor* quartz_strategies(uint32_t* count) {\n"
+			<< "    *count = " << strategies.size() << ";\n"
+			<< "    return strategies;\n"
+			<< "}\n";
+
+		return mOut.str();
+	}
+
+	void NativeCompiler::emitConstant(NodeIndex constNode)
+	{
+		const Value value = mAst.constValue(constNode);
+		const char* type = nullptr;
+		switch (value.type)
+		{
+		case ValueType::Integer: type = "int64_t"; break;
+		case ValueType::Float: type = "double"; break;
+		case ValueType::String: type = "const char*"; break;
+		default:
+			Logger::getInstance().throwException(std::runtime_error("Constant '" + std::string(symbolName(mAst.name(constNode))) + "' must be initialised with a literal"));
+		}
+		line() << "constexpr " << type << " c_" << symbolName(mAst.name(constNode)) << " = ";
+		emitLiteral(value);
+		mOut << ";\n";
+	}
+
+	void NativeCompiler::emitStrategy(NodeIndex strategyNode, uint32_t index)
+	{
+		// Run the bytecode compiler first, it rejects invalid programs and decides the input layout
+		const CompiledStrategy compiled = Compiler(mAst).compileStrategy(strategyNode);
+		mInputCount = static_cast<uint32_t>(compiled.inputs.size());
+
+		mOut << "\n";
+		line() << "// strategy " << symbolName(compiled.name) << "\n";
+		line() << "namespace strategy" << index << " {\n";
+		mIndent++;
+
+		line() << "constexpr uint32_t inputCount = " << compiled.inputs.size() << ";\n";
+		line() << "const char* const inputNames[] = { ";
+		for (Symbol input : compiled.inputs)
+			mOut << escapeString(symbolName(input)) << ", ";
+		mOut << (compiled.inputs.empty() ? "nullptr " : "") << "};\n";
+		// The runner owns the indicator state, on_data() updates it by call site
+		line() << "constexpr uint32_t indicatorCount = " << compiled.indicators.size() << ";\n";
+		line() << "const QuartzIndicatorSpec indicatorSpecs[] = { ";
+		for (const IndicatorSpec& spec : compiled.indicators)
+			mOut << "{ " << static_cast<uint32_t>(spec.kind) << ", " << spec.window << " }, ";
+		mOut << (compiled.indicators.empty() ? "{ 0, 0 } " : "") << "};\n";
+		// History rings are sized by the same analysis as the bytecode's, reads address them directly
+		mHistoryCapacities = compiled.historyCapacities;
+		mHistoryOffsets = historyOffsets(compiled.historyCapacities);
+		line() << "const uint32_t historyCapacities[] = { ";
+		for (uint32_t capacity : compiled.historyCapacities)
+			mOut << capacity << ", ";
+		mOut << (compiled.historyCapacities.empty() ? "0 " : "") << "};\n";
+
+		NodeIndex initNode = INVALID_NODE;
+		NodeIndex onDataNode = INVALID_NODE;
+		for (uint32_t i = 0; i < mAst.childCount[strategyNode]; ++i) {
+			NodeIndex node = mAst.child(strategyNode, i);
+			switch (mAst.kinds[node])
+			{
+			case NodeType::ConstDecl: emitConstant(node); break;
+			case NodeType::StrategyInitFunction: initNode = node; break;
+			case NodeType::StrategyOnDataFunction: onDataNode = node; break;
+			default: break;
+			}
+		}
+
+		mOut << "\n";
+		line() << "void init(const QuartzHost* host) {\n";
+		mIndent++;
+		line() << "(void)host;\n";
+		if (initNode != INVALID_NODE)
+			emitFunction(initNode, false);
+		mIndent--;
+		line() << "}\n\n";
+
+		line() << "int32_t on_data(const double* inputs, const QuartzIndicators* indicators, const QuartzHistory* history) {\n";
+		mIndent++;
+		line() << "(void)inputs;\n";
+		line() << "(void)indicators;\n";
+		line() << "(void)history;\n";
+		line() << "int32_t signal = QZ_HOLD;\n";
+		if (onDataNode != INVALID_NODE)
+			emitFunction(onDataNode, true);
+		line() << "return signal;\n";
+		mIndent--;
+		line() << "}\n";
+
+		mIndent--;
+		line() << "}\n";
+	}
+
+	void NativeCompiler::emitFunction(NodeIndex functionNode, bool onData)
+	{
+		mInOnData = onData;
+		// Functions always have their body block as the only child
+		NodeIndex block = mAst.child(functionNode, 0);
+		for (uint32_t i = 0; i < mAst.childCount[block]; ++i)
+			emitStatement(mAst.child(block, i));
+	}
+
+	void NativeCompiler::emitStatement(NodeIndex node)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::ExprStmt:
+		{
+			NodeIndex expression = mAst.child(node, 0);
+			// Input declarations only affect the layout, they produce no code
+			if (mAst.kinds[expression] == NodeType::CallExpr && mAst.name(expression) == mDefineInputsSymbol)
+				break;
+			line();
+			emitExpression(expression);
+			mOut << ";\n";
+			break;
+		}
+		case NodeType::VarDecl:
+			line() << cppType(mAst.type(node)) << " v_" << symbolName(mAst.name(node)) << " = ";
+			emitConvertedExpression(mAst.child(node, 0), mAst.type(node));
+			mOut << ";\n";
+			break;
+		case NodeType::AssignStmt:
+			line() << "v_" << symbolName(mAst.name(node)) << " = ";
+			emitConvertedExpression(mAst.child(node, 0), mAst.type(node));
+			mOut << ";\n";
+			break;
+		case NodeType::IfStmt:
+			line() << "if (";
+			emitExpression(mAst.child(node, 0));
+			mOut << ") {\n";
+			mIndent++;
+			emitBranch(mAst.child(node, 1));
+			mIndent--;
+			if (mAst.childCount[node] > 2) {
+				line() << "} else {\n";
+				mIndent++;
+				emitBranch(mAst.child(node, 2));
+				mIndent--;
+			}
+			line() << "}\n";
+			break;
+		case NodeType::ReturnStmt:
+			line() << (mInOnData ? "return signal;\n" : "return;\n");
+			break;
+		case NodeType::Block:
+			// Braced so locals of sibling blocks can share a name
+			line() << "{\n";
+			mIndent++;
+			for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+				emitStatement(mAst.child(node, i));
+			mIndent--;
+			line() << "}\n";
+			break;
+		default:
+			Logger::getInstance().throwException(std::runtime_error("Unsupported statement in compiled mode"));
+		}
+	}
+
+	void NativeCompiler::emitBranch(NodeIndex node)
+	{
+		// The if statement already braces its branches
+		if (mAst.kinds[node] != NodeType::Block) {
+			emitStatement(node);
+			return;
+		}
+		for (uint32_t i = 0; i < mAst.childCount[node]; ++i)
+			emitStatement(mAst.child(node, i));
+	}
+
+	void NativeCompiler::emitExpression(NodeIndex node)
+	{
+		switch (mAst.kinds[node])
+		{
+		case NodeType::LiteralExpr:
+			emitLiteral(mAst.value(node));
+			break;
+		case NodeType::Signal:
+			mOut << "QZ_" << signalToString(mAst.signal(node));
+			break;
+		case NodeType::IdentifierExpr:
+		{
+			// Consts have been folded, identifiers name an input or a local
+			const uint32_t slot = mAst.payloads[node];
+			if (slot < mInputCount)
+				mOut << "inputs[" << slot << "]";
+			else
+				mOut << "v_" << symbolName(mAst.name(node));
+			break;
+		}
+		case NodeType::IndexExpr:
+		{
+			// The lookback is a constant, the mask wraps it into the input's ring
+			const uint32_t input = mAst.payloads[node];
+			const int64_t lookback = mAst.value(mAst.child(node, 0)).integer;
+			if (lookback == 0)
+				mOut << "inputs[" << input << "]";
+			else
+				mOut << "history->values[" << mHistoryOffsets[input] << "u + ((history->bar - " << lookback << "u) & "
+					<< mHistoryCapacities[input] - 1 << "u)]";
+			break;
+		}
+		case NodeType::BinaryExpr:
+			mOut << "(";
+			emitExpression(mAst.child(node, 0));
+			mOut << (mAst.tokenType(node) == LESS_THAN ? " < " : " > ");
+			emitExpression(mAst.child(node, 1));
+			mOut << ")";
+			break;
+		case NodeType::CallExpr:
+			emitCall(node);
+			break;
+		default:
+			Logger::getInstance().throwException(std::runtime_error("Unsupported expression in compiled mode"));
+		}
+	}
+
+	void NativeCompiler::emitConvertedExpression(NodeIndex node, ValueType type)
+	{
+		// Ints assigned to float variables are widened explicitly, like INT_TO_FLOAT in bytecode
+		if (mAst.type(node) == ValueType::Integer && type == ValueType::Float) {
+			mOut << "static_cast<double>(";
+			emitExpression(node);
+			mOut << ")";
+			return;
+		}
+		emitExpression(node);
+	}
+
+	void NativeCompiler::emitCall(NodeIndex node)
+	{
+		const Symbol callee = mAst.name(node);
+		if (callee == mEmitSignalSymbol) {
+			mOut << "signal = ";
+			emitExpression(mAst.child(node, 0));
+		}
+		else if (callee == mAddDataSourceSymbol) {
+			mOut << "host->addDataSource(host->context, ";
+			emitExpression(mAst.child(node, 0));
+			mOut << ", ";
+			if (mAst.childCount[node] > 1)
+				emitExpression(mAst.child(node, 1));
+			else
+				mOut << "\"\"";
+			mOut << ")";
+		}
+		else if (const IndicatorInfo* indicator = findIndicator(callee)) {
+			// Same state and arithmetic as the interpreter, the Resolver numbered the call site
+			mOut << "indicators->update(indicators->state, " << mAst.payloads[node] << "u, ";
+			emitConvertedExpression(mAst.child(node, 0), ValueType::Float);
+			mOut << ", ";
+			if (indicator->seriesArguments > 1)
+				emitConvertedExpression(mAst.child(node, 1), ValueType::Float);
+			else
+				mOut << "0.0";
+			mOut << ")";
+		}
+		else {
+			Logger::getInstance().throwException(std::runtime_error("Function '" + std::string(symbolName(callee)) + "' is not available in compiled mode"));
+		}
+	}
+
+	void NativeCompiler::emitLiteral(const Value& value)
+	{
+		switch (value.type)
+		{
+		case ValueType::Integer:
+			// INT64_MIN has no literal form
+			if (value.integer == INT64_MIN)
+				mOut << "(-INT64_C(9223372036854775807) - 1)";
+			else
+				mOut << "INT64_C(" << value.integer << ")";
+			break;
+		case ValueType::Float:
+		{
+			// Hex floats round trip exactly
+			char buffer[64];
+			std::snprintf(buffer, sizeof(buffer), "%a", value.floating);
+			mOut << buffer;
+			break;
+		}
+		case ValueType::String:
+			mOut << escapeString(value.string);
+			break;
+		case ValueType::Bool:
+			mOut << (value.boolean ? "true" : "false");
+			break;
+		default:
+			mOut << "0";
+			break;
+		}
+	}
+
+	std::ostream& NativeCompiler::line()
+	{
+		for (int i = 0; i < mIndent; ++i)
+			mOut << "    ";
+		return mOut;
+	}
+
+	void NativeCompiler::buildSharedObject(const std::string& source, const std::string& outputPath)
+	{
+#if defined(_WIN32)
+		Logger::getInstance().throwException(std::runtime_error("Compiled mode is not supported on Windows yet"));
+#else
+		const std::string sourcePath = outputPath + ".cpp";
+		{
+			std::ofstream file(sourcePath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file)
+				Logger::getInstance().throwException(std::runtime_error("Failed to write generated source: " + sourcePath));
+			file << source;
+		}
+
+		const char* compiler = std::getenv("QUARTZ_CXX");
+		if (!compiler || !*compiler)
+			compiler = std::getenv("CXX");
+		if (!compiler || !*compiler)
+			compiler = "c++";
+
+		const std::string command = std::string(compiler) + " -std=c++17 -O3 -shared -fPIC -fvisibility=hidden -o "
+			+ shellQuote(outputPath) + " " + shellQuote(sourcePath);
+		Logger::getInstance().logf(Logger::INFO, "Building %s: %s", outputPath.c_str(), command.c_str());
+
+		int status = std::system(command.c_str());
+
+		// Keep the generated source around when debugging
+		if (Logger::getInstance().getPrintLevel() > Logger::DEBUG)
+			std::remove(sourcePath.c_str());
+
+		if (status != 0)
+			Logger::getInstance().throwException(std::runtime_error("System compiler failed to build " + outputPath));
+#endif
+	}
+}
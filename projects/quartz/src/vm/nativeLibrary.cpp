@@ -0,0 +1,89 @@
+#include "vm/nativeLibrary.hpp"
+
+#include "logging/logging.hpp"
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+namespace Quartz {
+	namespace {
+		void addDataSource(void* context, const char* ticker, const char* interval)
+		{
+			ExecutionContext& executionContext = *static_cast<ExecutionContext*>(context);
+			executionContext.dataSources.push_back(DataSource{ ticker, interval });
+		}
+
+		std::vector<IndicatorSpec> indicatorSpecs(const QuartzStrategyDescriptor& strategy)
+		{
+			std::vector<IndicatorSpec> specs;
+			for (uint32_t i = 0; i < strategy.indicatorCount; ++i) {
+				const QuartzIndicatorSpec& spec = strategy.indicators[i];
+				specs.push_back(IndicatorSpec{ static_cast<IndicatorKind>(spec.kind), spec.window });
+			}
+			return specs;
+		}
+
+		std::vector<uint32_t> historyCapacities(const QuartzStrategyDescriptor& strategy)
+		{
+			return std::vector<uint32_t>(strategy.historyCapacities, strategy.historyCapacities + strategy.inputCount);
+		}
+	}
+
+	std::shared_ptr<NativeLibrary> NativeLibrary::open(const std::string& path)
+	{
+#if defined(_WIN32)
+		Logger::getInstance().throwException(std::runtime_error("Compiled mode is not supported on Windows yet"));
+#else
+		std::shared_ptr<NativeLibrary> library(new NativeLibrary());
+
+		// dlopen only searches the library path for bare file names
+		const std::string resolvedPath = path.find('/') == std::string::npos ? "./" + path : path;
+		library->mHandle = dlopen(resolvedPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (!library->mHandle)
+			Logger::getInstance().throwException(std::runtime_error("Failed to load " + path + ": " + dlerror()));
+
+		auto abiVersion = reinterpret_cast<QuartzAbiVersionFunction>(dlsym(library->mHandle, "quartz_abi_version"));
+		auto strategies = reinterpret_cast<QuartzStrategiesFunction>(dlsym(library->mHandle, "quartz_strategies"));
+		if (!abiVersion || !strategies)
+			Logger::getInstance().throwException(std::runtime_error(path + " is not a compiled quartz strategy library"));
+
+		if (abiVersion() != QUARTZ_NATIVE_ABI_VERSION)
+			Logger::getInstance().throwException(std::runtime_error(path + " was compiled for a different quartz version, recompile it"));
+
+		library->mStrategies = strategies(&library->mStrategyCount);
+		return library;
+#endif
+	}
+
+	NativeLibrary::~NativeLibrary()
+	{
+#if !defined(_WIN32)
+		if (mHandle)
+			dlclose(mHandle);
+#endif
+	}
+
+	IndicatorSet NativeLibrary::createIndicators(const QuartzStrategyDescriptor& strategy)
+	{
+		return IndicatorSet(indicatorSpecs(strategy));
+	}
+
+	InputHistory NativeLibrary::createHistory(const QuartzStrategyDescriptor& strategy)
+	{
+		return InputHistory(historyCapacities(strategy));
+	}
+
+	StateLayout NativeLibrary::stateLayout(const QuartzStrategyDescriptor& strategy)
+	{
+		return StateLayout(0, indicatorSpecs(strategy), historyCapacities(strategy));
+	}
+
+	void NativeLibrary::init(const QuartzStrategyDescriptor& strategy, ExecutionContext& context)
+	{
+		QuartzHost host;
+		host.context = &context;
+		host.addDataSource = addDataSource;
+		strategy.init(&host);
+	}
+}
@@ -0,0 +1,55 @@
+#include "vm/stateBlock.hpp"
+
+#include <algorithm>
+
+namespace Quartz {
+	size_t StateLayout::instanceBytes() const
+	{
+		return mFrameSize * sizeof(RawValue)
+			+ mIndicators.size() * sizeof(IndicatorCursor)
+			+ mIndicators.valueCount() * sizeof(double)
+			+ mIndicators.barCount() * sizeof(uint64_t)
+			+ mHistory.valueCount() * sizeof(double)
+			+ sizeof(uint64_t);
+	}
+
+	StateBlock::StateBlock(std::shared_ptr<const StateLayout> layout, size_t count, const RawValue* initialFrame)
+		: mLayout(std::move(layout)), mCount(count)
+	{
+		const uint32_t frameSize = mLayout->frameSize();
+		mFrames.resize(count * frameSize);
+		if (initialFrame) {
+			for (size_t i = 0; i < count; ++i)
+				std::copy(initialFrame, initialFrame + frameSize, mFrames.begin() + i * frameSize);
+		}
+		mCursors.resize(count * mLayout->indicators().size());
+		mIndicatorValues.resize(count * mLayout->indicators().valueCount());
+		mIndicatorBars.resize(count * mLayout->indicators().barCount());
+		mHistoryValues.resize(count * mLayout->history().valueCount());
+		// Wraps to 0 on the first push
+		mHistoryBars.assign(count, UINT64_MAX);
+	}
+
+	StrategyState StateBlock::instance(size_t index)
+	{
+		const IndicatorLayout& indicators = mLayout->indicators();
+		const HistoryLayout& history = mLayout->history();
+
+		StrategyState state;
+		state.frame = mFrames.data() + index * mLayout->frameSize();
+		state.indicators = IndicatorSet(indicators, mCursors.data() + index * indicators.size(),
+			mIndicatorValues.data() + index * indicators.valueCount(), mIndicatorBars.data() + index * indicators.barCount());
+		state.history = InputHistory(history, mHistoryValues.data() + index * history.valueCount(), mHistoryBars.data() + index);
+		return state;
+	}
+
+	size_t StateBlock::bytes() const
+	{
+		return mFrames.capacity() * sizeof(RawValue)
+			+ mCursors.capacity() * sizeof(IndicatorCursor)
+			+ mIndicatorValues.capacity() * sizeof(double)
+			+ mIndicatorBars.capacity() * sizeof(uint64_t)
+			+ mHistoryValues.capacity() * sizeof(double)
+			+ mHistoryBars.capacity() * sizeof(uint64_t);
+	}
+}
@@ -0,0 +1,125 @@
+#include "vm/virtualMachine.hpp"
+
+#include "logging/logging.hpp"
+
+// Computed goto dispatches each instruction with its own indirect branch, which predicts far
+// better than the single shared branch of a switch. MSVC doesn't support it so falls back to the switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define QUARTZ_COMPUTED_GOTO 1
+#else
+#define QUARTZ_COMPUTED_GOTO 0
+#endif
+
+namespace Quartz {
+	Signal VirtualMachine::execute(const CompiledStrategy& strategy, const CompiledFunction& function, ExecutionContext& context)
+	{
+		if (mRegisters.size() < function.registerCount)
+			mRegisters.resize(function.registerCount);
+
+		RawValue* registers = mRegisters.data();
+		const RawValue* constants = strategy.constants.data();
+		RawValue* frame = context.frame;
+		IndicatorSet* indicators = context.indicators;
+		const HistoryRead* historyReads = strategy.historyReads.data();
+		const double* history = context.history ? context.history->values() : nullptr;
+		const uint64_t bar = context.history ? context.history->bar() : 0;
+		const Instruction* pc = function.code.data();
+		const BuiltinFunction* builtins = BuiltinRegistry::getInstance().functions().data();
+		Signal signal = HOLD;
+
+#if QUARTZ_COMPUTED_GOTO
+		static const void* dispatchTable[] = {
+			&&op_LOAD_CONST,
+			&&op_LOAD_SLOT,
+			&&op_LOAD_HISTORY,
+			&&op_STORE_SLOT,
+			&&op_MOVE,
+			&&op_INT_TO_FLOAT,
+			&&op_LESS_INT,
+			&&op_LESS_FLOAT,
+			&&op_GREATER_INT,
+			&&op_GREATER_FLOAT,
+			&&op_JUMP,
+			&&op_JUMP_IF_FALSE,
+			&&op_CALL,
+			&&op_INDICATOR,
+			&&op_EMIT_SIGNAL,
+			&&op_RETURN,
+		};
+		static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == static_cast<size_t>(OpCode::COUNT),
+			"Every opcode needs a dispatch table entry");
+
+#define DISPATCH() goto *dispatchTable[static_cast<uint8_t>(pc->op)]
+#define CASE(op) op_##op:
+#define NEXT() ++pc; DISPATCH()
+		DISPATCH();
+#else
+#define CASE(op) case OpCode::op:
+#define NEXT() ++pc; continue
+		for (;;) {
+			switch (pc->op) {
+#endif
+		CASE(LOAD_CONST)
+			registers[pc->a] = constants[pc->bx()];
+			NEXT();
+		CASE(LOAD_SLOT)
+			registers[pc->a] = frame[pc->bx()];
+			NEXT();
+		CASE(LOAD_HISTORY)
+		{
+			// Masked into the ring, so the read can't go out of bounds
+			const HistoryRead& read = historyReads[pc->bx()];
+			registers[pc->a].floating = history[read.offset + ((bar - read.lookback) & read.mask)];
+			NEXT();
+		}
+		CASE(STORE_SLOT)
+			frame[pc->bx()] = registers[pc->a];
+			NEXT();
+		CASE(MOVE)
+			registers[pc->a] = registers[pc->b];
+			NEXT();
+		CASE(INT_TO_FLOAT)
+			registers[pc->a].floating = static_cast<double>(registers[pc->b].integer);
+			NEXT();
+		CASE(LESS_INT)
+			registers[pc->a].boolean = registers[pc->b].integer < registers[pc->c].integer;
+			NEXT();
+		CASE(LESS_FLOAT)
+			registers[pc->a].boolean = registers[pc->b].floating < registers[pc->c].floating;
+			NEXT();
+		CASE(GREATER_INT)
+			registers[pc->a].boolean = registers[pc->b].integer > registers[pc->c].integer;
+			NEXT();
+		CASE(GREATER_FLOAT)
+			registers[pc->a].boolean = registers[pc->b].floating > registers[pc->c].floating;
+			NEXT();
+		CASE(JUMP)
+			pc += pc->sbx();
+			NEXT();
+		CASE(JUMP_IF_FALSE)
+			if (!registers[pc->a].boolean)
+				pc += pc->sbx();
+			NEXT();
+		CASE(CALL)
+			registers[pc->a] = builtins[pc->b].function(context, &registers[pc->a], pc->c);
+			NEXT();
+		CASE(INDICATOR)
+			registers[pc->a].floating = indicators->update(pc->bx(), registers[pc->a].floating, registers[pc->a + 1].floating);
+			NEXT();
+		CASE(EMIT_SIGNAL)
+			signal = registers[pc->a].signal;
+			NEXT();
+		CASE(RETURN)
+			return signal;
+#if !QUARTZ_COMPUTED_GOTO
+			default:
+				Logger::getInstance().throwException(std::runtime_error("Invalid opcode"));
+			}
+		}
+#endif
+
+#undef CASE
+#undef NEXT
+#undef DISPATCH
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace QuartzBenchmark {
+	// Prevents the optimizer from discarding a value computed inside a timed loop
+	template <typename T>
+	inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const T* sink;
+		sink = &value;
+#endif
+	}
+
+	class Timer {
+	public:
+		Timer() : mStart(std::chrono::steady_clock::now()) {}
+
+		double elapsedSeconds() const {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point mStart;
+	};
+
+	inline void report(const std::string& name, double seconds, size_t operations, const char* unit) {
+		std::printf("%-40s %10.2f ns/%s\n", name.c_str(), seconds * 1e9 / static_cast<double>(operations), unit);
+	}
+
+	inline void reportThroughput(const std::string& name, double seconds, size_t bytes) {
+		std::printf("%-40s %10.2f MB/s\n", name.c_str(), static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds);
+	}
+
+	// Correctness checks that failed, main returns nonzero when any did
+	inline size_t failedChecks = 0;
+
+	// Prints message and records a failure unless passed
+	inline bool check(bool passed, const std::string& message) {
+		if (!passed) {
+			std::printf("FAILED: %s\n", message.c_str());
+			failedChecks++;
+		}
+		return passed;
+	}
+
+	void runCsvBenchmark();
+	void runIndicatorBenchmark();
+	void runKeywordBenchmark();
+	void runLiveBenchmark();
+	void runShardBenchmark();
+	void runVirtualMachineBenchmark();
+}
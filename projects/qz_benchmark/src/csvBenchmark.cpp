@@ -0,0 +1,83 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <quartz/utils/fileUtils.hpp>
+
+namespace QuartzBenchmark {
+	namespace {
+		constexpr size_t ROWS = 1'000'000;
+		constexpr int REPEATS = 3;
+
+		// Minute bars shaped like a vendor export
+		std::string buildCsv() {
+			std::mt19937_64 rng(7);
+			std::normal_distribution<double> step(0.0, 0.1);
+			std::uniform_int_distribution<int> volume(100, 100000);
+
+			std::ostringstream csv;
+			csv << "timestamp,open,high,low,close,volume\n";
+			csv.setf(std::ios::fixed);
+			csv.precision(2);
+			double price = 100.0;
+			for (size_t i = 0; i < ROWS; ++i) {
+				double open = price;
+				price += step(rng) - 0.001 * (price - 100.0);
+				csv << 1700000000 + 60 * static_cast<int64_t>(i) << ',' << open << ',' << std::max(open, price) + 0.01 << ','
+					<< std::min(open, price) - 0.01 << ',' << price << ',' << volume(rng) << '\n';
+			}
+			return csv.str();
+		}
+
+		// What a straightforward importer does: getline and a stream per row
+		size_t baselineParse(const std::string& path) {
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			std::vector<double> close;
+			while (std::getline(file, line)) {
+				std::istringstream row(line);
+				std::string field;
+				for (int column = 0; std::getline(row, field, ','); ++column) {
+					if (column == 4)
+						close.push_back(std::stod(field));
+				}
+			}
+			return close.size();
+		}
+
+		template <typename Parse>
+		double bestOf(Parse parse) {
+			double best = 1e30;
+			for (int i = 0; i < REPEATS; ++i) {
+				Timer timer;
+				doNotOptimize(parse());
+				best = std::min(best, timer.elapsedSeconds());
+			}
+			return best;
+		}
+	}
+
+	void runCsvBenchmark() {
+		const std::string path = (std::filesystem::temp_directory_path() / "qz_benchmark_bars.csv").string();
+		{
+			std::ofstream file(path, std::ios::binary);
+			file << buildCsv();
+		}
+		const size_t bytes = static_cast<size_t>(std::filesystem::file_size(path));
+		const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+		reportThroughput("csv getline + stod (close only)", bestOf([&] { return baselineParse(path); }), bytes);
+		reportThroughput("loadCsvBars 1 thread", bestOf([&] { return Quartz::loadCsvBars(path.c_str(), 1).timestamps.size(); }), bytes);
+		reportThroughput("loadCsvBars " + std::to_string(threads) + " threads",
+			bestOf([&] { return Quartz::loadCsvBars(path.c_str(), threads).timestamps.size(); }), bytes);
+
+		std::filesystem::remove(path);
+	}
+}
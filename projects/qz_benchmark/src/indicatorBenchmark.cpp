@@ -0,0 +1,180 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <quartz/quartz.hpp>
+#include <quartz/parser/flatAST.hpp>
+#include <quartz/vm/compiler.hpp>
+#include <quartz/vm/indicatorGraph.hpp>
+#include <quartz/vm/virtualMachine.hpp>
+
+namespace QuartzBenchmark {
+	namespace {
+		constexpr size_t BAR_COUNT = 1 << 20;
+		constexpr uint32_t WINDOW = 50;
+		// Worst relative difference from recomputing the window from scratch that still passes
+		constexpr double TOLERANCE = 1e-9;
+		constexpr size_t STRATEGY_COUNT = 32;
+		constexpr size_t SHARED_BAR_COUNT = 1 << 16;
+
+		// Recomputes the indicator over the window ending at bar, the way a non streaming
+		// implementation would every bar
+		double naive(Quartz::IndicatorKind kind, const std::vector<double>& prices, const std::vector<double>& volumes, size_t bar, double& ema) {
+			const size_t first = bar + 1 >= WINDOW ? bar + 1 - WINDOW : 0;
+			const double count = static_cast<double>(bar + 1 - first);
+			switch (kind)
+			{
+			case Quartz::IndicatorKind::Sma:
+			{
+				double sum = 0.0;
+				for (size_t i = first; i <= bar; ++i)
+					sum += prices[i];
+				return sum / count;
+			}
+			case Quartz::IndicatorKind::Ema:
+				ema = bar == 0 ? prices[0] : ema + 2.0 / (WINDOW + 1.0) * (prices[bar] - ema);
+				return ema;
+			case Quartz::IndicatorKind::RollingStd:
+			{
+				double sum = 0.0;
+				for (size_t i = first; i <= bar; ++i)
+					sum += prices[i];
+				const double mean = sum / count;
+				double squares = 0.0;
+				for (size_t i = first; i <= bar; ++i)
+					squares += (prices[i] - mean) * (prices[i] - mean);
+				return std::sqrt(squares / count);
+			}
+			case Quartz::IndicatorKind::RollingMin:
+				return *std::min_element(prices.begin() + first, prices.begin() + bar + 1);
+			case Quartz::IndicatorKind::RollingMax:
+				return *std::max_element(prices.begin() + first, prices.begin() + bar + 1);
+			case Quartz::IndicatorKind::Vwap:
+			{
+				double weighted = 0.0;
+				double volume = 0.0;
+				for (size_t i = first; i <= bar; ++i) {
+					weighted += prices[i] * volumes[i];
+					volume += volumes[i];
+				}
+				return weighted / volume;
+			}
+			default:
+				return 0.0;
+			}
+		}
+
+		// Every strategy computes the same three indicators, as strategies sweeping a parameter of
+		// otherwise identical logic would
+		void runSharedIndicatorBenchmark(const std::vector<double>& prices) {
+			std::string source;
+			for (size_t i = 0; i < STRATEGY_COUNT; ++i) {
+				source += "strategy S" + std::to_string(i) + " {"
+					"    init() -> void { define_input_variables(price); }"
+					"    on_data() -> void {"
+					"        var fast = ema(price, 12);"
+					"        var slow = sma(price, 50);"
+					"        var band = rolling_std(price, 50);"
+					"        if (fast > slow) { if (band < " + std::to_string(i % 4 + 1) + ".0) { emit_signal(BUY); } }"
+					"    }"
+					"}";
+			}
+			std::shared_ptr<const Quartz::FlatAST> ast = Quartz::analyse_program(Quartz::run_code(source.c_str()));
+			std::vector<Quartz::CompiledStrategy> strategies;
+			for (uint32_t i = 0; i < ast->childCount[0]; ++i)
+				strategies.push_back(Quartz::Compiler(*ast).compileStrategy(ast->child(0, i)));
+
+			auto replay = [&](bool shared, size_t& buys) {
+				std::vector<Quartz::IndicatorSet> indicators;
+				std::vector<std::vector<Quartz::RawValue>> frames;
+				for (const Quartz::CompiledStrategy& strategy : strategies) {
+					indicators.emplace_back(strategy.indicators);
+					frames.emplace_back(strategy.frameSize);
+				}
+				// price is the only input, column 0
+				Quartz::IndicatorGraph graph;
+				if (shared) {
+					for (size_t i = 0; i < strategies.size(); ++i)
+						graph.addStrategy(strategies[i], { 0 }, indicators[i]);
+				}
+				graph.link();
+
+				Quartz::VirtualMachine vm;
+				Quartz::ExecutionContext context;
+				buys = 0;
+				Timer timer;
+				for (size_t bar = 0; bar < SHARED_BAR_COUNT; ++bar) {
+					graph.update(&prices[bar]);
+					for (size_t i = 0; i < strategies.size(); ++i) {
+						frames[i][0].floating = prices[bar];
+						context.frame = frames[i].data();
+						context.indicators = &indicators[i];
+						buys += vm.execute(strategies[i], strategies[i].onData, context) == Quartz::BUY;
+					}
+				}
+				return timer.elapsedSeconds();
+			};
+
+			size_t privateBuys = 0;
+			size_t sharedBuys = 0;
+			const double privateSeconds = replay(false, privateBuys);
+			const double sharedSeconds = replay(true, sharedBuys);
+			doNotOptimize(privateBuys);
+
+			const std::string name = std::to_string(STRATEGY_COUNT) + " strategies";
+			report(name + ", own indicators", privateSeconds, SHARED_BAR_COUNT, "bar");
+			report(name + ", shared indicators", sharedSeconds, SHARED_BAR_COUNT, "bar");
+			check(privateBuys == sharedBuys, "shared indicators changed the signals");
+		}
+	}
+
+	void runIndicatorBenchmark() {
+		// A random walk with enough noise that the running sums see cancellation
+		std::vector<double> prices(BAR_COUNT);
+		std::vector<double> volumes(BAR_COUNT);
+		std::mt19937_64 rng(7);
+		std::normal_distribution<double> step(0.0, 1.0);
+		std::uniform_real_distribution<double> volume(1'000.0, 100'000.0);
+		double price = 100.0;
+		for (size_t i = 0; i < BAR_COUNT; ++i) {
+			price = std::max(1.0, price + step(rng));
+			prices[i] = price;
+			volumes[i] = volume(rng);
+		}
+
+		for (uint32_t kind = 0; kind < static_cast<uint32_t>(Quartz::IndicatorKind::COUNT); ++kind) {
+			const Quartz::IndicatorKind indicator = static_cast<Quartz::IndicatorKind>(kind);
+			const std::string name = Quartz::indicatorInfo(indicator).name;
+
+			Quartz::IndicatorSet set({ Quartz::IndicatorSpec{ indicator, WINDOW } });
+			std::vector<double> streamed(BAR_COUNT);
+			Timer timer;
+			for (size_t i = 0; i < BAR_COUNT; ++i)
+				streamed[i] = set.update(0, prices[i], volumes[i]);
+			double seconds = timer.elapsedSeconds();
+			doNotOptimize(streamed);
+
+			std::vector<double> recomputed(BAR_COUNT);
+			double ema = 0.0;
+			Timer naiveTimer;
+			for (size_t i = 0; i < BAR_COUNT; ++i)
+				recomputed[i] = naive(indicator, prices, volumes, i, ema);
+			double naiveSeconds = naiveTimer.elapsedSeconds();
+			doNotOptimize(recomputed);
+
+			double worst = 0.0;
+			for (size_t i = 0; i < BAR_COUNT; ++i)
+				worst = std::max(worst, std::fabs(streamed[i] - recomputed[i]) / std::max(1.0, std::fabs(recomputed[i])));
+
+			report(name + "(" + std::to_string(WINDOW) + ")", seconds, BAR_COUNT, "tick");
+			report(name + " naive", naiveSeconds, BAR_COUNT, "tick");
+			std::printf("%-40s %10.3g\n", (name + " max relative error").c_str(), worst);
+			check(worst <= TOLERANCE, name + " is off from the naive recomputation");
+		}
+
+		runSharedIndicatorBenchmark(prices);
+	}
+}
@@ -0,0 +1,92 @@
+#include "benchmark.hpp"
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <quartz/tokenizer/keywords.hpp>
+#include <quartz/tokenizer/tokenizer.hpp>
+
+namespace QuartzBenchmark {
+	namespace {
+		// The std::unordered_map lookup the tokenizer used before the perfect hash
+		const std::unordered_map<std::string, Quartz::TokenType> baselineKeywordMap = {
+			{"strategy", Quartz::KEYWORD_STRATEGY},
+			{"const", Quartz::KEYWORD_CONST},
+			{"if", Quartz::KEYWORD_IF},
+			{"else", Quartz::KEYWORD_ELSE},
+			{"return", Quartz::KEYWORD_RETURN},
+			{"string", Quartz::KEYWORD_STRING},
+			{"float", Quartz::KEYWORD_FLOAT},
+			{"int", Quartz::KEYWORD_INT},
+			{"void", Quartz::KEYWORD_VOID},
+			{"null", Quartz::KEYWORD_NULL},
+			{"SELL", Quartz::KEYWORD_SELL},
+			{"BUY", Quartz::KEYWORD_BUY},
+			{"HOLD", Quartz::KEYWORD_HOLD},
+		};
+
+		// Identifier heavy: roughly one keyword for every four identifiers, like a typical strategy body
+		std::string buildIdentifierCorpus(size_t words) {
+			const char* identifiers[] = {
+				"price", "short_ma", "long_ma", "data_source", "interval", "emit_signal",
+				"add_data_source", "define_input_variables", "short_window", "long_window",
+				"on_data", "init", "volume", "x", "MovingAverageCrossover", "rolling_std_20",
+			};
+			const char* keywords[] = { "if", "else", "return", "const", "BUY", "SELL", "HOLD", "int", "string" };
+
+			std::mt19937 rng(1234);
+			std::string corpus;
+			for (size_t i = 0; i < words; ++i) {
+				if (rng() % 5 == 0)
+					corpus += keywords[rng() % (sizeof(keywords) / sizeof(keywords[0]))];
+				else
+					corpus += identifiers[rng() % (sizeof(identifiers) / sizeof(identifiers[0]))];
+				corpus += ' ';
+			}
+			return corpus;
+		}
+	}
+
+	void runKeywordBenchmark() {
+		const size_t words = 1000000;
+		const int rounds = 10;
+		std::string corpus = buildIdentifierCorpus(words);
+
+		std::vector<Quartz::Token> tokens = Quartz::Tokenizer(corpus.c_str()).tokenize();
+		tokens.pop_back(); // END
+
+		{
+			Timer timer;
+			size_t keywordCount = 0;
+			for (int round = 0; round < rounds; ++round) {
+				for (const Quartz::Token& token : tokens) {
+					auto position = baselineKeywordMap.find(std::string(corpus.data() + token.Offset, token.Length));
+					keywordCount += position != baselineKeywordMap.end();
+				}
+			}
+			doNotOptimize(keywordCount);
+			report("keyword lookup: std::unordered_map", timer.elapsedSeconds(), tokens.size() * rounds, "word");
+		}
+
+		{
+			Timer timer;
+			size_t keywordCount = 0;
+			for (int round = 0; round < rounds; ++round) {
+				for (const Quartz::Token& token : tokens)
+					keywordCount += Quartz::lookupKeyword(corpus.data() + token.Offset, token.Length) != Quartz::IDENTIFIER;
+			}
+			doNotOptimize(keywordCount);
+			report("keyword lookup: perfect hash", timer.elapsedSeconds(), tokens.size() * rounds, "word");
+		}
+
+		{
+			Timer timer;
+			size_t tokenCount = 0;
+			for (int round = 0; round < rounds; ++round)
+				tokenCount += Quartz::Tokenizer(corpus.c_str()).tokenize().size();
+			doNotOptimize(tokenCount);
+			reportThroughput("tokenize: identifier corpus", timer.elapsedSeconds(), corpus.size() * rounds);
+		}
+	}
+}
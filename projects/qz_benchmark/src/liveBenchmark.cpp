@@ -0,0 +1,125 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <quartz/quartz.hpp>
+#include <quartz/live/spscQueue.hpp>
+#include <quartz/parser/flatAST.hpp>
+#include <quartz/vm/compiler.hpp>
+#include <quartz/vm/virtualMachine.hpp>
+
+namespace QuartzBenchmark {
+	namespace {
+		constexpr size_t PACED_TICKS = 20'000;
+		// Slow enough that the queues are empty when a tick arrives, so the latency is the hand off
+		// and the strategy rather than queueing
+		constexpr int64_t PACE_NANOSECONDS = 20'000;
+		constexpr size_t FLOOD_TICKS = 1 << 20;
+		constexpr size_t QUEUE_CAPACITY = 4096;
+
+		struct BenchTick {
+			int64_t enqueued;
+			double price;
+		};
+
+		struct BenchSignal {
+			int64_t tickEnqueued;
+			Quartz::Signal signal;
+		};
+
+		int64_t nowNanoseconds() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// Feed thread -> strategy thread running on_data() in the VM -> order thread, the same pipeline
+		// as qz_interpreter --live. Every tick emits a signal, the latencies are tick enqueue to signal
+		// dequeue.
+		template <typename Wait>
+		double runPipeline(const Quartz::CompiledStrategy& strategy, size_t tickCount, int64_t pace, std::vector<int64_t>& latencies) {
+			Quartz::SpscQueue<BenchTick, Wait> ticks(QUEUE_CAPACITY);
+			Quartz::SpscQueue<BenchSignal, Wait> signals(QUEUE_CAPACITY);
+			latencies.clear();
+			latencies.reserve(tickCount);
+
+			Timer timer;
+			std::thread strategyThread([&] {
+				std::vector<Quartz::RawValue> frame(strategy.frameSize);
+				Quartz::VirtualMachine vm;
+				Quartz::ExecutionContext context;
+				context.frame = frame.data();
+				BenchTick tick;
+				while (ticks.pop(tick)) {
+					frame[0].floating = tick.price;
+					signals.push({ tick.enqueued, vm.execute(strategy, strategy.onData, context) });
+				}
+				signals.close();
+			});
+			std::thread orderThread([&] {
+				BenchSignal signal;
+				while (signals.pop(signal))
+					latencies.push_back(nowNanoseconds() - signal.tickEnqueued);
+			});
+
+			int64_t deadline = nowNanoseconds();
+			for (size_t i = 0; i < tickCount; ++i) {
+				if (pace != 0) {
+					deadline += pace;
+					// Sleeping leaves a shared core to the other threads, spinning keeps the
+					// producer's own wake up out of the measurement
+					if constexpr (std::is_same_v<Wait, Quartz::BusyPollWait>) {
+						while (nowNanoseconds() < deadline)
+							Quartz::cpuRelax();
+					}
+					else {
+						std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline)));
+					}
+				}
+				ticks.push({ nowNanoseconds(), 100.0 + static_cast<double>(i & 63) });
+			}
+			ticks.close();
+			strategyThread.join();
+			orderThread.join();
+			return timer.elapsedSeconds();
+		}
+
+		void reportLatency(const std::string& name, std::vector<int64_t>& latencies) {
+			std::sort(latencies.begin(), latencies.end());
+			auto percentile = [&](double fraction) {
+				return latencies[static_cast<size_t>(fraction * static_cast<double>(latencies.size() - 1))];
+			};
+			std::printf("%-40s p50 %7lld ns  p99 %8lld ns  p99.9 %8lld ns\n", name.c_str(), static_cast<long long>(percentile(0.5)),
+				static_cast<long long>(percentile(0.99)), static_cast<long long>(percentile(0.999)));
+		}
+
+		template <typename Wait>
+		void runWaitStrategy(const std::string& name, const Quartz::CompiledStrategy& strategy) {
+			std::vector<int64_t> latencies;
+			runPipeline<Wait>(strategy, PACED_TICKS, PACE_NANOSECONDS, latencies);
+			check(latencies.size() == PACED_TICKS, name + " lost signals");
+			reportLatency(name + " tick to signal", latencies);
+
+			const double seconds = runPipeline<Wait>(strategy, FLOOD_TICKS, 0, latencies);
+			report(name + " unpaced", seconds, FLOOD_TICKS, "tick");
+		}
+	}
+
+	void runLiveBenchmark() {
+		std::shared_ptr<const Quartz::FlatAST> ast = Quartz::analyse_program(Quartz::run_code(
+			"strategy Threshold {"
+			"    init() -> void { define_input_variables(price); }"
+			"    on_data() -> void { if (price > 131.5) { emit_signal(SELL); } else { emit_signal(BUY); } }"
+			"}"));
+		const Quartz::CompiledStrategy strategy = Quartz::Compiler(*ast).compileStrategy(ast->child(0, 0));
+
+		runWaitStrategy<Quartz::FutexWait>("futex", strategy);
+		// Each of the three threads spins on a core of its own, with fewer they only take turns
+		if (std::thread::hardware_concurrency() < 3) {
+			std::printf("%-40s skipped, %u hardware threads\n", "busy poll", std::thread::hardware_concurrency());
+			return;
+		}
+		runWaitStrategy<Quartz::BusyPollWait>("busy poll", strategy);
+	}
+}
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct BenchmarkEntry {
+    const char* name;
+    std::function<void()> run;
+};
+
+int main(int argc, char* argv[]) {
+    const std::vector<BenchmarkEntry> benchmarks = {
+        { "keywords", QuartzBenchmark::runKeywordBenchmark },
+        { "vm", QuartzBenchmark::runVirtualMachineBenchmark },
+        { "csv", QuartzBenchmark::runCsvBenchmark },
+        { "indicators", QuartzBenchmark::runIndicatorBenchmark },
+        { "live", QuartzBenchmark::runLiveBenchmark },
+        { "shards", QuartzBenchmark::runShardBenchmark },
+    };
+
+    if (argc > 1 && std::strcmp(argv[1], "-h") == 0) {
+        std::printf("Usage: %s [benchmark...]\nAvailable benchmarks:\n", argv[0]);
+        for (const BenchmarkEntry& benchmark : benchmarks)
+            std::printf("  %s\n", benchmark.name);
+        return 0;
+    }
+
+    for (const BenchmarkEntry& benchmark : benchmarks) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected |= std::strcmp(argv[i], benchmark.name) == 0;
+        if (!selected)
+            continue;
+
+        std::printf("== %s ==\n", benchmark.name);
+        benchmark.run();
+    }
+
+    if (QuartzBenchmark::failedChecks > 0) {
+        std::printf("%zu check(s) failed\n", QuartzBenchmark::failedChecks);
+        return 1;
+    }
+    return 0;
+}
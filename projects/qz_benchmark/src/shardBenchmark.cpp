@@ -0,0 +1,166 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <quartz/quartz.hpp>
+#include <quartz/live/affinity.hpp>
+#include <quartz/live/spscQueue.hpp>
+#include <quartz/parser/flatAST.hpp>
+#include <quartz/vm/compiler.hpp>
+#include <quartz/vm/virtualMachine.hpp>
+
+namespace QuartzBenchmark {
+	namespace {
+		constexpr size_t SYMBOL_COUNT = 1024;
+		constexpr size_t BAR_COUNT = 1024;
+		// Strategies per symbol, so each tick carries enough work to amortise handing it off
+		constexpr size_t STRATEGY_COUNT = 4;
+		constexpr size_t QUEUE_CAPACITY = 4096;
+
+		struct BenchTick {
+			uint32_t symbol;
+			double price;
+		};
+
+		// One strategy's state on one symbol
+		struct Instance {
+			std::vector<Quartz::RawValue> frame;
+			Quartz::IndicatorSet indicators;
+		};
+
+		struct Shard {
+			Shard() : ticks(QUEUE_CAPACITY) {}
+
+			Quartz::SpscQueue<BenchTick, Quartz::FutexWait> ticks;
+			std::vector<uint32_t> symbols;
+			uint64_t buys = 0;
+			std::thread thread;
+		};
+
+		uint32_t shardOf(uint32_t symbol, uint32_t shardCount) {
+			return static_cast<uint32_t>((symbol * 0x9E3779B97F4A7C15ull >> 32) % shardCount);
+		}
+
+		// The feed thread routes every symbol's ticks to the shard owning it, each shard runs every
+		// strategy on its own symbols with state it allocated itself
+		double runShards(const std::vector<Quartz::CompiledStrategy>& strategies, const std::vector<double>& prices, uint32_t shardCount,
+			const std::vector<unsigned>& cores, uint64_t& buys) {
+			std::vector<std::unique_ptr<Shard>> shards;
+			for (uint32_t i = 0; i < shardCount; ++i)
+				shards.push_back(std::make_unique<Shard>());
+			std::vector<uint32_t> slotOf(SYMBOL_COUNT);
+			for (uint32_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+				Shard& shard = *shards[shardOf(symbol, shardCount)];
+				slotOf[symbol] = static_cast<uint32_t>(shard.symbols.size());
+				shard.symbols.push_back(symbol);
+			}
+
+			Timer timer;
+			for (uint32_t i = 0; i < shardCount; ++i) {
+				Shard& shard = *shards[i];
+				// The first core is left to the feed thread
+				const int core = cores.size() > shardCount ? static_cast<int>(cores[i + 1]) : -1;
+				shard.thread = std::thread([&shard, &strategies, &slotOf, core] {
+					if (core >= 0)
+						Quartz::pinCurrentThread(static_cast<unsigned>(core));
+					std::vector<Instance> instances;
+					instances.reserve(shard.symbols.size() * strategies.size());
+					for (size_t i = 0; i < shard.symbols.size(); ++i) {
+						for (const Quartz::CompiledStrategy& strategy : strategies)
+							instances.push_back({ std::vector<Quartz::RawValue>(strategy.frameSize), Quartz::IndicatorSet(strategy.indicators) });
+					}
+
+					Quartz::VirtualMachine vm;
+					Quartz::ExecutionContext context;
+					BenchTick tick;
+					uint64_t buys = 0;
+					while (shard.ticks.pop(tick)) {
+						Instance* instance = &instances[slotOf[tick.symbol] * strategies.size()];
+						for (size_t i = 0; i < strategies.size(); ++i, ++instance) {
+							instance->frame[0].floating = tick.price;
+							context.frame = instance->frame.data();
+							context.indicators = &instance->indicators;
+							buys += vm.execute(strategies[i], strategies[i].onData, context) == Quartz::BUY;
+						}
+					}
+					shard.buys = buys;
+				});
+			}
+
+			for (size_t bar = 0; bar < BAR_COUNT; ++bar) {
+				for (uint32_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol)
+					shards[shardOf(symbol, shardCount)]->ticks.push({ symbol, prices[symbol * BAR_COUNT + bar] });
+			}
+			for (std::unique_ptr<Shard>& shard : shards)
+				shard->ticks.close();
+			buys = 0;
+			for (std::unique_ptr<Shard>& shard : shards) {
+				shard->thread.join();
+				buys += shard->buys;
+			}
+			return timer.elapsedSeconds();
+		}
+	}
+
+	void runShardBenchmark() {
+		std::string source;
+		for (size_t i = 0; i < STRATEGY_COUNT; ++i) {
+			const std::string fast = std::to_string(5 + i * 3);
+			source += "strategy S" + std::to_string(i) + " {"
+				"    init() -> void { define_input_variables(price); }"
+				"    on_data() -> void {"
+				"        var fast = ema(price, " + fast + ");"
+				"        var slow = sma(price, 50);"
+				"        var band = rolling_std(price, 20);"
+				"        if (fast > slow) { if (band < 2.0) { emit_signal(BUY); } } else { emit_signal(SELL); }"
+				"    }"
+				"}";
+		}
+		std::shared_ptr<const Quartz::FlatAST> ast = Quartz::analyse_program(Quartz::run_code(source.c_str()));
+		std::vector<Quartz::CompiledStrategy> strategies;
+		for (uint32_t i = 0; i < ast->childCount[0]; ++i)
+			strategies.push_back(Quartz::Compiler(*ast).compileStrategy(ast->child(0, i)));
+
+		// An independent random walk per symbol
+		std::vector<double> prices(SYMBOL_COUNT * BAR_COUNT);
+		std::mt19937_64 rng(11);
+		std::normal_distribution<double> step(0.0, 1.0);
+		for (size_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+			double price = 100.0;
+			for (size_t bar = 0; bar < BAR_COUNT; ++bar) {
+				price = std::max(1.0, price + step(rng));
+				prices[symbol * BAR_COUNT + bar] = price;
+			}
+		}
+
+		// One core feeds, the rest run shards
+		const std::vector<unsigned> cores = Quartz::availableCores();
+		const uint32_t maxShards = std::max<uint32_t>(1, static_cast<uint32_t>(cores.size()) - 1);
+		const size_t tickCount = SYMBOL_COUNT * BAR_COUNT;
+		double baseline = 0.0;
+		uint64_t baselineBuys = 0;
+		// Powers of two, then every core
+		std::vector<uint32_t> shardCounts;
+		for (uint32_t shardCount = 1; shardCount < maxShards; shardCount *= 2)
+			shardCounts.push_back(shardCount);
+		shardCounts.push_back(maxShards);
+
+		for (uint32_t shardCount : shardCounts) {
+			uint64_t buys = 0;
+			const double seconds = runShards(strategies, prices, shardCount, cores, buys);
+			if (shardCount == 1) {
+				baseline = seconds;
+				baselineBuys = buys;
+			}
+			report(std::to_string(shardCount) + (shardCount == 1 ? " shard" : " shards"), seconds, tickCount, "tick");
+			std::printf("%-40s %10.2fx\n", "  speedup", baseline / seconds);
+			check(buys == baselineBuys, std::to_string(shardCount) + " shards changed the signals");
+		}
+		if (maxShards == 1)
+			std::printf("%-40s skipped, %zu cores available\n", "more shards", cores.size());
+	}
+}
@@ -0,0 +1,338 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <quartz/quartz.hpp>
+#include <quartz/parser/flatAST.hpp>
+#include <quartz/vm/builtins.hpp>
+#include <quartz/vm/compiler.hpp>
+#include <quartz/vm/jit.hpp>
+#include <quartz/vm/nativeCompiler.hpp>
+#include <quartz/vm/nativeLibrary.hpp>
+#include <quartz/vm/stateBlock.hpp>
+#include <quartz/vm/virtualMachine.hpp>
+
+namespace QuartzBenchmark {
+	namespace {
+		constexpr size_t BAR_COUNT = 1 << 16;
+		constexpr size_t ITERATIONS = 10'000'000;
+		// One instance per symbol, every instance sees the same bars
+		constexpr size_t INSTANCE_COUNT = 4096;
+		constexpr size_t INSTANCE_BAR_COUNT = 256;
+
+		Quartz::NodeIndex findStrategy(const Quartz::FlatAST& ast) {
+			for (uint32_t i = 0; i < ast.childCount[0]; ++i) {
+				Quartz::NodeIndex node = ast.child(0, i);
+				if (ast.kinds[node] == Quartz::NodeType::Strategy)
+					return node;
+			}
+			return Quartz::INVALID_NODE;
+		}
+
+		// Registered the way a host application adds its own indicators
+		double spread(Quartz::ExecutionContext&, double left, double right) {
+			return left - right;
+		}
+
+		// Cost of a builtin call from bytecode: register marshalling plus the indirect call
+		void runBuiltinCallBenchmark() {
+			Quartz::BuiltinRegistry& registry = Quartz::BuiltinRegistry::getInstance();
+			if (registry.find(Quartz::intern("bench_spread")) == Quartz::BuiltinRegistry::NOT_FOUND)
+				registry.add<&spread>("bench_spread");
+
+			std::shared_ptr<Quartz::ProgramNode> program = Quartz::run_code(
+				"strategy Spread {"
+				"    init() -> void { define_input_variables(fast, slow); }"
+				"    on_data() -> void { if (bench_spread(fast, slow) > 0.0) { emit_signal(BUY); } }"
+				"}");
+			std::shared_ptr<const Quartz::FlatAST> ast = Quartz::analyse_program(program);
+			const Quartz::CompiledStrategy strategy = Quartz::Compiler(*ast).compileStrategy(findStrategy(*ast));
+
+			std::vector<Quartz::RawValue> frame(strategy.frameSize);
+			Quartz::VirtualMachine vm;
+			Quartz::ExecutionContext context;
+			context.frame = frame.data();
+
+			size_t buys = 0;
+			Timer timer;
+			for (size_t i = 0; i < ITERATIONS; ++i) {
+				frame[0].floating = static_cast<double>(i & 1023);
+				frame[1].floating = 512.0;
+				buys += vm.execute(strategy, strategy.onData, context) == Quartz::BUY;
+			}
+			double seconds = timer.elapsedSeconds();
+			doNotOptimize(buys);
+
+			report("on_data with host builtin call", seconds, ITERATIONS, "call");
+		}
+
+		// Lookbacks into the input history, a constant masked read per access in every tier
+		void runHistoryBenchmark() {
+			std::shared_ptr<Quartz::ProgramNode> program = Quartz::run_code(
+				"strategy Breakout {"
+				"    init() -> void { define_input_variables(price); }"
+				"    on_data() -> void {"
+				"        if (price > price[1]) { if (price[1] > price[2]) { emit_signal(BUY); } }"
+				"        if (price < price[20]) { emit_signal(SELL); }"
+				"    }"
+				"}");
+			std::shared_ptr<const Quartz::FlatAST> ast = Quartz::analyse_program(program);
+			const Quartz::CompiledStrategy strategy = Quartz::Compiler(*ast).compileStrategy(findStrategy(*ast));
+
+			std::vector<double> prices(BAR_COUNT);
+			std::mt19937_64 rng(11);
+			std::normal_distribution<double> step(0.0, 1.0);
+			double price = 100.0;
+			for (double& value : prices) {
+				price += step(rng) - 0.05 * (price - 100.0);
+				value = price;
+			}
+
+			std::vector<Quartz::RawValue> frame(strategy.frameSize);
+			auto replay = [&](const Quartz::JitCode* jit, size_t* signals) {
+				Quartz::InputHistory history(strategy.historyCapacities);
+				Quartz::VirtualMachine vm;
+				Quartz::ExecutionContext context;
+				context.frame = frame.data();
+				context.history = &history;
+				Timer timer;
+				for (size_t i = 0; i < ITERATIONS; ++i) {
+					const double* bar = &prices[i & (BAR_COUNT - 1)];
+					frame[0].floating = *bar;
+					history.push(bar);
+					signals[jit ? jit->call(frame.data(), nullptr, history) : vm.execute(strategy, strategy.onData, context)]++;
+				}
+				return timer.elapsedSeconds();
+			};
+
+			size_t signals[3] = {};
+			report("on_data with history lookbacks", replay(nullptr, signals), ITERATIONS, "call");
+			doNotOptimize(signals);
+			std::printf("%-40s %u doubles\n", "price history ring", strategy.historyCapacities[0]);
+
+			std::unique_ptr<Quartz::JitCode> jit = Quartz::JitCompiler::compile(strategy, strategy.onData);
+			if (!jit)
+				return;
+			size_t jitSignals[3] = {};
+			report("on_data with history lookbacks JIT", replay(jit.get(), jitSignals), ITERATIONS, "call");
+			check(std::equal(signals, signals + 3, jitSignals), "JIT history reads differ from the VM");
+		}
+		// Heap in use, 0 where the allocator can't say
+		size_t heapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+			const struct mallinfo2 info = mallinfo2();
+			// Large blocks are mapped on their own and only counted in hblkhd
+			return info.uordblks + info.hblkhd;
+#else
+			return 0;
+#endif
+		}
+
+		// One strategy run on INSTANCE_COUNT symbols, each instance's state allocated on its own
+		// against all of them in one StateBlock
+		void runStateBlockBenchmark() {
+			std::shared_ptr<Quartz::ProgramNode> program = Quartz::run_code(
+				"strategy Momentum {"
+				"    init() -> void { define_input_variables(price); }"
+				"    on_data() -> void {"
+				"        var fast = ema(price, 12);"
+				"        var slow = sma(price, 26);"
+				"        if (fast > slow) { if (price > price[5]) { emit_signal(BUY); } }"
+				"        if (price < rolling_min(price, 20)) { emit_signal(SELL); }"
+				"    }"
+				"}");
+			std::shared_ptr<const Quartz::FlatAST> ast = Quartz::analyse_program(program);
+			const Quartz::CompiledStrategy strategy = Quartz::Compiler(*ast).compileStrategy(findStrategy(*ast));
+
+			std::vector<double> prices(INSTANCE_COUNT * INSTANCE_BAR_COUNT);
+			std::mt19937_64 rng(5);
+			std::normal_distribution<double> step(0.0, 1.0);
+			for (size_t instance = 0; instance < INSTANCE_COUNT; ++instance) {
+				double price = 100.0;
+				for (size_t bar = 0; bar < INSTANCE_BAR_COUNT; ++bar) {
+					price += step(rng) - 0.05 * (price - 100.0);
+					prices[bar * INSTANCE_COUNT + instance] = price;
+				}
+			}
+
+			// Bar by bar across every symbol, the way ticks of many feeds arrive
+			auto replay = [&](auto& states, size_t* signals) {
+				Quartz::VirtualMachine vm;
+				Quartz::ExecutionContext context;
+				Timer timer;
+				for (size_t bar = 0; bar < INSTANCE_BAR_COUNT; ++bar) {
+					for (size_t instance = 0; instance < INSTANCE_COUNT; ++instance) {
+						auto& state = states[instance];
+						const double* price = &prices[bar * INSTANCE_COUNT + instance];
+						Quartz::RawValue* frame = &state.frame[0];
+						frame[0].floating = *price;
+						state.history.push(price);
+						context.frame = frame;
+						context.indicators = &state.indicators;
+						context.history = &state.history;
+						signals[vm.execute(strategy, strategy.onData, context)]++;
+					}
+				}
+				return timer.elapsedSeconds();
+			};
+
+			struct OwnedState {
+				std::vector<Quartz::RawValue> frame;
+				Quartz::IndicatorSet indicators;
+				Quartz::InputHistory history;
+			};
+
+			size_t heap = heapBytes();
+			std::vector<OwnedState> owned;
+			owned.reserve(INSTANCE_COUNT);
+			for (size_t i = 0; i < INSTANCE_COUNT; ++i)
+				owned.push_back({ std::vector<Quartz::RawValue>(strategy.frameSize), Quartz::IndicatorSet(strategy.indicators), Quartz::InputHistory(strategy.historyCapacities) });
+			const size_t ownedBytes = heapBytes() - heap;
+
+			heap = heapBytes();
+			Quartz::StateBlock block(std::make_shared<Quartz::StateLayout>(strategy), INSTANCE_COUNT);
+			const size_t blockBytes = heapBytes() - heap;
+			std::vector<Quartz::StrategyState> blockViews;
+			for (size_t i = 0; i < INSTANCE_COUNT; ++i)
+				blockViews.push_back(block.instance(i));
+
+			size_t ownedSignals[3] = {};
+			size_t blockSignals[3] = {};
+			const double ownedSeconds = replay(owned, ownedSignals);
+			const double blockSeconds = replay(blockViews, blockSignals);
+			doNotOptimize(ownedSignals);
+			doNotOptimize(blockSignals);
+
+			const std::string name = std::to_string(INSTANCE_COUNT) + " instances";
+			report(name + ", own state", ownedSeconds, INSTANCE_COUNT * INSTANCE_BAR_COUNT, "bar");
+			report(name + ", state block", blockSeconds, INSTANCE_COUNT * INSTANCE_BAR_COUNT, "bar");
+			if (ownedBytes != 0 && blockBytes != 0) {
+				std::printf("%-40s %10zu bytes/instance\n", "own state heap", ownedBytes / INSTANCE_COUNT);
+				std::printf("%-40s %10zu bytes/instance\n", "state block heap", blockBytes / INSTANCE_COUNT);
+			}
+			std::printf("%-40s %10zu bytes/instance\n", "state block layout", block.layout().instanceBytes());
+			check(std::equal(ownedSignals, ownedSignals + 3, blockSignals), "state block signals differ from own state");
+		}
+	}
+
+	void runVirtualMachineBenchmark() {
+		const std::string path = std::string(QUARTZ_EXAMPLES_DIR) + "/moving_average_crossover.qz";
+		std::shared_ptr<Quartz::ProgramNode> program = Quartz::run_file(path.c_str());
+		std::shared_ptr<const Quartz::FlatAST> typedAst = Quartz::analyse_program(program);
+		const Quartz::FlatAST& ast = *typedAst;
+
+		Quartz::NodeIndex strategyNode = findStrategy(ast);
+		if (strategyNode == Quartz::INVALID_NODE) {
+			std::printf("No strategy found in %s\n", path.c_str());
+			return;
+		}
+		const Quartz::CompiledStrategy strategy = Quartz::Compiler(ast).compileStrategy(strategyNode);
+
+		// Mean reverting random walks for every input so the crossover branches aren't trivially predictable
+		const size_t inputCount = strategy.inputs.size();
+		std::vector<double> bars(BAR_COUNT * inputCount);
+		std::mt19937_64 rng(42);
+		std::normal_distribution<double> step(0.0, 1.0);
+		std::vector<double> walk(inputCount, 100.0);
+		for (size_t bar = 0; bar < BAR_COUNT; ++bar) {
+			for (size_t input = 0; input < inputCount; ++input) {
+				walk[input] += step(rng) - 0.05 * (walk[input] - 100.0);
+				bars[bar * inputCount + input] = walk[input];
+			}
+		}
+
+		// Every tier copies the bar into the input slots of the frame and records it in the input
+		// history, as the interpreter does
+		std::vector<Quartz::RawValue> frame(strategy.frameSize);
+		auto loadBar = [&](size_t i, Quartz::InputHistory& history) {
+			const double* bar = &bars[(i & (BAR_COUNT - 1)) * inputCount];
+			for (size_t input = 0; input < inputCount; ++input)
+				frame[input].floating = bar[input];
+			history.push(bar);
+		};
+
+		// Every tier starts from fresh indicator state and history so their signals can be compared
+		Quartz::IndicatorSet indicators(strategy.indicators);
+		Quartz::InputHistory history(strategy.historyCapacities);
+		Quartz::VirtualMachine vm;
+		Quartz::ExecutionContext context;
+		context.frame = frame.data();
+		context.indicators = &indicators;
+		context.history = &history;
+		vm.execute(strategy, strategy.init, context);
+
+		size_t signals[3] = {};
+		Timer timer;
+		for (size_t i = 0; i < ITERATIONS; ++i) {
+			loadBar(i, history);
+			Quartz::Signal signal = vm.execute(strategy, strategy.onData, context);
+			signals[signal]++;
+		}
+		double seconds = timer.elapsedSeconds();
+		doNotOptimize(signals);
+
+		report("on_data (moving_average_crossover)", seconds, ITERATIONS, "call");
+		std::printf("%-40s %zu buy / %zu hold / %zu sell\n", "signals", signals[Quartz::BUY], signals[Quartz::HOLD], signals[Quartz::SELL]);
+
+		std::unique_ptr<Quartz::JitCode> jit = Quartz::JitCompiler::compile(strategy, strategy.onData);
+		if (jit) {
+			Quartz::IndicatorSet jitIndicators(strategy.indicators);
+			Quartz::InputHistory jitHistory(strategy.historyCapacities);
+			size_t jitSignals[3] = {};
+			Timer jitTimer;
+			for (size_t i = 0; i < ITERATIONS; ++i) {
+				loadBar(i, jitHistory);
+				Quartz::Signal signal = jit->call(frame.data(), &jitIndicators, jitHistory);
+				jitSignals[signal]++;
+			}
+			double jitSeconds = jitTimer.elapsedSeconds();
+			doNotOptimize(jitSignals);
+
+			report("on_data JIT", jitSeconds, ITERATIONS, "call");
+			check(std::equal(signals, signals + 3, jitSignals), "JIT signals differ from the VM");
+		}
+		else {
+			std::printf("%-40s skipped\n", "on_data JIT");
+		}
+
+		runBuiltinCallBenchmark();
+		runHistoryBenchmark();
+		runStateBlockBenchmark();
+
+		// Same strategy ahead of time compiled, skipped when there is no system compiler
+		std::shared_ptr<Quartz::NativeLibrary> library;
+		try {
+			const std::string libraryPath = (std::filesystem::temp_directory_path() / "qz_benchmark_strategy.so").string();
+			Quartz::NativeCompiler::buildSharedObject(Quartz::NativeCompiler(ast).emitSource(), libraryPath);
+			library = Quartz::NativeLibrary::open(libraryPath);
+			std::filesystem::remove(libraryPath);
+		}
+		catch (const std::exception&) {
+			std::printf("%-40s skipped\n", "on_data native");
+			return;
+		}
+
+		const QuartzStrategyDescriptor& native = library->strategy(0);
+		Quartz::IndicatorSet nativeIndicators = Quartz::NativeLibrary::createIndicators(native);
+		Quartz::InputHistory nativeHistory = Quartz::NativeLibrary::createHistory(native);
+		size_t nativeSignals[3] = {};
+		Timer nativeTimer;
+		for (size_t i = 0; i < ITERATIONS; ++i) {
+			loadBar(i, nativeHistory);
+			Quartz::Signal signal = Quartz::NativeLibrary::onData(native, reinterpret_cast<const double*>(frame.data()), nativeIndicators, nativeHistory);
+			nativeSignals[signal]++;
+		}
+		double nativeSeconds = nativeTimer.elapsedSeconds();
+		doNotOptimize(nativeSignals);
+
+		report("on_data native", nativeSeconds, ITERATIONS, "call");
+		check(std::equal(signals, signals + 3, nativeSignals), "native signals differ from the VM");
+	}
+}
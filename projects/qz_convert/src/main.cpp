@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include <quartz/data/barFile.hpp>
+#include <quartz/logging/logging.hpp>
+#include <quartz/utils/fileUtils.hpp>
+
+// Converts CSV bars into the memory mapped columnar format the backtester loads (see data/barFile.hpp)
+int main(int argc, char* argv[]) {
+    // Columns filled in during conversion are worth knowing about
+    Quartz::Logger::getInstance().setPrintLevel(Quartz::Logger::WARNING);
+
+    std::string input;
+    std::string output;
+    std::string symbol;
+    std::string interval;
+    std::string threads;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string* value = nullptr;
+        if (arg == "-o")
+            value = &output;
+        else if (arg == "--symbol")
+            value = &symbol;
+        else if (arg == "--interval")
+            value = &interval;
+        else if (arg == "-j")
+            value = &threads;
+        else if (input.empty() && !arg.empty() && arg[0] != '-') {
+            input = arg;
+            continue;
+        }
+        else {
+            Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "Unknown flag " + arg);
+            return 1;
+        }
+
+        if (i + 1 >= argc) {
+            Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, arg + " requires a value");
+            return 1;
+        }
+        *value = argv[++i];
+    }
+
+    if (input.empty()) {
+        Quartz::Logger::getInstance().logf(Quartz::Logger::ERROR, "Usage: %s <bars.csv> [-o <bars.qzb>] [--symbol <symbol>] [--interval <interval>] [-j <threads>]", argv[0]);
+        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "The CSV needs a timestamp, time or date column and close or price, missing open, high and low "
+            "are filled in from close and a missing volume as 0");
+        return 1;
+    }
+
+    // AAPL_1d.csv names symbol AAPL at interval 1d, which is also where the backtester looks for it
+    const std::filesystem::path inputPath(input);
+    const std::string stem = inputPath.stem().string();
+    const size_t separator = stem.rfind('_');
+    if (symbol.empty())
+        symbol = stem.substr(0, separator);
+    if (interval.empty() && separator != std::string::npos)
+        interval = stem.substr(separator + 1);
+    if (output.empty())
+        output = std::filesystem::path(inputPath).replace_extension(".qzb").string();
+
+    // Errors are logged by the Logger before they are thrown
+    try {
+        // 0 parses on every hardware thread
+        Quartz::BarTable table = Quartz::loadCsvBars(input.c_str(), static_cast<unsigned>(std::strtoul(threads.c_str(), nullptr, 10)));
+        table.symbol = symbol;
+        table.interval = interval;
+        Quartz::writeBarFile(output, table);
+        Quartz::Logger::getInstance().logf(Quartz::Logger::INFO, "Wrote %zu %s bars (%s) to %s", table.timestamps.size(),
+            symbol.c_str(), interval.empty() ? "no interval" : interval.c_str(), output.c_str());
+    }
+    catch (const std::exception&) {
+        return 1;
+    }
+    return 0;
+}
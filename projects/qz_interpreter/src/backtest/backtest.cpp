@@ -0,0 +1,114 @@
+#include "backtest.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <quartz/logging/logging.hpp>
+
+namespace Quartz {
+	namespace {
+		// Unbinds the strategies from a graph on the way out of a replay, thrown or not, so nothing
+		// points into the graph once it's gone
+		struct GraphLink {
+			IndicatorGraph& graph;
+			~GraphLink() { graph.unlink(); }
+		};
+	}
+
+	const std::vector<BacktestResult>& Backtester::run()
+	{
+		mResults.clear();
+		for (const Feed& feed : groupFeeds(mInterpreter.strategies()))
+			runFeed(feed);
+		return mResults;
+	}
+
+	void Backtester::runFeed(const Feed& feed)
+	{
+		// Held until the next feed, so one source is in memory at a time
+		const std::string path = BarSource::find(mDataDirectory, feed.source.ticker, feed.source.interval);
+		mBars.load(path, feed.columns);
+		replay(feed, mBars.columns(), mBars.rowCount());
+	}
+
+	void Backtester::replay(const Feed& feed, const std::vector<const double*>& columns, uint64_t barCount)
+	{
+		const size_t strategyCount = feed.strategies.size();
+		mInputs.assign(strategyCount, {});
+		for (size_t i = 0; i < strategyCount; ++i)
+			mInputs[i].resize(feed.strategies[i]->inputs.size());
+
+		// Every replay starts from fresh indicator state and an empty history, shared indicators are
+		// bound to the graph
+		IndicatorGraph graph;
+		for (size_t i = 0; i < strategyCount; ++i) {
+			const Strategy& strategy = *feed.strategies[i];
+			graph.addStrategy(strategy.compiled, feed.inputColumns[i], mInterpreter.resetState(strategy).indicators);
+		}
+		graph.link();
+		GraphLink linked{ graph };
+		Logger::getInstance().logf(Logger::INFO, "Backtesting %zu strategies on %s %s (%llu bars), %zu indicator calls share %zu indicators",
+			strategyCount, feed.source.ticker.c_str(), feed.source.interval.c_str(), static_cast<unsigned long long>(barCount),
+			graph.callSiteCount(), graph.nodeCount());
+
+		const size_t firstResult = mResults.size();
+		for (const Strategy* strategy : feed.strategies) {
+			BacktestResult result;
+			result.strategy = strategy->name;
+			result.source = feed.source;
+			result.bars = barCount;
+			result.changes.reserve(std::min<uint64_t>(barCount, Backtester::RESERVED_CHANGES));
+			mResults.push_back(std::move(result));
+		}
+		BacktestResult* results = mResults.data() + firstResult;
+		std::vector<Signal> positions(strategyCount, HOLD);
+
+		const size_t columnCount = feed.columns.size();
+		const double* const* columnData = columns.data();
+		mRow.resize(columnCount);
+		double* row = mRow.data();
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t bar = 0; bar < barCount; ++bar) {
+			for (size_t column = 0; column < columnCount; ++column)
+				row[column] = columnData[column][bar];
+			graph.update(row);
+
+			for (size_t i = 0; i < strategyCount; ++i) {
+				const std::vector<uint32_t>& inputColumns = feed.inputColumns[i];
+				double* inputs = mInputs[i].data();
+				for (size_t input = 0; input < inputColumns.size(); ++input)
+					inputs[input] = row[inputColumns[input]];
+
+				Signal signal = mInterpreter.onData(*feed.strategies[i], inputs);
+				results[i].signals[signal]++;
+				if (signal != HOLD && signal != positions[i]) {
+					positions[i] = signal;
+					results[i].changes.push_back({ bar, signal });
+				}
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (size_t i = 0; i < strategyCount; ++i)
+			results[i].seconds = seconds / static_cast<double>(strategyCount);
+	}
+
+	void Backtester::printResults() const
+	{
+		uint64_t totalBars = 0;
+		double totalSeconds = 0.0;
+		for (const BacktestResult& result : mResults) {
+			std::cout << symbolName(result.strategy) << " " << result.source.ticker;
+			if (!result.source.interval.empty())
+				std::cout << " (" << result.source.interval << ")";
+			std::cout << ": " << result.bars << " bars, " << result.signals[BUY] << " buy / " << result.signals[HOLD] << " hold / "
+				<< result.signals[SELL] << " sell, " << result.changes.size() << " position changes\n";
+			totalBars += result.bars;
+			totalSeconds += result.seconds;
+		}
+		if (totalSeconds > 0.0)
+			Logger::getInstance().logf(Logger::INFO, "Backtested %llu bars in %.3f ms (%.1f M bars/s)", static_cast<unsigned long long>(totalBars),
+				totalSeconds * 1e3, static_cast<double>(totalBars) / totalSeconds / 1e6);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <quartz/data/barSource.hpp>
+#include <quartz/vm/indicatorGraph.hpp>
+
+#include "../interpreter.hpp"
+
+namespace Quartz {
+	// A bar where the strategy's position changed, HOLD doesn't change it
+	struct SignalChange {
+		uint64_t bar;
+		Signal signal;
+	};
+
+	// What one strategy did over one data source
+	struct BacktestResult {
+		Symbol strategy = INVALID_SYMBOL;
+		DataSource source;
+		uint64_t bars = 0;
+		// Indexed by Signal
+		uint64_t signals[3] = {};
+		std::vector<SignalChange> changes;
+		// Replay time of the source, split evenly between the strategies reading it
+		double seconds = 0.0;
+	};
+
+	// Replays local bar files through on_data(), each source is loaded with a BarSource (see
+	// data/barSource.hpp for where files are looked up and how columns are matched to inputs). Every
+	// input is a contiguous column that the bar loop walks front to back, and the bar loop itself
+	// only allocates when a strategy changes position more than RESERVED_CHANGES times. One source
+	// is held in memory at a time.
+	//
+	// Every strategy reading the same source is replayed in the same pass. The source's columns are
+	// loaded once, and indicators the strategies have in common go through an IndicatorGraph so each
+	// is computed once per bar however many strategies use it.
+	class Backtester {
+	public:
+		// Position changes reserved per strategy and source before the bar loop. Strategies change
+		// position on a small fraction of bars, so this covers almost every replay for 16 KB. One
+		// that changes more grows the vector a few times, rather than every replay of a sweep
+		// paying for one change per bar up front.
+		static constexpr uint64_t RESERVED_CHANGES = 1024;
+
+		Backtester(Interpreter& interpreter, std::string dataDirectory)
+			: mInterpreter(interpreter), mDataDirectory(std::move(dataDirectory)) {}
+
+		// Runs every strategy over every data source it added in init()
+		const std::vector<BacktestResult>& run();
+
+		// Replays bars that are already in memory, columns holds each of feed.columns
+		void replay(const Feed& feed, const std::vector<const double*>& columns, uint64_t barCount);
+
+		const std::vector<BacktestResult>& results() const { return mResults; }
+
+		void printResults() const;
+
+	private:
+		Interpreter& mInterpreter;
+		std::string mDataDirectory;
+
+		BarSource mBars;
+		std::vector<double> mRow;
+		// Per strategy of the source being replayed, its gathered inputs
+		std::vector<std::vector<double>> mInputs;
+		std::vector<BacktestResult> mResults;
+
+		void runFeed(const Feed& feed);
+	};
+}
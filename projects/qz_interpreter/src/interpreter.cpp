@@ -1,51 +1,197 @@
 #include "interpreter.hpp"
 
-#include <typeinfo>
+#include <quartz/quartz.hpp>
+#include <quartz/logging/logging.hpp>
+#include <quartz/vm/compiler.hpp>
+#include <quartz/vm/nativeCompiler.hpp>
 
-Quartz::Variable Quartz::Interpreter::parseConstant(const ConstDeclNode* node)
+std::unique_ptr<Quartz::Strategy> Quartz::Interpreter::parseStrategy(NodeIndex strategyNode)
 {
-	Variable constant = Variable(node->value);
+	std::unique_ptr<Strategy> strategy = std::make_unique<Strategy>();
+
+	strategy->name = mAst->name(strategyNode);
+	strategy->compiled = Compiler(*mAst).compileStrategy(strategyNode);
+	strategy->inputs = strategy->compiled.inputs;
+	strategy->layout = std::make_shared<StateLayout>(strategy->compiled);
 
-	return constant;
+	return strategy;
 }
 
-std::unique_ptr<Quartz::Strategy> Quartz::Interpreter::parseStrategy(std::unique_ptr<Quartz::ASTNode> node)
+void Quartz::Interpreter::initialiseStrategy(Strategy& strategy)
 {
-	StrategyNode* strategyNode = dynamic_cast<StrategyNode*>(node.get());
-	std::unique_ptr<Strategy> strategy = std::make_unique<Strategy>();
+	Logger& logger = Logger::getInstance();
+	const std::string name(symbolName(strategy.name));
+
+	// init() runs on an instance of its own, the frame it leaves is where every other one starts
+	StateBlock initial = strategy.newStates(1);
+	StrategyState state = initial.instance(0);
+	ExecutionContext context;
+	context.frame = state.frame;
+	context.indicators = &state.indicators;
+	if (strategy.native) {
+		NativeLibrary::init(*strategy.native, context);
+	}
+	else {
+		if (logger.getPrintLevel() <= Logger::DEBUG) {
+			logger.log(Logger::DEBUG, "Strategy " + name + " init():\n" + disassemble(strategy.compiled, strategy.compiled.init));
+			logger.log(Logger::DEBUG, "Strategy " + name + " on_data():\n" + disassemble(strategy.compiled, strategy.compiled.onData));
+		}
+		mVirtualMachine.execute(strategy.compiled, strategy.compiled.init, context);
+	}
+	strategy.initialFrame.assign(state.frame, state.frame + strategy.layout->frameSize());
+	strategy.dataSources = std::move(context.dataSources);
+
+	for (const DataSource& source : strategy.dataSources)
+		logger.logf(Logger::INFO, "Strategy %s added data source %s (%s)", name.c_str(), source.ticker.c_str(), source.interval.c_str());
+}
+
+void Quartz::Interpreter::addStrategy(std::unique_ptr<Strategy> strategy)
+{
+	strategy->index = static_cast<uint32_t>(mStrategies.size());
+	initialiseStrategy(*strategy);
+	mStrategies.push_back(std::move(strategy));
+	mInstances.push_back(std::make_unique<StrategyInstance>());
+	resetState(*mStrategies.back());
+}
+
+void Quartz::Interpreter::loadNativeStrategies()
+{
+	for (uint32_t i = 0; i < mLibrary->strategyCount(); ++i) {
+		const QuartzStrategyDescriptor& descriptor = mLibrary->strategy(i);
+
+		std::unique_ptr<Strategy> strategy = std::make_unique<Strategy>();
+		strategy->name = intern(descriptor.name);
+		strategy->library = mLibrary;
+		strategy->native = &descriptor;
+		strategy->layout = std::make_shared<StateLayout>(NativeLibrary::stateLayout(descriptor));
+		for (uint32_t input = 0; input < descriptor.inputCount; ++input)
+			strategy->inputs.push_back(intern(descriptor.inputNames[input]));
+
+		addStrategy(std::move(strategy));
+	}
+}
+
+const Quartz::FlatAST& Quartz::Interpreter::flatAST()
+{
+	if (!mAst)
+		mAst = analyse_program(mProgramNode);
+	return *mAst;
+}
+
+void Quartz::Interpreter::compile(const std::string& outputPath)
+{
+	NativeCompiler compiler(flatAST());
+	NativeCompiler::buildSharedObject(compiler.emitSource(), outputPath);
+	Logger::getInstance().logf(Logger::INFO, "Compiled strategies to %s", outputPath.c_str());
+}
+
+Quartz::Signal Quartz::Interpreter::onData(const Strategy& strategy, const double* inputs)
+{
+	StrategyInstance& instance = *mInstances[strategy.index];
+	// Checked before running so a threshold of 0 compiles ahead of the first call
+	if (!strategy.native && !instance.jit && !instance.jitRejected && instance.onDataCalls >= mJitThreshold)
+		tierUp(strategy, instance);
+	if (!strategy.native && !instance.jit)
+		instance.onDataCalls++;
+	return execute(strategy, instance.jit.get(), instance.state, mVirtualMachine, inputs);
+}
+
+Quartz::StrategyState& Quartz::Interpreter::resetState(const Strategy& strategy)
+{
+	StrategyInstance& instance = *mInstances[strategy.index];
+	instance.block = strategy.newStates(1);
+	instance.state = instance.block.instance(0);
+	return instance.state;
+}
+
+Quartz::Signal Quartz::Interpreter::execute(const Strategy& strategy, const JitCode* jit, StrategyState& state, VirtualMachine& virtualMachine, const double* inputs)
+{
+	state.history.push(inputs);
+	if (strategy.native)
+		return NativeLibrary::onData(*strategy.native, inputs, state.indicators, state.history);
 
-	strategy->name = strategyNode->name;
-	strategy->initNode = std::move(strategyNode->initNode);
-	strategy->onDataNode = std::move(strategyNode->onDataNode);
+	for (size_t i = 0; i < strategy.inputs.size(); ++i)
+		state.frame[i].floating = inputs[i];
 
-	for (auto& node : strategyNode->body) {
-		switch (node->nodeType())
+	if (jit)
+		return jit->call(state.frame, &state.indicators, state.history);
+
+	ExecutionContext context;
+	context.frame = state.frame;
+	context.indicators = &state.indicators;
+	context.history = &state.history;
+	return virtualMachine.execute(strategy.compiled, strategy.compiled.onData, context);
+}
+
+void Quartz::Interpreter::tierUpAll()
+{
+	if (mJitThreshold == JIT_DISABLED)
+		return;
+	for (const std::unique_ptr<const Strategy>& strategy : mStrategies) {
+		StrategyInstance& instance = *mInstances[strategy->index];
+		if (!strategy->native && !instance.jit && !instance.jitRejected)
+			tierUp(*strategy, instance);
+	}
+}
+
+void Quartz::Interpreter::tierUp(const Strategy& strategy, StrategyInstance& instance)
+{
+	instance.jit = JitCompiler::compile(strategy.compiled, strategy.compiled.onData);
+	if (instance.jit) {
+		Logger::getInstance().logf(Logger::INFO, "JIT compiled on_data() of %s after %llu calls (%zu bytes)",
+			std::string(symbolName(strategy.name)).c_str(), static_cast<unsigned long long>(instance.onDataCalls), instance.jit->size());
+		return;
+	}
+
+	// Either the host isn't supported or the function uses something the JIT can't handle, don't retry every call
+	instance.jitRejected = true;
+	Logger::getInstance().logf(Logger::INFO, "%s stays interpreted, %s", std::string(symbolName(strategy.name)).c_str(),
+		JitCompiler::supported() ? "on_data() isn't supported by the JIT" : "the JIT doesn't support this host");
+}
+
+Quartz::ExecutionTier Quartz::Interpreter::tier(const Strategy& strategy) const
+{
+	if (strategy.native)
+		return ExecutionTier::Native;
+	return mInstances[strategy.index]->jit ? ExecutionTier::Jit : ExecutionTier::Interpreted;
+}
+
+void Quartz::Interpreter::printStatus() const
+{
+	for (const std::unique_ptr<const Strategy>& strategy : mStrategies) {
+		const char* label = "interpreted";
+		switch (tier(*strategy))
 		{
-		case NodeType::ConstDecl: {
-			ConstDeclNode* constNode = dynamic_cast<ConstDeclNode*>(node.get());
-			strategy->constants[constNode->name] = std::move(parseConstant(constNode));
-			break;
-		}
-		default:
-			break;
+		case ExecutionTier::Jit: label = "JIT"; break;
+		case ExecutionTier::Native: label = "native"; break;
+		default: break;
 		}
+		std::cout << symbolName(strategy->name) << ": " << label << " (" << mInstances[strategy->index]->onDataCalls << " interpreted on_data calls)\n";
 	}
-
-	return strategy;
 }
 
 void Quartz::Interpreter::interpret()
 {
-	mProgramNode->print();
+	if (mLibrary) {
+		loadNativeStrategies();
+		return;
+	}
+
+	if (mProgramNode)
+		mProgramNode->print();
+
+	flatAST();
 
-	auto& statements = mProgramNode->declarations;
-	for (auto& statement : statements) {
-		NodeType type = statement->nodeType();
+	// Node 0 is the program, its children are the top level declarations
+	const uint32_t first = mAst->firstChild[0];
+	const uint32_t count = mAst->childCount[0];
+	for (NodeIndex statement = first; statement < first + count; ++statement) {
+		NodeType type = mAst->kinds[statement];
 		switch (type)
 		{
 		case NodeType::Strategy:
 		{
-			parseStrategy(std::move(statement));
+			addStrategy(parseStrategy(statement));
 			break;
 		}
 		default:
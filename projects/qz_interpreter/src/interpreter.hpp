@@ -3,19 +3,86 @@
 #include <memory>
 
 #include <quartz/parser/abstractSyntaxTree.hpp>
+#include <quartz/parser/flatAST.hpp>
+#include <quartz/vm/virtualMachine.hpp>
+#include <quartz/vm/nativeLibrary.hpp>
+#include <quartz/vm/jit.hpp>
 
 #include "strategy/strategy.hpp"
 
 namespace Quartz {
+	// What the Interpreter changes about a loaded strategy as it runs, kept apart so the Strategy
+	// itself stays read only
+	struct StrategyInstance {
+		// on_data() starts interpreted and is JIT compiled once it has run often enough
+		uint64_t onDataCalls = 0;
+		std::unique_ptr<JitCode> jit = nullptr;
+		bool jitRejected = false;
+
+		// The single threaded modes' instance, replaced by Interpreter::resetState()
+		StateBlock block;
+		StrategyState state;
+	};
+
 	class Interpreter {
 	private:
 		std::shared_ptr<ProgramNode> mProgramNode;
-		Variable parseConstant(const ConstDeclNode* node);
-		std::unique_ptr<Strategy> parseStrategy(const std::unique_ptr<ASTNode> node);
+		std::shared_ptr<const FlatAST> mAst;
+		std::shared_ptr<NativeLibrary> mLibrary;
+		std::vector<std::unique_ptr<const Strategy>> mStrategies;
+		// By Strategy::index
+		std::vector<std::unique_ptr<StrategyInstance>> mInstances;
+		VirtualMachine mVirtualMachine;
+		uint64_t mJitThreshold = DEFAULT_JIT_THRESHOLD;
+
+		std::unique_ptr<Strategy> parseStrategy(NodeIndex strategyNode);
+		void initialiseStrategy(Strategy& strategy);
+		void addStrategy(std::unique_ptr<Strategy> strategy);
+		void loadNativeStrategies();
+		const FlatAST& flatAST();
+		void tierUp(const Strategy& strategy, StrategyInstance& instance);
 	public:
+		static constexpr uint64_t DEFAULT_JIT_THRESHOLD = 1000;
+		static constexpr uint64_t JIT_DISABLED = UINT64_MAX;
+
 		Interpreter(std::shared_ptr<ProgramNode> programNode)
 			: mProgramNode(programNode) {};
+		Interpreter(std::shared_ptr<NativeLibrary> library)
+			: mLibrary(library) {};
+		// An already analysed program, see specialise_program()
+		Interpreter(std::shared_ptr<const FlatAST> ast)
+			: mAst(ast) {};
 
 		void interpret();
+
+		// Compiled mode, builds every strategy of the program into a shared object at outputPath
+		void compile(const std::string& outputPath);
+
+		// on_data() of strategy on its single threaded instance, JIT compiling it once it has run often enough
+		Signal onData(const Strategy& strategy, const double* inputs);
+
+		// Starts the single threaded instance of strategy over, before replaying a new feed
+		StrategyState& resetState(const Strategy& strategy);
+
+		// on_data() of strategy on state, without counting towards the JIT threshold. jit is the
+		// strategy's jitCode(), null to interpret. Any number of threads can run it at once as long
+		// as each has its own state and virtual machine.
+		static Signal execute(const Strategy& strategy, const JitCode* jit, StrategyState& state, VirtualMachine& virtualMachine, const double* inputs);
+
+		// JIT compiles every strategy that will be, before on_data() runs on several threads and
+		// can't tier up
+		void tierUpAll();
+
+		// Interpreted on_data() calls before a strategy is JIT compiled, JIT_DISABLED to never compile
+		void setJitThreshold(uint64_t calls) { mJitThreshold = calls; }
+
+		// Logs which execution tier every strategy is running in
+		void printStatus() const;
+
+		const std::vector<std::unique_ptr<const Strategy>>& strategies() const { return mStrategies; }
+
+		// Null until strategy has been JIT compiled
+		const JitCode* jitCode(const Strategy& strategy) const { return mInstances[strategy.index]->jit.get(); }
+		ExecutionTier tier(const Strategy& strategy) const;
 	};
 }
\ No newline at end of file
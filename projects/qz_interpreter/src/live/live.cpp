@@ -0,0 +1,367 @@
+#include "live.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <iostream>
+#include <thread>
+#include <type_traits>
+
+#include <quartz/live/affinity.hpp>
+#include <quartz/logging/logging.hpp>
+
+namespace Quartz {
+	namespace {
+		int64_t nowNanoseconds() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// Paces the feed thread the same way the other threads wait: spinning, or sleeping so a
+		// shared core is free for them
+		template <typename Wait>
+		void waitUntil(int64_t deadline) {
+			if constexpr (std::is_same_v<Wait, BusyPollWait>) {
+				while (nowNanoseconds() < deadline)
+					cpuRelax();
+			}
+			else {
+				std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline)));
+			}
+		}
+	}
+
+	FileReplayFeed::FileReplayFeed(const std::string& dataDirectory, const std::vector<Feed>& feeds)
+	{
+		// Every file stays loaded for the whole replay, feeds are read side by side
+		mSources.resize(feeds.size());
+		for (size_t i = 0; i < feeds.size(); ++i) {
+			if (feeds[i].columns.size() > MAX_TICK_VALUES)
+				Logger::getInstance().throwException(std::runtime_error("Strategies on " + feeds[i].source.ticker + " read " +
+					std::to_string(feeds[i].columns.size()) + " inputs, ticks carry at most " + std::to_string(MAX_TICK_VALUES)));
+			mSources[i].load(BarSource::find(dataDirectory, feeds[i].source.ticker, feeds[i].source.interval), feeds[i].columns);
+			mLongest = std::max(mLongest, mSources[i].rowCount());
+		}
+	}
+
+	bool FileReplayFeed::next(Tick& tick)
+	{
+		for (;;) {
+			if (mFeed == mSources.size()) {
+				mFeed = 0;
+				mBar++;
+			}
+			if (mBar >= mLongest)
+				return false;
+
+			const BarSource& source = mSources[mFeed++];
+			if (mBar >= source.rowCount())
+				continue;
+			tick.feed = mFeed - 1;
+			tick.bar = mBar;
+			const std::vector<const double*>& columns = source.columns();
+			for (size_t column = 0; column < columns.size(); ++column)
+				tick.values[column] = columns[column][mBar];
+			return true;
+		}
+	}
+
+	uint32_t LiveRunner::shardOf(const DataSource& source, uint32_t shardCount)
+	{
+		// FNV-1a, std::hash may differ between builds
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&](const std::string& text) {
+			for (unsigned char c : text)
+				hash = (hash ^ c) * 1099511628211ull;
+			hash = (hash ^ 0xff) * 1099511628211ull;
+		};
+		mix(source.ticker);
+		mix(source.interval);
+		return static_cast<uint32_t>(hash % shardCount);
+	}
+
+	const std::vector<LiveResult>& LiveRunner::run()
+	{
+		mResults.clear();
+		mLatencies.clear();
+		mTicks = 0;
+
+		const std::vector<Feed> feeds = groupFeeds(mInterpreter.strategies());
+		if (feeds.empty())
+			return mResults;
+
+		// Feed, shard and order threads each spin on a core of their own
+		const unsigned threads = std::thread::hardware_concurrency();
+		if (mWait == WaitMode::BusyPoll && threads < mShardCount + 2)
+			Logger::getInstance().logf(Logger::WARNING, "Busy polling %u shards with %u hardware threads, the pipeline's threads will take turns spinning",
+				mShardCount, threads);
+
+		// on_data() can't tier up once several shards run it
+		mInterpreter.tierUpAll();
+
+		FileReplayFeed replay(mDataDirectory, feeds);
+		if (mWait == WaitMode::BusyPoll)
+			runPipeline<BusyPollWait>(feeds, replay);
+		else
+			runPipeline<FutexWait>(feeds, replay);
+		return mResults;
+	}
+
+	namespace {
+		// Everything a shard keeps for one of its feeds
+		struct ShardFeed {
+			uint32_t feed = 0;
+			IndicatorGraph graph;
+			// Per strategy on the feed, views into the shard's blocks
+			std::vector<StrategyState> states;
+			std::vector<const JitCode*> jits;
+			std::vector<std::vector<double>> inputs;
+			// Merged into the runner's results once the shard has stopped
+			std::vector<LiveResult> results;
+		};
+
+		template <typename Wait>
+		struct Shard {
+			Shard() : ticks(LiveRunner::QUEUE_CAPACITY), signals(LiveRunner::QUEUE_CAPACITY) {}
+
+			SpscQueue<Tick, Wait> ticks;
+			// The order thread drains every shard's queue and waits on a doorbell shared by all of
+			// them instead of any one queue
+			SpscQueue<SignalEvent, BusyPollWait> signals;
+			std::vector<uint32_t> feeds;
+			std::vector<ShardFeed> state;
+			// The state of every instance of a strategy in the shard, one instance per feed it trades
+			std::vector<const Strategy*> blockStrategies;
+			std::vector<StateBlock> blocks;
+			// -1 when not pinned
+			int core = -1;
+			std::exception_ptr error;
+			std::thread thread;
+		};
+	}
+
+	template <typename Wait>
+	void LiveRunner::runPipeline(const std::vector<Feed>& feeds, FileReplayFeed& replay)
+	{
+		std::vector<uint32_t> firstResult;
+		for (const Feed& feed : feeds) {
+			firstResult.push_back(static_cast<uint32_t>(mResults.size()));
+			for (const Strategy* strategy : feed.strategies) {
+				LiveResult result;
+				result.strategy = strategy->name;
+				result.source = feed.source;
+				mResults.push_back(std::move(result));
+			}
+		}
+		std::vector<Signal> positions(mResults.size(), HOLD);
+		mLatencies.reserve(1 << 16);
+
+		// Feeds are partitioned by hash, slotOf is the feed's index in its shard's state
+		std::vector<std::unique_ptr<Shard<Wait>>> shards;
+		for (uint32_t i = 0; i < mShardCount; ++i)
+			shards.push_back(std::make_unique<Shard<Wait>>());
+		std::vector<uint32_t> shardOfFeed(feeds.size());
+		std::vector<uint32_t> slotOf(feeds.size());
+		for (uint32_t i = 0; i < feeds.size(); ++i) {
+			shardOfFeed[i] = shardOf(feeds[i].source, mShardCount);
+			slotOf[i] = static_cast<uint32_t>(shards[shardOfFeed[i]]->feeds.size());
+			shards[shardOfFeed[i]]->feeds.push_back(i);
+		}
+
+		// The first core is left to the feed thread
+		const std::vector<unsigned> cores = availableCores();
+		if (cores.size() > mShardCount) {
+			for (uint32_t i = 0; i < mShardCount; ++i)
+				shards[i]->core = static_cast<int>(cores[i + 1]);
+		}
+		else {
+			Logger::getInstance().logf(Logger::DEBUG, "Not pinning %u shards to %zu cores", mShardCount, cores.size());
+		}
+
+		Wait doorbell;
+		std::exception_ptr error;
+
+		Logger::getInstance().logf(Logger::INFO, "Running %zu strategy instances live on %zu feeds in %u shards, %s waits", mResults.size(), feeds.size(),
+			mShardCount, mWait == WaitMode::BusyPoll ? "busy poll" : "futex");
+		auto start = std::chrono::steady_clock::now();
+
+		for (std::unique_ptr<Shard<Wait>>& owned : shards) {
+			Shard<Wait>& shard = *owned;
+			shard.thread = std::thread([&] {
+				if (shard.core >= 0 && !pinCurrentThread(static_cast<unsigned>(shard.core)))
+					shard.core = -1;
+
+				VirtualMachine virtualMachine;
+				Tick tick;
+				try {
+					// Allocated on the shard's own thread so its pages are first touched on its core.
+					// Every state is in place before the graph binds to its indicators.
+					std::vector<size_t> instanceCounts;
+					for (uint32_t feed : shard.feeds) {
+						for (const Strategy* strategy : feeds[feed].strategies) {
+							const size_t block = static_cast<size_t>(std::find(shard.blockStrategies.begin(), shard.blockStrategies.end(), strategy) - shard.blockStrategies.begin());
+							if (block == shard.blockStrategies.size()) {
+								shard.blockStrategies.push_back(strategy);
+								instanceCounts.push_back(0);
+							}
+							instanceCounts[block]++;
+						}
+					}
+					for (size_t block = 0; block < shard.blockStrategies.size(); ++block)
+						shard.blocks.push_back(shard.blockStrategies[block]->newStates(instanceCounts[block]));
+
+					std::vector<size_t> nextInstance(shard.blocks.size());
+					shard.state.resize(shard.feeds.size());
+					for (size_t slot = 0; slot < shard.feeds.size(); ++slot) {
+						ShardFeed& local = shard.state[slot];
+						const Feed& feed = feeds[shard.feeds[slot]];
+						local.feed = shard.feeds[slot];
+						for (const Strategy* strategy : feed.strategies) {
+							const size_t block = static_cast<size_t>(std::find(shard.blockStrategies.begin(), shard.blockStrategies.end(), strategy) - shard.blockStrategies.begin());
+							local.states.push_back(shard.blocks[block].instance(nextInstance[block]++));
+							local.jits.push_back(mInterpreter.jitCode(*strategy));
+							local.inputs.emplace_back(strategy->inputs.size());
+						}
+						local.results.resize(feed.strategies.size());
+						for (size_t i = 0; i < feed.strategies.size(); ++i)
+							local.graph.addStrategy(feed.strategies[i]->compiled, feed.inputColumns[i], local.states[i].indicators);
+						local.graph.link();
+					}
+
+					while (shard.ticks.pop(tick)) {
+						ShardFeed& local = shard.state[slotOf[tick.feed]];
+						const Feed& feed = feeds[tick.feed];
+						local.graph.update(tick.values);
+
+						for (size_t i = 0; i < feed.strategies.size(); ++i) {
+							const std::vector<uint32_t>& inputColumns = feed.inputColumns[i];
+							double* values = local.inputs[i].data();
+							for (size_t input = 0; input < inputColumns.size(); ++input)
+								values[input] = tick.values[inputColumns[input]];
+
+							const Signal signal = Interpreter::execute(*feed.strategies[i], local.jits[i], local.states[i], virtualMachine, values);
+							LiveResult& result = local.results[i];
+							result.bars++;
+							result.signals[signal]++;
+							if (signal != HOLD) {
+								shard.signals.push({ firstResult[tick.feed] + static_cast<uint32_t>(i), tick.bar, signal, tick.enqueued });
+								doorbell.notify();
+							}
+						}
+					}
+				}
+				catch (...) {
+					// Drained so the feed thread never waits on a full queue
+					shard.error = std::current_exception();
+					while (shard.ticks.pop(tick)) {}
+				}
+				shard.signals.close();
+				doorbell.notify();
+			});
+		}
+
+		std::thread orderThread([&] {
+			auto ready = [&] {
+				bool drained = true;
+				for (const std::unique_ptr<Shard<Wait>>& shard : shards) {
+					if (!shard->signals.empty())
+						return true;
+					drained &= shard->signals.drained();
+				}
+				return drained;
+			};
+
+			SignalEvent event;
+			for (;;) {
+				bool popped = false;
+				for (std::unique_ptr<Shard<Wait>>& shard : shards) {
+					while (shard->signals.tryPop(event)) {
+						popped = true;
+						mLatencies.push_back(nowNanoseconds() - event.tickEnqueued);
+						if (event.signal != positions[event.strategy]) {
+							positions[event.strategy] = event.signal;
+							mResults[event.strategy].positionChanges++;
+						}
+					}
+				}
+				if (popped)
+					continue;
+				bool drained = true;
+				for (const std::unique_ptr<Shard<Wait>>& shard : shards)
+					drained &= shard->signals.drained();
+				if (drained)
+					break;
+				doorbell.waitUntil(ready);
+			}
+		});
+
+		// The calling thread is the feed thread
+		std::vector<uint64_t> shardTicks(mShardCount);
+		Tick tick;
+		int64_t deadline = nowNanoseconds();
+		while (replay.next(tick)) {
+			if (mPace != 0) {
+				deadline += static_cast<int64_t>(mPace);
+				waitUntil<Wait>(deadline);
+			}
+			const uint32_t shard = shardOfFeed[tick.feed];
+			tick.enqueued = nowNanoseconds();
+			shards[shard]->ticks.push(tick);
+			shardTicks[shard]++;
+			mTicks++;
+		}
+		for (std::unique_ptr<Shard<Wait>>& shard : shards)
+			shard->ticks.close();
+
+		for (std::unique_ptr<Shard<Wait>>& shard : shards)
+			shard->thread.join();
+		orderThread.join();
+		mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// Every shard counted its own feeds, nothing to reconcile
+		for (uint32_t i = 0; i < mShardCount; ++i) {
+			Shard<Wait>& shard = *shards[i];
+			if (shard.error && !error)
+				error = shard.error;
+			for (const ShardFeed& local : shard.state) {
+				for (size_t j = 0; j < local.results.size(); ++j) {
+					LiveResult& result = mResults[firstResult[local.feed] + j];
+					result.bars = local.results[j].bars;
+					std::copy(std::begin(local.results[j].signals), std::end(local.results[j].signals), result.signals);
+				}
+			}
+			if (shard.core >= 0)
+				Logger::getInstance().logf(Logger::DEBUG, "Shard %u on core %d: %zu feeds, %llu ticks", i, shard.core, shard.feeds.size(),
+					static_cast<unsigned long long>(shardTicks[i]));
+			else
+				Logger::getInstance().logf(Logger::DEBUG, "Shard %u: %zu feeds, %llu ticks", i, shard.feeds.size(),
+					static_cast<unsigned long long>(shardTicks[i]));
+		}
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	void LiveRunner::printResults() const
+	{
+		for (const LiveResult& result : mResults) {
+			std::cout << symbolName(result.strategy) << " " << result.source.ticker;
+			if (!result.source.interval.empty())
+				std::cout << " (" << result.source.interval << ")";
+			std::cout << ": " << result.bars << " bars, " << result.signals[BUY] << " buy / " << result.signals[HOLD] << " hold / "
+				<< result.signals[SELL] << " sell, " << result.positionChanges << " position changes\n";
+		}
+		if (mSeconds > 0.0)
+			Logger::getInstance().logf(Logger::INFO, "Replayed %llu ticks in %.3f ms (%.1f K ticks/s)", static_cast<unsigned long long>(mTicks),
+				mSeconds * 1e3, static_cast<double>(mTicks) / mSeconds / 1e3);
+		if (mLatencies.empty())
+			return;
+
+		std::vector<int64_t> sorted = mLatencies;
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&](double fraction) {
+			return static_cast<double>(sorted[static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1))]) / 1e3;
+		};
+		Logger::getInstance().logf(Logger::INFO, "Tick to signal latency over %zu signals: p50 %.1f us, p99 %.1f us, max %.1f us",
+			sorted.size(), percentile(0.5), percentile(0.99), percentile(1.0));
+	}
+}
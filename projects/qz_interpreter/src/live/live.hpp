@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <quartz/data/barSource.hpp>
+#include <quartz/live/spscQueue.hpp>
+#include <quartz/vm/indicatorGraph.hpp>
+
+#include "../interpreter.hpp"
+
+namespace Quartz {
+	// Columns a tick carries, every input the strategies on one feed read has to fit
+	constexpr size_t MAX_TICK_VALUES = 8;
+
+	// One bar of one feed, on its way from the feed thread to the feed's shard
+	struct Tick {
+		uint32_t feed;
+		uint64_t bar;
+		// steady_clock time the tick was pushed, in nanoseconds
+		int64_t enqueued;
+		// The feed's columns, in the order of Feed::columns
+		double values[MAX_TICK_VALUES];
+	};
+
+	// A BUY or SELL, on its way from a shard to the order thread
+	struct SignalEvent {
+		// Index of the strategy's LiveResult
+		uint32_t strategy;
+		uint64_t bar;
+		Signal signal;
+		int64_t tickEnqueued;
+	};
+
+	enum class WaitMode {
+		BusyPoll,
+		Futex
+	};
+
+	// What one strategy did over one feed
+	struct LiveResult {
+		Symbol strategy = INVALID_SYMBOL;
+		DataSource source;
+		// Counted by the feed's shard, indexed by Signal
+		uint64_t bars = 0;
+		uint64_t signals[3] = {};
+		// Counted by the order thread
+		uint64_t positionChanges = 0;
+	};
+
+	// Stand-in for a market data connection: replays local bar files (see data/barSource.hpp) as
+	// ticks, one bar of every feed in turn, so feeds interleave the way live ones would
+	class FileReplayFeed {
+	public:
+		FileReplayFeed(const std::string& dataDirectory, const std::vector<Feed>& feeds);
+
+		// Fills the next tick except for its enqueue time, false once every file has been replayed
+		bool next(Tick& tick);
+
+	private:
+		std::vector<BarSource> mSources;
+		uint64_t mBar = 0;
+		uint32_t mFeed = 0;
+		uint64_t mLongest = 0;
+	};
+
+	// Live execution, split over threads connected by wait free SPSC queues (see live/spscQueue.hpp),
+	// so no thread ever takes a lock:
+	//
+	//   feed thread      pushes ticks from a FileReplayFeed, optionally paced, to the ingress queue
+	//                    of the shard that owns the tick's feed
+	//   shard threads    each owns a hash partition of the feeds: their IndicatorGraphs and a
+	//                    StateBlock per strategy holding its instance on every such feed, so no state
+	//                    is shared between cores. Runs on_data() for every tick it pops and pushes
+	//                    every BUY and SELL to its own egress queue. Pinned to a core of their own
+	//                    when there are enough.
+	//   order thread     drains every shard's egress queue, tracks positions and the latency from
+	//                    tick enqueue to signal dequeue
+	//
+	// The wait mode decides how shards and the order thread wait for work: busy polling needs a core
+	// per thread, futex waits park the thread when its queues stay empty.
+	class LiveRunner {
+	public:
+		static constexpr size_t QUEUE_CAPACITY = 4096;
+
+		// pace is the time between ticks in nanoseconds, 0 replays as fast as the strategies keep up
+		LiveRunner(Interpreter& interpreter, std::string dataDirectory, WaitMode wait, uint64_t pace, uint32_t shardCount = 1)
+			: mInterpreter(interpreter), mDataDirectory(std::move(dataDirectory)), mWait(wait), mPace(pace), mShardCount(std::max(shardCount, 1u)) {}
+
+		// Replays every feed until its files run out
+		const std::vector<LiveResult>& run();
+
+		void printResults() const;
+
+		// Shard that owns a feed, stable across runs so a symbol always lands on the same shard
+		static uint32_t shardOf(const DataSource& source, uint32_t shardCount);
+
+	private:
+		Interpreter& mInterpreter;
+		std::string mDataDirectory;
+		WaitMode mWait;
+		uint64_t mPace;
+		uint32_t mShardCount;
+
+		std::vector<LiveResult> mResults;
+		// Tick enqueue to signal dequeue of every signal, in nanoseconds
+		std::vector<int64_t> mLatencies;
+		uint64_t mTicks = 0;
+		double mSeconds = 0.0;
+
+		template <typename Wait>
+		void runPipeline(const std::vector<Feed>& feeds, FileReplayFeed& replay);
+	};
+}
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -5,15 +6,29 @@
 #include <quartz/parser/abstractSyntaxTree.hpp>
 #include <quartz/quartz.hpp>
 
+#include "backtest/backtest.hpp"
 #include "interpreter.hpp"
+#include "live/live.hpp"
+#include "sweep/sweep.hpp"
 
 int main(int argc, char* argv[]) {
     std::string filename;
     std::string code;
+    std::string outputLibrary;
+    std::string nativeLibrary;
+    std::string backtestDirectory;
+    std::string liveDirectory;
+    Quartz::WaitMode waitMode = Quartz::WaitMode::Futex;
+    uint64_t paceMicroseconds = 0;
+    uint32_t shardCount = 1;
+    std::vector<std::string> sweeps;
+    unsigned sweepThreads = 0;
     bool verbose = false;
+    bool printStatus = false;
+    uint64_t jitThreshold = Quartz::Interpreter::DEFAULT_JIT_THRESHOLD;
 
     if (argc < 2) {
-        Quartz::Logger::getInstance().logf(Quartz::Logger::ERROR, "Usage: %s (-f <filename> | -c <code>) [-v]", argv[0]);
+        Quartz::Logger::getInstance().logf(Quartz::Logger::ERROR, "Usage: %s (-f <filename> | -c <code> | -l <library>) [-o <library>] [--backtest <directory>] [--live <directory> [--wait busy|futex] [--pace <microseconds>] [--shards <count>]] [--sweep <const>=<start>:<end>:<step>... [--threads <count>]] [-j <calls>|off] [-s] [-v]", argv[0]);
         return 1;
     }
 
@@ -38,6 +53,114 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
         }
+        else if (arg == "-o") {
+            if (i + 1 < argc) {
+                outputLibrary = argv[++i];
+            }
+            else {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "-o requires an output library");
+                return 1;
+            }
+        }
+        else if (arg == "-l") {
+            if (i + 1 < argc) {
+                nativeLibrary = argv[++i];
+            }
+            else {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "-l requires a compiled library");
+                return 1;
+            }
+        }
+        else if (arg == "--backtest") {
+            if (i + 1 < argc) {
+                backtestDirectory = argv[++i];
+            }
+            else {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--backtest requires a data directory");
+                return 1;
+            }
+        }
+        else if (arg == "--live") {
+            if (i + 1 < argc) {
+                liveDirectory = argv[++i];
+            }
+            else {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--live requires a data directory");
+                return 1;
+            }
+        }
+        else if (arg == "--wait") {
+            std::string value = i + 1 < argc ? argv[++i] : "";
+            if (value == "busy") {
+                waitMode = Quartz::WaitMode::BusyPoll;
+            }
+            else if (value == "futex") {
+                waitMode = Quartz::WaitMode::Futex;
+            }
+            else {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--wait requires busy or futex");
+                return 1;
+            }
+        }
+        else if (arg == "--pace") {
+            std::string value = i + 1 < argc ? argv[++i] : "";
+            char* end = nullptr;
+            paceMicroseconds = std::strtoull(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0') {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--pace requires microseconds between ticks");
+                return 1;
+            }
+        }
+        else if (arg == "--shards") {
+            std::string value = i + 1 < argc ? argv[++i] : "";
+            char* end = nullptr;
+            const unsigned long count = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || count == 0 || count > 4096) {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--shards requires a worker thread count between 1 and 4096");
+                return 1;
+            }
+            shardCount = static_cast<uint32_t>(count);
+        }
+        else if (arg == "--sweep") {
+            if (i + 1 < argc) {
+                sweeps.push_back(argv[++i]);
+            }
+            else {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--sweep requires <const>=<start>:<end>:<step>");
+                return 1;
+            }
+        }
+        else if (arg == "--threads") {
+            std::string value = i + 1 < argc ? argv[++i] : "";
+            char* end = nullptr;
+            const unsigned long count = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || count > 4096) {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--threads requires a thread count, 0 for every hardware thread");
+                return 1;
+            }
+            sweepThreads = static_cast<unsigned>(count);
+        }
+        else if (arg == "-j") {
+            if (i + 1 >= argc) {
+                Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "-j requires a call count or off");
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (value == "off") {
+                jitThreshold = Quartz::Interpreter::JIT_DISABLED;
+            }
+            else {
+                char* end = nullptr;
+                jitThreshold = std::strtoull(value.c_str(), &end, 10);
+                if (value.empty() || *end != '\0') {
+                    Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "-j requires a call count or off");
+                    return 1;
+                }
+            }
+        }
+        else if (arg == "-s") {
+            printStatus = true;
+        }
         else if (arg == "-v") {
             verbose = true;
         }
@@ -52,20 +175,80 @@ int main(int argc, char* argv[]) {
         Quartz::Logger::getInstance().log(Quartz::Logger::INFO, "Verbose logging mode enabled");
     }
 
-    std::shared_ptr<Quartz::ProgramNode> program;
-    if (!filename.empty()) {
-        program = Quartz::run_file(filename.c_str());
+    if (filename.empty() && code.empty() && nativeLibrary.empty()) {
+        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "No filename, code or library provided");
+        return 1;
     }
-    else if (!code.empty()) {
-        program = Quartz::run_code(code.c_str());
+
+    if (!nativeLibrary.empty() && !outputLibrary.empty()) {
+        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "-o needs a source program, not a compiled library");
+        return 1;
     }
-    else {
-        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "No filename or code provided");
+
+    if (!backtestDirectory.empty() && !outputLibrary.empty()) {
+        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--backtest can't be combined with -o");
         return 1;
     }
 
-    Quartz::Interpreter interpreter = Quartz::Interpreter(program);
-    interpreter.interpret();
+    if (!liveDirectory.empty() && !outputLibrary.empty()) {
+        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--live can't be combined with -o");
+        return 1;
+    }
+
+    if (!sweeps.empty() && (backtestDirectory.empty() || !liveDirectory.empty() || !outputLibrary.empty() || !nativeLibrary.empty())) {
+        Quartz::Logger::getInstance().log(Quartz::Logger::ERROR, "--sweep needs a source program and --backtest <directory>, without --live, -o or -l");
+        return 1;
+    }
+
+    auto run = [&](Quartz::Interpreter& interpreter) {
+        interpreter.interpret();
+        if (!backtestDirectory.empty()) {
+            Quartz::Backtester backtester(interpreter, backtestDirectory);
+            backtester.run();
+            backtester.printResults();
+        }
+        if (!liveDirectory.empty()) {
+            Quartz::LiveRunner live(interpreter, liveDirectory, waitMode, paceMicroseconds * 1000, shardCount);
+            live.run();
+            live.printResults();
+        }
+        if (printStatus)
+            interpreter.printStatus();
+    };
+
+    // Errors are logged by the Logger before they are thrown
+    try {
+        if (!nativeLibrary.empty()) {
+            Quartz::Interpreter interpreter = Quartz::Interpreter(Quartz::NativeLibrary::open(nativeLibrary));
+            run(interpreter);
+            return 0;
+        }
+
+        std::shared_ptr<Quartz::ProgramNode> program = !filename.empty()
+            ? Quartz::run_file(filename.c_str())
+            : Quartz::run_code(code.c_str());
+
+        if (!sweeps.empty()) {
+            std::vector<Quartz::SweepParameter> parameters;
+            for (const std::string& sweep : sweeps)
+                parameters.push_back(Quartz::SweepParameter::parse(sweep));
+            Quartz::SweepRunner sweep(program, std::move(parameters), backtestDirectory, sweepThreads, jitThreshold);
+            sweep.run();
+            sweep.printResults();
+            return 0;
+        }
+
+        Quartz::Interpreter interpreter = Quartz::Interpreter(program);
+        interpreter.setJitThreshold(jitThreshold);
+        if (!outputLibrary.empty()) {
+            interpreter.compile(outputLibrary);
+            return 0;
+        }
+        run(interpreter);
+    }
+    catch (const std::exception&) {
+        return 1;
+    }
 
     return 0;
 }
\ No newline at end of file
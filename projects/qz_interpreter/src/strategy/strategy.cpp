@@ -0,0 +1,42 @@
+#include "strategy.hpp"
+
+#include <algorithm>
+
+#include <quartz/logging/logging.hpp>
+
+namespace Quartz {
+	std::vector<Feed> groupFeeds(const std::vector<std::unique_ptr<const Strategy>>& strategies)
+	{
+		std::vector<Feed> feeds;
+		for (const std::unique_ptr<const Strategy>& strategy : strategies) {
+			if (strategy->dataSources.empty()) {
+				Logger::getInstance().logf(Logger::WARNING, "Strategy %s has no data sources, nothing to run", std::string(symbolName(strategy->name)).c_str());
+				continue;
+			}
+			for (const DataSource& source : strategy->dataSources) {
+				auto feed = std::find_if(feeds.begin(), feeds.end(), [&](const Feed& existing) {
+					return existing.source.ticker == source.ticker && existing.source.interval == source.interval;
+				});
+				if (feed == feeds.end())
+					feed = feeds.insert(feeds.end(), Feed{ source, {}, {}, {} });
+				// Adding a source twice would run on_data() twice a bar on the same state
+				if (std::find(feed->strategies.begin(), feed->strategies.end(), strategy.get()) != feed->strategies.end()) {
+					Logger::getInstance().logf(Logger::WARNING, "Strategy %s added data source %s (%s) more than once, running it once",
+						std::string(symbolName(strategy->name)).c_str(), source.ticker.c_str(), source.interval.c_str());
+					continue;
+				}
+
+				std::vector<uint32_t> inputColumns;
+				for (Symbol input : strategy->inputs) {
+					auto column = std::find(feed->columns.begin(), feed->columns.end(), input);
+					if (column == feed->columns.end())
+						column = feed->columns.insert(feed->columns.end(), input);
+					inputColumns.push_back(static_cast<uint32_t>(column - feed->columns.begin()));
+				}
+				feed->strategies.push_back(strategy.get());
+				feed->inputColumns.push_back(std::move(inputColumns));
+			}
+		}
+		return feeds;
+	}
+}
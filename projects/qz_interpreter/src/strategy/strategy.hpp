@@ -1,43 +1,59 @@
 #pragma once
-#include <unordered_map>
-#include <any>
 
-#include <quartz/parser/abstractSyntaxTree.hpp>
+#include <quartz/vm/builtins.hpp>
+#include <quartz/vm/nativeLibrary.hpp>
+#include <quartz/vm/stateBlock.hpp>
 
 namespace Quartz {
-	enum VariableType {
-		String,
-		Float,
-		Integer
-	};
-
-	struct Variable {
-	public:
-		Variable() = default;
-
-		Variable(int integer) { type = Integer; data = integer; }
-		Variable(float _float) { type = Float; data = _float; }
-		Variable(std::string string) { type = String; data = string; }
-
-		VariableType type;
-
-		int getInteger() { return std::any_cast<int>(data); };
-		float getFloat() { return std::any_cast<float>(data); };
-		std::string getString() { return std::any_cast<std::string>(data); };
-
-	private:
-		std::any data;
+	enum class ExecutionTier {
+		Interpreted,
+		Jit,
+		Native
 	};
 
+	// A loaded strategy: its bytecode or native code, the data sources init() added and the frame
+	// it left, and the layout of a per instance state. Nothing here changes once init() has run, so
+	// one Strategy is shared read only by every instance running it, whichever thread they are on.
+	// The execution tier and the single threaded modes' instance are kept by the Interpreter.
 	class Strategy {
 	public:
-		std::string name = "";
-		std::unique_ptr<StrategyInitNode> initNode = nullptr;
-		std::unique_ptr<StrategyOnDataNode> onDataNode = nullptr;
-
-		std::unordered_map<std::string, std::unique_ptr<FunctionDeclNode>> functionNodes;
-		std::unordered_map<std::string, Variable> constants;
+		Symbol name = INVALID_SYMBOL;
+		// Position in Interpreter::strategies()
+		uint32_t index = 0;
+
+		// Bytecode for init() and on_data(), executed by the VirtualMachine
+		CompiledStrategy compiled;
+		// Set instead of the bytecode when the strategy was loaded from a compiled library
+		std::shared_ptr<NativeLibrary> library = nullptr;
+		const QuartzStrategyDescriptor* native = nullptr;
+
+		// Input variables in the order on_data() expects their values
+		std::vector<Symbol> inputs;
+		// Data sources registered when init() ran
+		std::vector<DataSource> dataSources;
+
+		// Sizes of every instance's state
+		std::shared_ptr<const StateLayout> layout = nullptr;
+		// The frame as init() left it, every instance starts from a copy
+		std::vector<RawValue> initialFrame;
+
+		// count instances with fresh indicator state and empty histories
+		StateBlock newStates(size_t count) const {
+			return StateBlock(layout, count, initialFrame.empty() ? nullptr : initialFrame.data());
+		}
+	};
 
-		Strategy() = default;
+	// A data source and every strategy that added it
+	struct Feed {
+		DataSource source;
+		std::vector<const Strategy*> strategies;
+		// Every input any of the strategies reads, each loaded once
+		std::vector<Symbol> columns;
+		// Per strategy, the column of each of its inputs
+		std::vector<std::vector<uint32_t>> inputColumns;
 	};
+
+	// Groups strategies by the sources they added, in the order the sources were first added.
+	// Strategies without a source are skipped with a warning, a source added twice is only run once.
+	std::vector<Feed> groupFeeds(const std::vector<std::unique_ptr<const Strategy>>& strategies);
 }
\ No newline at end of file
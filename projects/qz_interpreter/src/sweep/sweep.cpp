@@ -0,0 +1,300 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include <quartz/data/barSource.hpp>
+#include <quartz/logging/logging.hpp>
+#include <quartz/utils/workStealingPool.hpp>
+
+namespace Quartz {
+	namespace {
+		bool parseInteger(const std::string& text, int64_t& value) {
+			char* end = nullptr;
+			value = std::strtoll(text.c_str(), &end, 10);
+			return !text.empty() && *end == '\0';
+		}
+
+		bool parseFloat(const std::string& text, double& value) {
+			char* end = nullptr;
+			value = std::strtod(text.c_str(), &end);
+			return !text.empty() && *end == '\0' && std::isfinite(value);
+		}
+
+		// Buys on BUY and sells on SELL at prices, a position still open is valued at the last bar
+		double tradeReturn(const std::vector<SignalChange>& changes, const double* prices, uint64_t barCount, uint64_t& trades) {
+			double equity = 1.0;
+			double entry = 0.0;
+			bool holding = false;
+			for (const SignalChange& change : changes) {
+				if (change.signal == BUY && !holding) {
+					entry = prices[change.bar];
+					holding = true;
+				}
+				else if (change.signal == SELL && holding) {
+					equity *= prices[change.bar] / entry;
+					holding = false;
+					trades++;
+				}
+			}
+			if (holding && barCount > 0)
+				equity *= prices[barCount - 1] / entry;
+			return equity - 1.0;
+		}
+
+		// A data source every combination reads from, loaded once with every column any of them needs
+		struct SharedSource {
+			DataSource source;
+			std::vector<Symbol> columns;
+			BarSource bars;
+			bool loaded = false;
+		};
+
+		// Combinations instantiated at once, at around 10 KB an Interpreter this bounds a sweep's
+		// memory while leaving every worker plenty of tasks to steal
+		constexpr size_t SWEEP_BATCH = 1024;
+	}
+
+	SweepParameter SweepParameter::parse(const std::string& text)
+	{
+		auto fail = [&](const std::string& reason) {
+			Logger::getInstance().throwException(std::runtime_error("Bad sweep " + text + ", " + reason));
+		};
+
+		const size_t equals = text.find('=');
+		const size_t first = text.find(':', equals);
+		const size_t second = first == std::string::npos ? std::string::npos : text.find(':', first + 1);
+		if (equals == 0 || equals == std::string::npos || second == std::string::npos)
+			fail("expected name=start:end:step");
+		const std::string start = text.substr(equals + 1, first - equals - 1);
+		const std::string end = text.substr(first + 1, second - first - 1);
+		const std::string step = text.substr(second + 1);
+
+		SweepParameter parameter;
+		parameter.name = intern(std::string_view(text).substr(0, equals));
+
+		int64_t integers[3];
+		if (parseInteger(start, integers[0]) && parseInteger(end, integers[1]) && parseInteger(step, integers[2])) {
+			const int64_t distance = integers[1] - integers[0];
+			if (integers[2] == 0 || (distance != 0 && (distance > 0) != (integers[2] > 0)))
+				fail("the step doesn't lead from start to end");
+			const uint64_t count = static_cast<uint64_t>(distance / integers[2]) + 1;
+			if (count > SweepRunner::MAX_COMBINATIONS)
+				fail("more than " + std::to_string(SweepRunner::MAX_COMBINATIONS) + " values");
+			for (uint64_t i = 0; i < count; ++i)
+				parameter.values.emplace_back(static_cast<int64_t>(integers[0] + static_cast<int64_t>(i) * integers[2]));
+			return parameter;
+		}
+
+		double floats[3];
+		if (!parseFloat(start, floats[0]) || !parseFloat(end, floats[1]) || !parseFloat(step, floats[2]))
+			fail("start, end and step have to be numbers");
+		const double steps = (floats[1] - floats[0]) / floats[2];
+		if (floats[2] == 0.0 || steps < 0.0)
+			fail("the step doesn't lead from start to end");
+		if (steps >= static_cast<double>(SweepRunner::MAX_COMBINATIONS))
+			fail("more than " + std::to_string(SweepRunner::MAX_COMBINATIONS) + " values");
+		// Multiples of the step rather than repeated adds, and end is kept despite rounding
+		const uint64_t count = static_cast<uint64_t>(std::floor(steps + 1e-9)) + 1;
+		for (uint64_t i = 0; i < count; ++i)
+			parameter.values.emplace_back(floats[0] + static_cast<double>(i) * floats[2]);
+		return parameter;
+	}
+
+	size_t SweepRunner::combinationCount() const
+	{
+		size_t count = 1;
+		for (const SweepParameter& parameter : mParameters) {
+			if (parameter.values.empty() || count > MAX_COMBINATIONS / parameter.values.size())
+				return parameter.values.empty() ? 0 : MAX_COMBINATIONS + 1;
+			count *= parameter.values.size();
+		}
+		return count;
+	}
+
+	std::vector<Value> SweepRunner::combination(size_t index) const
+	{
+		// The last parameter changes fastest
+		std::vector<Value> values(mParameters.size());
+		for (size_t i = mParameters.size(); i-- > 0;) {
+			values[i] = mParameters[i].values[index % mParameters[i].values.size()];
+			index /= mParameters[i].values.size();
+		}
+		return values;
+	}
+
+	const std::vector<SweepResult>& SweepRunner::run()
+	{
+		mResults.clear();
+		mBars = 0;
+
+		const size_t count = combinationCount();
+		if (count == 0 || count > MAX_COMBINATIONS)
+			Logger::getInstance().throwException(std::runtime_error("A sweep runs between 1 and " + std::to_string(MAX_COMBINATIONS) + " combinations"));
+
+		// Only a batch of combinations is instantiated at a time, each Interpreter is freed as soon as
+		// its backtest is done and only its result rows are kept. Every combination gets its own
+		// compiled strategies from the one checked program.
+		std::shared_ptr<const FlatAST> checked = check_program(mProgram);
+		std::vector<SharedSource> sources;
+		const Symbol price = intern("price");
+		const Symbol close = intern("close");
+		WorkStealingPool pool(mThreads);
+		Logger::getInstance().logf(Logger::INFO, "Sweeping %zu combinations on %u threads", count, pool.threadCount());
+
+		std::vector<std::unique_ptr<Interpreter>> interpreters;
+		std::vector<std::vector<Feed>> feeds;
+		std::vector<std::vector<uint32_t>> sourceOf;
+		std::vector<std::vector<SweepResult>> results;
+		mSeconds = 0.0;
+		for (size_t begin = 0; begin < count; begin += SWEEP_BATCH) {
+			const size_t batch = std::min(SWEEP_BATCH, count - begin);
+			interpreters.clear();
+			feeds.clear();
+			sourceOf.assign(batch, {});
+			results.assign(batch, {});
+
+			for (size_t i = 0; i < batch; ++i) {
+				std::vector<ConstOverride> overrides;
+				const std::vector<Value> values = combination(begin + i);
+				for (size_t j = 0; j < mParameters.size(); ++j)
+					overrides.push_back({ mParameters[j].name, values[j] });
+
+				interpreters.push_back(std::make_unique<Interpreter>(specialise_program(*checked, overrides)));
+				interpreters.back()->setJitThreshold(mJitThreshold);
+				interpreters.back()->interpret();
+				feeds.push_back(groupFeeds(interpreters.back()->strategies()));
+
+				for (const Feed& feed : feeds.back()) {
+					auto shared = std::find_if(sources.begin(), sources.end(), [&](const SharedSource& existing) {
+						return existing.source.ticker == feed.source.ticker && existing.source.interval == feed.source.interval;
+					});
+					if (shared == sources.end())
+						shared = sources.insert(sources.end(), SharedSource{ feed.source, {}, {}, false });
+					for (Symbol column : feed.columns) {
+						if (std::find(shared->columns.begin(), shared->columns.end(), column) == shared->columns.end()) {
+							shared->columns.push_back(column);
+							shared->loaded = false;
+						}
+					}
+					sourceOf[i].push_back(static_cast<uint32_t>(shared - sources.begin()));
+				}
+			}
+
+			// Bar files are mapped, every worker reads the same pages. A source is only loaded again
+			// when a batch needs a column the earlier ones didn't.
+			for (SharedSource& shared : sources) {
+				if (!shared.loaded)
+					shared.bars.load(BarSource::find(mDataDirectory, shared.source.ticker, shared.source.interval), shared.columns);
+				shared.loaded = true;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			pool.run(batch, [&](size_t task, unsigned) {
+				Interpreter& interpreter = *interpreters[task];
+				Backtester backtester(interpreter, mDataDirectory);
+				std::vector<SweepResult>& rows = results[task];
+				for (const std::unique_ptr<const Strategy>& strategy : interpreter.strategies()) {
+					SweepResult row;
+					row.combination = begin + task;
+					row.strategy = strategy->name;
+					rows.push_back(row);
+				}
+				// Returns are summed here and averaged below
+				std::vector<uint32_t> pricedSources(rows.size());
+
+				std::vector<const double*> columns;
+				for (size_t i = 0; i < feeds[task].size(); ++i) {
+					const Feed& feed = feeds[task][i];
+					const SharedSource& shared = sources[sourceOf[task][i]];
+					columns.clear();
+					const double* prices = nullptr;
+					for (Symbol column : feed.columns) {
+						const size_t sharedColumn = static_cast<size_t>(std::find(shared.columns.begin(), shared.columns.end(), column) - shared.columns.begin());
+						columns.push_back(shared.bars.columns()[sharedColumn]);
+						if (column == price || (column == close && !prices))
+							prices = columns.back();
+					}
+
+					const size_t first = backtester.results().size();
+					backtester.replay(feed, columns, shared.bars.rowCount());
+					for (size_t j = first; j < backtester.results().size(); ++j) {
+						const BacktestResult& result = backtester.results()[j];
+						const size_t row = static_cast<size_t>(std::find_if(rows.begin(), rows.end(), [&](const SweepResult& candidate) {
+							return candidate.strategy == result.strategy;
+						}) - rows.begin());
+						rows[row].bars += result.bars;
+						rows[row].positionChanges += result.changes.size();
+						if (prices) {
+							rows[row].totalReturn += tradeReturn(result.changes, prices, result.bars, rows[row].trades);
+							pricedSources[row]++;
+						}
+					}
+				}
+				for (size_t row = 0; row < rows.size(); ++row)
+					rows[row].totalReturn = pricedSources[row] ? rows[row].totalReturn / pricedSources[row] : std::nan("");
+				// The rows are all that's kept, the backtester doesn't touch the interpreter again
+				interpreters[task].reset();
+			});
+			mSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			for (std::vector<SweepResult>& rows : results) {
+				for (SweepResult& row : rows) {
+					mBars += row.bars;
+					mResults.push_back(row);
+				}
+			}
+		}
+		return mResults;
+	}
+
+	void SweepRunner::printResults(size_t count) const
+	{
+		std::vector<const SweepResult*> ranked;
+		for (const SweepResult& result : mResults)
+			ranked.push_back(&result);
+		std::stable_sort(ranked.begin(), ranked.end(), [](const SweepResult* left, const SweepResult* right) {
+			if (std::isnan(left->totalReturn) || std::isnan(right->totalReturn))
+				return !std::isnan(left->totalReturn) && std::isnan(right->totalReturn);
+			return left->totalReturn > right->totalReturn;
+		});
+
+		// The strategy column is only worth its width when there's more than one
+		bool strategies = false;
+		for (const SweepResult& result : mResults)
+			strategies |= result.strategy != mResults.front().strategy;
+
+		std::vector<int> widths;
+		std::printf("%4s", "rank");
+		if (strategies)
+			std::printf("  %-20s", "strategy");
+		for (const SweepParameter& parameter : mParameters) {
+			widths.push_back(std::max(8, static_cast<int>(symbolName(parameter.name).size())));
+			std::printf("  %*s", widths.back(), std::string(symbolName(parameter.name)).c_str());
+		}
+		std::printf("  %9s  %6s  %7s\n", "return", "trades", "changes");
+
+		for (size_t i = 0; i < std::min(count, ranked.size()); ++i) {
+			const SweepResult& result = *ranked[i];
+			std::printf("%4zu", i + 1);
+			if (strategies)
+				std::printf("  %-20s", std::string(symbolName(result.strategy)).c_str());
+			const std::vector<Value> values = combination(result.combination);
+			for (size_t j = 0; j < values.size(); ++j)
+				std::printf("  %*s", widths[j], values[j].toString().c_str());
+			if (std::isnan(result.totalReturn))
+				std::printf("  %9s", "-");
+			else
+				std::printf("  %+8.2f%%", result.totalReturn * 100.0);
+			std::printf("  %6llu  %7llu\n", static_cast<unsigned long long>(result.trades), static_cast<unsigned long long>(result.positionChanges));
+		}
+		if (ranked.size() > count)
+			std::printf("(%zu more)\n", ranked.size() - count);
+
+		if (mSeconds > 0.0)
+			Logger::getInstance().logf(Logger::INFO, "Swept %zu combinations, %llu bars in %.3f ms (%.1f M bars/s)", combinationCount(),
+				static_cast<unsigned long long>(mBars), mSeconds * 1e3, static_cast<double>(mBars) / mSeconds / 1e6);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <quartz/quartz.hpp>
+
+#include "../backtest/backtest.hpp"
+
+namespace Quartz {
+	// A const swept over start, start + step, ... up to and including end. Integer consts take
+	// integer ranges, float consts either.
+	struct SweepParameter {
+		Symbol name = INVALID_SYMBOL;
+		std::vector<Value> values;
+
+		// From name=start:end:step
+		static SweepParameter parse(const std::string& text);
+	};
+
+	// One strategy over every data source it added, for one combination of parameter values
+	struct SweepResult {
+		// Index of the combination, values in SweepRunner::combination()
+		size_t combination = 0;
+		Symbol strategy = INVALID_SYMBOL;
+		uint64_t bars = 0;
+		uint64_t positionChanges = 0;
+		// Completed buy to sell round trips
+		uint64_t trades = 0;
+		// Of buying on BUY and selling on SELL at the price (or close) input, averaged over the data
+		// sources. NaN when the strategy has no such input.
+		double totalReturn = 0.0;
+	};
+
+	// Backtests every combination of the swept consts. The program is parsed and type checked once,
+	// each combination only folds consts and compiles its own copy (see specialise_program()), and
+	// runs in its own Interpreter so combinations share nothing that changes. Every data source is
+	// loaded once and read in place by all of them, the backtests run on a WorkStealingPool.
+	class SweepRunner {
+	public:
+		// Past this the grid is almost certainly a typo in a step
+		static constexpr size_t MAX_COMBINATIONS = 1'000'000;
+
+		// threads is 0 for every hardware thread
+		SweepRunner(std::shared_ptr<ProgramNode> program, std::vector<SweepParameter> parameters, std::string dataDirectory,
+			unsigned threads, uint64_t jitThreshold)
+			: mProgram(std::move(program)), mParameters(std::move(parameters)), mDataDirectory(std::move(dataDirectory)),
+			mThreads(threads), mJitThreshold(jitThreshold) {}
+
+		const std::vector<SweepResult>& run();
+
+		// The best combinations first, combinations without a return last
+		void printResults(size_t count = 10) const;
+
+		// Value of every parameter in a combination
+		std::vector<Value> combination(size_t index) const;
+		size_t combinationCount() const;
+
+	private:
+		std::shared_ptr<ProgramNode> mProgram;
+		std::vector<SweepParameter> mParameters;
+		std::string mDataDirectory;
+		unsigned mThreads;
+		uint64_t mJitThreshold;
+
+		std::vector<SweepResult> mResults;
+		uint64_t mBars = 0;
+		double mSeconds = 0.0;
+	};
+}
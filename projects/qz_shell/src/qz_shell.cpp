@@ -209,12 +209,22 @@ std::string readLine() {
 
 // Executes a Quartz command.
 void executeQuartzCommand(const std::string & command) {
-    Quartz::run_code(command.c_str());
+    try {
+        Quartz::run_code(command.c_str());
+    }
+    catch (const std::exception&) {
+        // Already reported by the Logger, keep the shell running
+    }
 }
 
 // Executes a Quartz file.
 void executeQuartzFile(const std::string & filename) {
-    Quartz::run_file(filename.c_str());
+    try {
+        Quartz::run_file(filename.c_str());
+    }
+    catch (const std::exception&) {
+        // Already reported by the Logger, keep the shell running
+    }
 }
 
 // Prints the shell header.